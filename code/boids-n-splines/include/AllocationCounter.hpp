@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+namespace bns
+{
+    // Number of calls to the global operator new (and new[]) made by any
+    // thread since the program started. Counted by replacing the global
+    // allocation functions, so it only works in targets that link
+    // AllocationCounter.cpp.
+    std::uint64_t getHeapAllocationCount();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atlas/math/Math.hpp>
+
+#include <cstdint>
+
+namespace bns
+{
+
+    class Boid
+    {
+    public:
+    Boid()
+    {
+        mPosition = atlas::math::Vector(0,0,0);
+        mVelocity = atlas::math::Vector(0,0,0);
+        mForward = normalize(mVelocity);
+        mRadius = 0.5f;
+        mSpecies = 0;
+        mId = 0;
+    }
+
+    Boid(atlas::math::Vector position, atlas::math::Vector velocity, float radius,
+        int species = 0, std::uint32_t id = 0)
+    {
+        mPosition = position;
+        mVelocity = velocity;
+        mForward = normalize(mVelocity);
+        mRadius = radius;
+        mSpecies = species;
+        mId = id;
+    }
+
+    atlas::math::Vector mPosition;
+    atlas::math::Vector mForward;
+    atlas::math::Vector mVelocity;
+    float mRadius;
+    int mSpecies;
+    // Identifies the boid for as long as it lives; its slot in the flock
+    // changes whenever the flock is re-sorted.
+    std::uint32_t mId;
+    };
+}
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "BoidInstances.hpp"
+#include "FlockSimulation.hpp"
+
 #include <algorithm>
+#include <memory_resource>
 
 #include <atlas/utils/Geometry.hpp>
 #include <atlas/gl/Buffer.hpp>
@@ -9,81 +13,90 @@
 
 namespace bns
 {
-
-    class Boid
-    {
-    public:
-    Boid()
-    {
-        mPosition = atlas::math::Vector(0,0,0);
-        mVelocity = atlas::math::Vector(0,0,0);
-        mForward = normalize(mVelocity);
-        mRadius = 0.5f;
-    }
-
-    Boid(atlas::math::Vector position, atlas::math::Vector velocity, float radius)
-    {
-        mPosition = position;
-        mVelocity = velocity;
-        mForward = normalize(mVelocity);
-        mRadius = radius;
-    }
-
-    atlas::math::Vector mPosition;
-    atlas::math::Vector mForward;
-    atlas::math::Vector mVelocity;
-    float mRadius;
-    };
+    constexpr std::uint32_t PovBoidId = 0;
 
     class BoidFlock : public atlas::utils::Geometry
     {
     public:
-        BoidFlock();
+        // Per-frame scratch (such as the instance data) is taken from
+        // frameMemory, which must stay valid until the frame ends.
+        BoidFlock(std::pmr::memory_resource* frameMemory =
+            std::pmr::get_default_resource());
 
         void updateGeometry(atlas::core::Time<> const& t) override;
 
+        // Same as prepareFrame() followed by renderView() without the POV
+        // boid.
         void renderGeometry(atlas::math::Matrix4 const& projection,
             atlas::math::Matrix4 const& view) override;
 
+        // Builds and uploads this frame's instances once for every view
+        // drawn after it. Instances are grouped by the cell of a coarse grid
+        // over the flock they fall in, so a view only has to test the cells
+        // against its frustum and draw the runs of cells it can see.
+        void prepareFrame();
+        // Draws the instances of the last prepareFrame(). The POV boid is
+        // left out unless showPovBoid, since the POV camera rides on it.
+        void renderView(atlas::math::Matrix4 const& projection,
+            atlas::math::Matrix4 const& view, bool showPovBoid);
+
         void transformGeometry(atlas::math::Matrix4 const& t) override;
 
+        // Sends instances as half floats (20 bytes each rather than 32);
+        // takes effect from the next prepareFrame().
+        void setHalfInstances(bool enabled);
+        bool getHalfInstances() const;
+
         void resetGeometry() override;
 
+        // The POV camera follows the boid with ID PovBoidId.
         atlas::math::Vector getBoidPosition();
 
         atlas::math::Vector getBoidLook();
 
-    private:
-
-        atlas::math::Vector computeSeparation(Boid &boid);
-
-        atlas::math::Vector computeAlignment(Boid &boid);
+        // Draw the given boids instead of the local simulation's state (for
+        // instance, a snapshot published by the simulation thread). slots
+        // maps boid IDs to indices in boids, as FlockSimulation::getSlots
+        // does; nullptr means the boids are already in ID order. Pass a
+        // nullptr snapshot to go back to drawing the local simulation.
+        void setSnapshot(std::vector<Boid> const* boids,
+            std::vector<std::uint32_t> const* slots = nullptr);
 
-        atlas::math::Vector computeCohesion(Boid &boid);
+        // Index of the boid with the given ID in getBoids(), or NoBoidSlot.
+        std::uint32_t getSlot(std::uint32_t id) const;
 
-        atlas::math::Vector computeAvoidance(Boid &boid);
+        FlockSimulation& getSimulation();
 
-        atlas::math::Vector random2DVector(float max);
+        // The boids that are drawn: the snapshot if one is set, otherwise
+        // the local simulation's state.
+        std::vector<Boid> const& getBoids() const;
 
-        atlas::math::Vector random3DVector(float max);
+        // The same boids in ID order, for consumers that identify boids by
+        // index (recordings, the shared memory export).
+        std::vector<Boid> const& getBoidsById();
 
-        float dot(atlas::math::Vector v1, atlas::math::Vector v2);
-
-        float mag(atlas::math::Vector v);
-
-        float angle(atlas::math::Vector v1, atlas::math::Vector v2);
+    private:
+        // Points the instance attributes at the given instance, so a draw
+        // starts there (GL 3.3 has no base instance).
+        void pointInstances(GLsizei first);
+        void drawInstances(GLsizei first, GLsizei count);
 
         atlas::gl::Buffer mVertexBuffer;
         atlas::gl::Buffer mIndexBuffer;
+        atlas::gl::Buffer mInstanceBuffer;
         atlas::gl::VertexArrayObject mVao;
 
         GLsizei mIndexCount;
-
-        float mMass;
-        float mFlockRadius;
-        float mViewRadius;
-        float mViewAngle;
-        int mNumBoids;
-        std::vector<Boid> mBoids;
+        // The POV boid's instances come first, then the cells in order.
+        GLsizei mPovInstances;
+        bool mHalfInstances;
+        std::vector<CullCell> mCells;
+        std::vector<std::uint32_t> mCellStarts;
+        std::pmr::memory_resource* mFrameMemory;
+
+        FlockSimulation mSimulation;
+        std::vector<Boid> const* mSnapshot;
+        std::vector<std::uint32_t> const* mSnapshotSlots;
+        std::vector<Boid> mById;
     };
 }
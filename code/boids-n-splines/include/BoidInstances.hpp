@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Boid.hpp"
+
+#include <atlas/math/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace bns
+{
+    // Per-instance data for the instanced boid draw; each boid is drawn as
+    // two instances, its body and its head. The vertex shader builds the
+    // model transform (and from it the normal transform) out of the centre,
+    // heading and uniform scale, so no matrix is built or sent per instance.
+    struct BoidInstance
+    {
+        atlas::math::Point position;
+        float scale;
+        atlas::math::Vector forward;
+        // RGBA, normalised to [0, 1] by the vertex fetch.
+        std::uint8_t colour[4];
+    };
+
+    // The same in half floats, for smaller uploads when the precision will
+    // do: halves keep about three significant digits, so positions far from
+    // the origin start to visibly snap.
+    struct HalfBoidInstance
+    {
+        std::uint16_t position[3];
+        std::uint16_t scale;
+        // The fourth half pads the heading to eight bytes.
+        std::uint16_t forward[4];
+        std::uint8_t colour[4];
+    };
+
+    // Instances [begin, begin + count) and the box they lie in.
+    struct CullCell
+    {
+        atlas::math::Point lower;
+        atlas::math::Point upper;
+        std::uint32_t begin;
+        std::uint32_t count;
+    };
+
+    // Replaces instances with those of every boid: the boid at povSlot (if
+    // it is not NoBoidSlot) first, then the rest grouped by the cell of a
+    // coarse grid over the flock they fall in, so that each cell in cells
+    // is one contiguous range. cellStarts is scratch kept between frames;
+    // other scratch comes from the instances' memory resource. Returns the
+    // number of instances of the POV boid.
+    std::size_t buildBoidInstances(std::vector<Boid> const& boids,
+        std::uint32_t povSlot, std::pmr::vector<BoidInstance>& instances,
+        std::vector<CullCell>& cells, std::vector<std::uint32_t>& cellStarts);
+    std::size_t buildBoidInstances(std::vector<Boid> const& boids,
+        std::uint32_t povSlot, std::pmr::vector<HalfBoidInstance>& instances,
+        std::vector<CullCell>& cells, std::vector<std::uint32_t>& cellStarts);
+}
@@ -1,13 +1,27 @@
 #pragma once
 
 #include "BoidFlock.hpp"
+#include "BoidTrails.hpp"
+#include "FlockPublisher.hpp"
+#include "FrameArena.hpp"
+#include "Obstacle.hpp"
+#include "PlanetField.hpp"
 #include "Spline.hpp"
+#include "SimulationThread.hpp"
+#include "Telemetry.hpp"
+#include "TextureCache.hpp"
+#include "TelemetryServer.hpp"
+#include "TrajectoryRecorder.hpp"
+#include "TrajectoryReplay.hpp"
 
 #include <atlas/tools/ModellingScene.hpp>
 #include <atlas/tools/MayaCamera.hpp>
 #include <atlas/tools/Grid.hpp>
 #include <atlas/utils/FPSCounter.hpp>
 
+#include <chrono>
+#include <fstream>
+
 namespace bns
 {
     class BoidScene : public atlas::tools::ModellingScene
@@ -24,15 +38,90 @@ namespace bns
         void renderScene() override;
 
     private:
+        void runCommand(SimCommand const& command);
+        void setPipelined(bool pipelined);
+        void recordFrame(std::uint64_t frame);
+        void publishFrame(std::uint64_t frame);
+        void logMetrics(std::uint64_t frame);
+        void seekTo(std::uint64_t frame);
+        // Moves the camera to where the given camera mode looks from.
+        void placeCamera(int mode);
+        // Draws the scene as seen by the given camera mode into the
+        // viewport columns [x, x + width).
+        void renderView(int mode, int x, int width);
+        void drawTimelineGui();
+        void drawRecordingGui();
+        void drawAnalyticsGui();
+        void registerMetrics();
+        void startTelemetry();
+
         int mCameraMode;
+        // Draws every camera mode side by side, the mouse still steering
+        // the stage camera.
+        bool mMultiView;
         bool mPlay;
+        bool mPipelined;
+        bool mShowObstacle;
+        int mSpecies;
+        bool mFarField;
+        bool mSweptCollisions;
+        int mIntegrator;
+        bool mShowTrails;
+        bool mShowPlanets;
+        bool mMutualGravity;
         float mFPS;
         float mAnimLength;
 
         atlas::core::Time<float> mAnimTime;
         atlas::utils::FPSCounter mCounter;
 
+        // Scratch memory for one frame, reset at the start of each update.
+        // Declared before the geometry that allocates from it.
+        FrameArena mFrameArena;
+        std::uint64_t mFrameStartAllocations;
+        std::uint64_t mFrameAllocations;
+
+        // Live metrics, served to scrapers by mTelemetryServer. Declared
+        // before the simulation thread, which records into them.
+        MetricsRegistry mTelemetry;
+        TelemetryServer mTelemetryServer;
+        Histogram* mFrameSeconds;
+        Histogram* mRenderSeconds;
+        Histogram* mStepSeconds;
+        Counter* mFramesRendered;
+        Gauge* mBoidCount;
+        Gauge* mSimFrame;
+        Gauge* mHeapAllocations;
+        Gauge* mCollisions;
+        Gauge* mLoadImbalance;
+        std::chrono::steady_clock::time_point mLastUpdate;
+
+        // Images for textured geometry; decoded in the background.
+        TextureCache mTextures;
+
         BoidFlock mBoidFlock;
+        BoidTrails mTrails;
+        Obstacle mObstacle;
+        PlanetField mPlanets;
         Spline mSpline;
+        SimulationThread mSimThread;
+
+        TrajectoryRecorder mRecorder;
+        TrajectoryReplay mReplay;
+        std::uint64_t mLastRecordedFrame;
+        std::uint64_t mDisplayedFrame;
+        std::uint64_t mFurthestFrame;
+
+        FlockPublisher mPublisher;
+        std::uint64_t mLastPublishedFrame;
+
+        FlockMetrics mMetrics;
+        LoadBalanceStats mLoadBalance;
+        int mThreads;
+        bool mAutoTune;
+        TunerStatus mTunerStatus;
+        std::ofstream mMetricsLog;
+        std::uint64_t mLastLoggedFrame;
+        FarFieldError mFarFieldError;
     };
 }
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Boid.hpp"
+
+#include <atlas/utils/Geometry.hpp>
+#include <atlas/gl/VertexArrayObject.hpp>
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace bns
+{
+    // Motion trails behind the boids. The last few positions of every boid
+    // live in a float texture used as a ring buffer: each slice holds one
+    // frame's positions, indexed by boid ID, and a new frame overwrites the
+    // oldest slice. Only that slice is uploaded per frame, and a single
+    // instanced draw (one instance per boid) expands the history into line
+    // segments in the vertex shader, so the CPU cost stays linear in the
+    // flock size whatever the trail length.
+    class BoidTrails : public atlas::utils::Geometry
+    {
+    public:
+        // The uploaded slice is staged in frameMemory.
+        BoidTrails(std::pmr::memory_resource* frameMemory =
+            std::pmr::get_default_resource());
+        ~BoidTrails();
+
+        BoidTrails(BoidTrails const&) = delete;
+        BoidTrails& operator=(BoidTrails const&) = delete;
+
+        // Records the boids shown at the given simulation frame. Nothing
+        // happens while the frame stays the same; any jump other than one
+        // step forward (a seek, a reset) starts the trails afresh.
+        void update(std::vector<Boid> const& boids, std::uint64_t frame);
+
+        void renderGeometry(atlas::math::Matrix4 const& projection,
+            atlas::math::Matrix4 const& view) override;
+
+        void resetGeometry() override;
+
+        // Number of positions kept per boid, including the current one.
+        int getLength() const;
+        void setLength(int length);
+
+    private:
+        void allocateHistory(std::size_t boidCount);
+
+        atlas::gl::VertexArrayObject mVao;
+        GLuint mHistory;
+
+        std::pmr::memory_resource* mFrameMemory;
+
+        int mLength;
+        std::size_t mBoidCount;
+        // Texels per row; a slice spans mSliceRows rows so that large flocks
+        // fit within the maximum texture width.
+        GLsizei mWidth;
+        GLsizei mSliceRows;
+
+        // Slice holding the newest positions, and how many slices hold
+        // positions at all.
+        int mHead;
+        int mFilled;
+        std::uint64_t mLastFrame;
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Boid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bns
+{
+    // Minimal state needed to resume a flock exactly: the forward vector is
+    // derived from the velocity and the radius never changes during a run.
+    // The ID is kept because re-sorting moves boids between slots.
+    struct CompactBoid
+    {
+        atlas::math::Vector position;
+        atlas::math::Vector velocity;
+        std::uint32_t id;
+    };
+
+    struct Checkpoint
+    {
+        std::uint64_t frame;
+        // One per boid, in the store's slot storage; valid until the
+        // checkpoint is dropped.
+        CompactBoid const* boids;
+        std::uint32_t slot;
+    };
+
+    // Keeps a checkpoint every `interval` frames within a memory budget. When
+    // the budget is exceeded the interval doubles and every checkpoint that is
+    // no longer on the coarser grid is dropped, so checkpoints stay evenly
+    // spaced and the cost of a seek stays bounded by the current interval.
+    //
+    // The budget is reserved up front as fixed-size slots (at least two)
+    // for the flock size of the first capture, and dropped checkpoints give
+    // their slot back, so capturing never allocates until the flock size
+    // changes. Reserving only claims address space; pages are touched as
+    // slots fill.
+    class CheckpointStore
+    {
+    public:
+        CheckpointStore(std::uint64_t interval, std::size_t memoryBudget);
+
+        void clear();
+
+        void capture(std::uint64_t frame, std::vector<Boid> const& boids);
+
+        // Drops checkpoints after frame, e.g. when the rules change.
+        void discardAfter(std::uint64_t frame);
+
+        // Latest checkpoint at or before frame, or nullptr if there is none.
+        Checkpoint const* findNearest(std::uint64_t frame) const;
+
+        std::uint64_t getInterval() const;
+        std::size_t getCount() const;
+        std::size_t getMemoryUsage() const;
+
+    private:
+        // Sizes the slot storage for flocks of the given size, dropping
+        // every checkpoint.
+        void allocateSlots(std::size_t boidCount);
+        void releaseSlot(Checkpoint const& checkpoint);
+        void evict();
+
+        std::uint64_t mBaseInterval;
+        std::uint64_t mInterval;
+        std::size_t mMemoryBudget;
+        std::size_t mMemoryUsage;
+        std::vector<Checkpoint> mCheckpoints;
+
+        // Slot i holds mSlotSize boids from mSlotStorage[i * mSlotSize].
+        // Storage is reserved for mSlotCount slots and grows into that
+        // reservation only when no freed slot is left.
+        std::size_t mSlotSize;
+        std::size_t mSlotCount;
+        std::vector<CompactBoid> mSlotStorage;
+        std::vector<std::uint32_t> mFreeSlots;
+    };
+}
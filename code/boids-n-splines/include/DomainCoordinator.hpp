@@ -0,0 +1,51 @@
+#pragma once
+
+#include "DomainProtocol.hpp"
+#include "Transport.hpp"
+
+#include <string>
+#include <vector>
+
+namespace bns
+{
+    struct DistributedStepStats
+    {
+        std::uint32_t totalBoids;
+        std::uint32_t minOwned;
+        std::uint32_t maxOwned;
+        std::uint32_t haloBoids;
+        std::uint32_t migratedBoids;
+        // Slowest worker's simulation time, and the wall time of the whole
+        // step including halo exchange and migration.
+        float maxStepMilliseconds;
+        float wallMilliseconds;
+    };
+
+    // Drives a distributed run: scatters the flock, cuts it into one slab
+    // per worker and steps every worker in lockstep.
+    class DomainCoordinator
+    {
+    public:
+        DomainCoordinator();
+
+        // Workers are given in slab order, left to right, and must already
+        // be listening (or start within the connect timeout).
+        bool start(std::vector<std::string> const& workers,
+            FlockParameters const& params);
+        bool step(DistributedStepStats& stats);
+        bool gather(std::vector<Boid>& boids);
+        void stop();
+
+    private:
+        std::vector<Connection> mWorkers;
+        FlockParameters mParams;
+    };
+
+    // Starts count bns-sim worker processes on this host, listening on Unix
+    // sockets (or loopback TCP ports from basePort up when useTcp is set).
+    // Returns the worker addresses and their process ids.
+    bool launchLocalWorkers(std::string const& executable, std::size_t count,
+        bool useTcp, std::uint16_t basePort, std::vector<std::string>& addresses,
+        std::vector<int>& processes);
+    void waitForWorkers(std::vector<int> const& processes);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Boid.hpp"
+#include "FlockParameters.hpp"
+#include "Transport.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bns
+{
+    // Messages exchanged by a distributed run. The coordinator owns the
+    // world layout and drives the workers one step at a time; workers talk
+    // to their neighbouring subdomains directly for halos and migration.
+    enum class DomainMessage : std::uint32_t
+    {
+        Setup,      // coordinator -> worker: layout, parameters, boids
+        Hello,      // worker -> right neighbour: opens the neighbour link
+        Step,       // coordinator -> worker
+        StepDone,   // worker -> coordinator: owned count, step time
+        Halo,       // worker <-> neighbour: boids near the shared boundary
+        Migrate,    // worker <-> neighbour: boids that crossed it
+        Gather,     // coordinator -> worker
+        Boids,      // worker -> coordinator: every owned boid
+        Stop        // coordinator -> worker
+    };
+
+    // The world is cut into slabs along x. Worker index owns boids with
+    // lower <= x < upper; the outermost slabs extend to infinity.
+    struct DomainSetup
+    {
+        std::uint32_t index;
+        std::uint32_t count;
+        float lower;
+        float upper;
+        FlockParameters params;
+        // Where the worker owning the next slab listens; empty for the last.
+        std::string rightAddress;
+        std::vector<Boid> boids;
+    };
+
+    struct DomainStepReport
+    {
+        std::uint32_t ownedBoids;
+        std::uint32_t haloBoids;
+        std::uint32_t migratedBoids;
+        float stepMilliseconds;
+    };
+
+    void writeParameters(MessageBuffer& message, FlockParameters const& params);
+    bool readParameters(MessageBuffer& message, FlockParameters& params);
+
+    // Boids travel as position, velocity and species; the radius comes from
+    // the run's parameters.
+    void writeBoids(MessageBuffer& message, std::vector<Boid> const& boids);
+    bool readBoids(MessageBuffer& message, float radius,
+        std::vector<Boid>& boids);
+
+    void writeSetup(MessageBuffer& message, DomainSetup const& setup);
+    bool readSetup(MessageBuffer& message, DomainSetup& setup);
+
+    bool sendMessage(Connection& connection, DomainMessage type,
+        MessageBuffer const& message);
+    // Fails if the connection drops or the next message is of another type.
+    bool expectMessage(Connection& connection, DomainMessage type,
+        MessageBuffer& message);
+}
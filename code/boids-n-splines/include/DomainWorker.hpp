@@ -0,0 +1,53 @@
+#pragma once
+
+#include "DomainProtocol.hpp"
+#include "FlockSimulation.hpp"
+#include "Transport.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace bns
+{
+    // One process of a distributed run: simulates the boids in its slab of
+    // the world. Before every step it swaps halo boids with the neighbouring
+    // slabs, and after it hands over boids that crossed into them.
+    class DomainWorker
+    {
+    public:
+        DomainWorker();
+
+        // Listens on address and serves a single run; returns once the
+        // coordinator says stop (true) or a connection drops (false).
+        bool run(Address const& address);
+
+    private:
+        bool setup(MessageBuffer& message);
+        bool step(DomainStepReport& report);
+
+        bool exchangeHalos(std::vector<Boid>& ghosts);
+        bool migrate(std::uint32_t& migrated);
+
+        // Swaps one message with each neighbour. Neighbours are paired off
+        // so that one side always sends first and the other receives first,
+        // which keeps large messages from deadlocking on full socket buffers.
+        bool exchange(DomainMessage type, MessageBuffer const& toLeft,
+            MessageBuffer const& toRight, MessageBuffer& fromLeft,
+            MessageBuffer& fromRight);
+        bool exchangeWith(Connection& peer, bool sendFirst, DomainMessage type,
+            MessageBuffer const& outgoing, MessageBuffer& incoming);
+
+        Listener mListener;
+        Connection mCoordinator;
+        Connection mLeft;
+        Connection mRight;
+
+        std::uint32_t mIndex;
+        std::uint32_t mCount;
+        float mLower;
+        float mUpper;
+        float mHaloWidth;
+
+        std::unique_ptr<FlockSimulation> mSimulation;
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Deliberately free of atlas and glm so that external readers only need
+// this header and FlockExportReader.
+namespace bns
+{
+    // Layout of the shared-memory ring that FlockPublisher writes:
+    //
+    //   FlockExportHeader, padded to headerSize
+    //   { FlockExportSlot, FlockExportBoid * boidCapacity } * slotCount,
+    //   each padded to slotSize
+    //
+    // Frame n (counting from 0) goes to slot n % slotCount. Each slot works as
+    // a seqlock: its sequence is 2n + 1 while frame n is being written and
+    // 2n + 2 once it is complete, and header.published is raised to n + 1
+    // after that. A reader takes the latest slot in place, uses it, and then
+    // checks that the sequence has not moved, which gives it slotCount - 1
+    // frames' worth of time before the writer comes round again.
+    constexpr char FlockExportMagic[8] = { 'B', 'N', 'S', 'F', 'L', 'O', 'C', 'K' };
+    // Bumped whenever the layout changes; readers refuse other versions.
+    constexpr std::uint32_t FlockExportVersion = 1;
+    constexpr char FlockExportDefaultName[] = "/bns-flock";
+
+    struct FlockExportBoid
+    {
+        float position[3];
+        float forward[3];
+        float velocity[3];
+        std::int32_t species;
+    };
+
+    struct FlockExportHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t headerSize;
+        std::uint32_t slotCount;
+        std::uint32_t boidCapacity;
+        std::uint64_t slotSize;
+        std::atomic<std::uint64_t> published;
+        // Set when the writer goes away; a reader should reopen by name to
+        // pick up whatever replaces it.
+        std::atomic<std::uint32_t> closed;
+        std::uint32_t reserved;
+    };
+
+    struct FlockExportSlot
+    {
+        std::atomic<std::uint64_t> sequence;
+        std::uint64_t frame;
+        std::uint32_t boidCount;
+        std::uint32_t reserved;
+    };
+
+    static_assert(sizeof(FlockExportBoid) == 40, "export layout changed");
+    static_assert(sizeof(FlockExportSlot) == 24, "export layout changed");
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+        "export counters must be lock free to work across processes");
+
+    constexpr std::size_t FlockExportAlignment = 64;
+
+    inline std::size_t alignExport(std::size_t size)
+    {
+        return (size + FlockExportAlignment - 1) & ~(FlockExportAlignment - 1);
+    }
+}
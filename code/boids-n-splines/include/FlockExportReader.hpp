@@ -0,0 +1,56 @@
+#pragma once
+
+#include "FlockExport.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace bns
+{
+    // One exported frame, read in place from shared memory. The pointers
+    // stay usable until the writer laps the ring; FlockExportReader::isValid
+    // says whether that has happened yet.
+    struct FlockFrameView
+    {
+        FlockExportBoid const* boids;
+        std::uint32_t boidCount;
+        std::uint64_t frame;
+        std::uint64_t sequence;
+        FlockExportSlot const* slot;
+    };
+
+    // Reader side of FlockPublisher. Any number of readers can map the same
+    // ring; none of them take locks or write to it.
+    class FlockExportReader
+    {
+    public:
+        FlockExportReader();
+        ~FlockExportReader();
+
+        FlockExportReader(FlockExportReader const&) = delete;
+        FlockExportReader& operator=(FlockExportReader const&) = delete;
+
+        bool open(std::string const& name = FlockExportDefaultName);
+        void close();
+        bool isOpen() const;
+
+        // True once the writer has gone; reopen to follow its replacement.
+        bool isWriterClosed() const;
+
+        // Total frames published so far; the difference between two calls
+        // tells a slow reader how many frames it skipped.
+        std::uint64_t getPublishedCount() const;
+
+        // Latest complete frame. Fails if nothing has been published yet.
+        bool acquireLatest(FlockFrameView& view) const;
+
+        // Call after using a view: false means the writer started reusing
+        // its slot in the meantime, so what was read may be torn.
+        bool isValid(FlockFrameView const& view) const;
+
+    private:
+        std::uint8_t const* mData;
+        std::size_t mSize;
+        FlockExportHeader const* mHeader;
+    };
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Boid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace bns
+{
+    struct FlockMetrics
+    {
+        // Length of the mean forward vector: 1 when every boid heads the same
+        // way, close to 0 for a disordered flock.
+        float polarisation;
+        // Averaged over boids with another boid within the neighbour query
+        // radius; isolated boids have no meaningful nearest neighbour.
+        float meanNearestDistance;
+        // Pairs of boids closer than the sum of their radii.
+        int collisions;
+        // Groups of boids joined by chains of neighbours within the view
+        // radius; a lone boid counts as its own cluster.
+        int clusters;
+    };
+
+    // Gathers FlockMetrics from the neighbour pairs the boid rules already
+    // visit, so measuring a step costs a union-find pass on top of it rather
+    // than another O(N^2) sweep over the flock.
+    class FlockAnalytics
+    {
+    public:
+        FlockAnalytics();
+
+        void begin(std::size_t boidCount, float linkDistance);
+
+        // Each pair should be added once, with self < other. Indices past
+        // boidCount (ghost boids) count towards collisions but not clusters.
+        void addPair(std::uint32_t self, std::uint32_t other, float distance,
+            float contactDistance)
+        {
+            if (distance < contactDistance)
+            {
+                mCollisions++;
+            }
+            // Boids sharing a parent are already joined; that catches most
+            // pairs without a call, since paths are kept short.
+            if (distance <= mLinkDistance && other < mParent.size() &&
+                mParent[self] != mParent[other])
+            {
+                unite(self, other);
+            }
+        }
+
+        // Nearest neighbour of one boid, or a negative value if it had none.
+        void addNearest(float distance)
+        {
+            if (distance >= 0.0f)
+            {
+                mNearestSum += distance;
+                mNearestCount++;
+            }
+        }
+
+        // Folds in pairs gathered by another FlockAnalytics over the same
+        // boids, such as one per worker of a parallel step.
+        void merge(FlockAnalytics const& other);
+
+        FlockMetrics finish(std::vector<Boid> const& boids);
+
+    private:
+        std::uint32_t find(std::uint32_t index);
+        void unite(std::uint32_t a, std::uint32_t b);
+
+        std::vector<std::uint32_t> mParent;
+        // Every union made since begin(), as (new root, old root). Replaying
+        // them rebuilds the clusters elsewhere, and only their old roots
+        // need resetting for the next step.
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> mLinks;
+        float mLinkDistance;
+        double mNearestSum;
+        std::size_t mNearestCount;
+        int mCollisions;
+    };
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bns
+{
+    // How a step turns forces into motion; see Integrator.
+    enum class IntegratorType
+    {
+        SemiImplicitEuler,
+        VelocityVerlet,
+        RungeKutta4
+    };
+
+    // Tunable constants of the boid rules. The defaults reproduce the
+    // original hand-tuned flock.
+    struct FlockParameters
+    {
+        float separationWeight = 3.0f;
+        float alignmentWeight = 100.0f;
+        float cohesionWeight = 2.0f;
+        float avoidanceWeight = 1.0f;
+        float obstacleWeight = 5.0f;
+        float fleeWeight = 2.0f;
+
+        float mass = 1000.0f;
+
+        // Seconds of flock time per step. Speeds and forces keep the units
+        // of the original fixed 60 Hz tick, so a 1/60 s step with
+        // semi-implicit Euler reproduces the original flock.
+        IntegratorType integrator = IntegratorType::SemiImplicitEuler;
+        float timeStep = 1.0f / 60.0f;
+        // Caps on each boid's speed (per tick) and on the rule force acting
+        // on it; 0 leaves them unclamped.
+        float maxSpeed = 0.0f;
+        float maxForce = 0.0f;
+
+        float flockRadius = 5.0f;
+        float viewRadius = 1.0f;
+        float viewAngle = 0.75f * 3.1419f;
+        float boidRadius = 0.15f;
+        // Distance from an obstacle at which boids start to steer away.
+        float obstacleMargin = 1.0f;
+        // Extra reach of the cached neighbour lists; they are rebuilt once a
+        // boid has moved half this far.
+        float neighbourSkin = 0.3f;
+
+        // Far-field mode: neighbours beyond nearRadius are gathered from an
+        // octree, and a whole distant node stands in for its boids once its
+        // width over its distance drops below farFieldAngle.
+        bool farField = false;
+        float nearRadius = 1.0f;
+        float farFieldAngle = 0.5f;
+
+        // Frames between re-sorting the flock along a Morton curve so that
+        // neighbours sit close together in memory; 0 keeps the scatter order.
+        int reorderInterval = 32;
+
+        // Sweeps each boid's sphere over the step and stops it at its first
+        // contact, so fast boids cannot pass through each other.
+        bool continuousCollision = false;
+
+        // Threads for the force pass, which is split into parts of equal
+        // estimated work; 0 uses every hardware thread.
+        int threadCount = 1;
+        // Parts of the split per thread; more parts even out what the cost
+        // estimate gets wrong, at some scheduling cost.
+        int partsPerThread = 1;
+
+        // Tunes neighbourSkin, threadCount and partsPerThread online; see
+        // StepTuner.
+        bool autoTune = false;
+
+        int numBoids = 100;
+
+        std::uint32_t seed = 1;
+
+        // Boids are assigned species round-robin. speciesInteraction is a
+        // numSpecies x numSpecies row-major matrix: entry (a, b) scales how
+        // strongly a boid of species a aligns and coheres with a neighbour of
+        // species b, and a negative entry makes it flee that neighbour
+        // instead. Separation and avoidance apply between all species.
+        int numSpecies = 1;
+        std::vector<float> speciesInteraction = { 1.0f };
+
+        float getInteraction(int self, int other) const
+        {
+            return speciesInteraction[self * numSpecies + other];
+        }
+
+        // Resets the matrix to the default mix: every species flocks with its
+        // own kind and ignores the others, and with two or more species the
+        // last one is a predator that every other species flees and that
+        // chases them in turn.
+        void setSpecies(int count)
+        {
+            numSpecies = (count < 1) ? 1 : count;
+            std::size_t n = static_cast<std::size_t>(numSpecies);
+            speciesInteraction.assign(n * n, 0.0f);
+
+            int predator = numSpecies - 1;
+            for (int a = 0; a < numSpecies; ++a)
+            {
+                for (int b = 0; b < numSpecies; ++b)
+                {
+                    float weight = (a == b) ? 1.0f : 0.0f;
+                    if (a != b && b == predator)
+                    {
+                        weight = -1.0f;
+                    }
+                    else if (a != b && a == predator)
+                    {
+                        weight = 0.5f;
+                    }
+                    speciesInteraction[a * n + b] = weight;
+                }
+            }
+        }
+    };
+}
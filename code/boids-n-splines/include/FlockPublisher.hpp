@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Boid.hpp"
+#include "FlockExport.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bns
+{
+    // Writes completed frames into a named POSIX shared-memory ring (see
+    // FlockExport.hpp) for any number of lock-free readers. Publishing is a
+    // single pass over the boids with no locks and no allocation.
+    class FlockPublisher
+    {
+    public:
+        FlockPublisher();
+        ~FlockPublisher();
+
+        FlockPublisher(FlockPublisher const&) = delete;
+        FlockPublisher& operator=(FlockPublisher const&) = delete;
+
+        bool open(std::string const& name, std::size_t boidCapacity,
+            std::uint32_t slotCount = 8);
+        void close();
+        bool isOpen() const;
+
+        // A flock larger than the capacity recreates the ring; readers see
+        // the old one marked closed and reopen.
+        void publish(std::vector<Boid> const& boids, std::uint64_t frame);
+
+        std::uint64_t getPublishedCount() const;
+
+    private:
+        FlockExportSlot* getSlot(std::uint64_t index) const;
+
+        std::string mName;
+        std::uint8_t* mData;
+        std::size_t mSize;
+        FlockExportHeader* mHeader;
+    };
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "Boid.hpp"
+#include "CheckpointStore.hpp"
+#include "FlockMetrics.hpp"
+#include "FlockParameters.hpp"
+#include "Integrator.hpp"
+#include "NeighbourList.hpp"
+#include "Octree.hpp"
+#include "SignedDistanceField.hpp"
+#include "SpatialGrid.hpp"
+#include "StepTuner.hpp"
+#include "ThreadPool.hpp"
+#include "WorkPartitioner.hpp"
+
+#include <atlas/math/Math.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace bns
+{
+    // Slot of a boid ID that is not in the flock.
+    constexpr std::uint32_t NoBoidSlot = 0xffffffff;
+
+    // Far-field forces compared against an exact gather over every boid.
+    struct FarFieldError
+    {
+        float meanRelative;
+        float maxRelative;
+        std::size_t samples;
+    };
+
+    // How evenly the last parallel force pass spread its work. The
+    // predicted imbalance is the costliest part over the mean part, the
+    // measured one the busiest thread over the mean thread; 1 is perfect.
+    struct LoadBalanceStats
+    {
+        std::size_t threads;
+        std::size_t parts;
+        float predictedImbalance;
+        float measuredImbalance;
+        float maxThreadMilliseconds;
+        float meanThreadMilliseconds;
+    };
+
+    // Steps the boid rules without touching any GL state, so the flock can be
+    // simulated off the render thread (or without a window at all).
+    class FlockSimulation
+    {
+    public:
+        FlockSimulation(FlockParameters const& params = FlockParameters());
+
+        void step();
+        void reset();
+
+        // Moves to the given frame by restoring the nearest earlier
+        // checkpoint and simulating the remainder.
+        void seek(std::uint64_t frame);
+
+        // Static scene geometry to steer around, or nullptr for none. The
+        // field is not owned and must outlive the simulation.
+        void setObstacles(SignedDistanceField const* obstacles);
+
+        // Replaces the species interaction matrix with the default one for
+        // count species and reassigns boids round-robin.
+        void setSpecies(int count);
+
+        // Switches the far field on or off; see FlockParameters::farField.
+        void setFarField(bool enabled);
+        // See FlockParameters::continuousCollision.
+        void setContinuousCollision(bool enabled);
+        // See FlockParameters::threadCount.
+        void setThreadCount(int count);
+        // See FlockParameters::integrator and timeStep. Frames simulated
+        // ahead of now are dropped if either changes.
+        void setIntegrator(IntegratorType type);
+        void setTimeStep(float seconds);
+        // See FlockParameters::autoTune. Turning it on starts a new search
+        // from the current settings.
+        void setAutoTune(bool enabled);
+
+        // Replaces the flock, for instance with the boids a distributed
+        // worker owns. Checkpoints are dropped since they assume the old
+        // boid count.
+        void setBoids(std::vector<Boid> const& boids);
+
+        // Boids owned elsewhere (such as the halo of a neighbouring
+        // subdomain) that this flock sees but does not move. They stay in
+        // place until replaced.
+        void setGhosts(std::vector<Boid> const& ghosts);
+
+        // Boids further apart than this never affect each other.
+        float getQueryRadius() const;
+
+        // Boids are periodically re-sorted in space (see
+        // FlockParameters::reorderInterval), so anything that follows one
+        // boid should hold on to its mId and look up its slot here.
+        std::vector<Boid> const& getBoids() const;
+        // Indexed by boid ID; NoBoidSlot for IDs not in this flock.
+        std::vector<std::uint32_t> const& getSlots() const;
+        std::uint64_t getFrame() const;
+        FlockParameters const& getParameters() const;
+        CheckpointStore const& getCheckpoints() const;
+
+        // Measured from the neighbour pairs visited by the last step, so they
+        // describe the flock as that step found it.
+        FlockMetrics const& getMetrics() const;
+
+        NeighbourList const& getNeighbourList() const;
+
+        // All zero until a step has run on more than one thread.
+        LoadBalanceStats const& getLoadBalance() const;
+
+        // Only meaningful while FlockParameters::autoTune is on.
+        TunerStatus getTunerStatus() const;
+
+        // Relative error of the rule forces for up to sampleCount boids
+        // spread through the flock. Costs O(N) per sample, so keep the
+        // sample count small on large flocks.
+        FarFieldError measureFarFieldError(std::size_t sampleCount);
+
+    private:
+        struct NeighbourSums
+        {
+            atlas::math::Vector separation = {0,0,0};
+            atlas::math::Vector alignment = {0,0,0};
+            atlas::math::Vector position = {0,0,0};
+            atlas::math::Vector flee = {0,0,0};
+            atlas::math::Vector avoidance = {0,0,0};
+            float weight = 0;
+        };
+
+        // Per node and species of the far-field octree.
+        struct FarFieldAggregate
+        {
+            float count;
+            atlas::math::Vector positionSum;
+            atlas::math::Vector velocitySum;
+        };
+
+        // Time of impact, as a fraction of the step, of a sphere moving by
+        // motion relative to another that starts offset away; 1 if they do
+        // not meet.
+        float timeOfImpact(atlas::math::Vector const& offset,
+            atlas::math::Vector const& motion, float contact) const;
+        void resolveCollisions(float ticks);
+
+        void reorderBoids();
+        void updateSlots();
+        void applyTunedSettings();
+        void prepareNeighbours();
+        void buildFarField();
+
+        // Fills in each boid's acceleration for the flock as it stands;
+        // with analyse set, the flock metrics are measured on the way.
+        void computeAccelerations(
+            std::vector<atlas::math::Vector>& accelerations, bool analyse);
+        void computeForces(std::size_t index, FlockAnalytics* analytics);
+        void computeForcesInParallel(float linkDistance, bool analyse);
+        atlas::math::Vector computeNeighbourForces(std::size_t index,
+            FlockAnalytics* analytics);
+
+        bool considerNeighbour(Boid const& self, Boid const& other,
+            atlas::math::Vector const& offset, float distance,
+            NeighbourSums& sums) const;
+        void considerAvoidance(Boid const& self, Boid const& other,
+            float distance, NeighbourSums& sums) const;
+
+        // Pairs are also fed to analytics unless it is null.
+        void gatherNear(std::size_t index, NeighbourSums& sums,
+            FlockAnalytics* analytics);
+        void gatherFar(std::size_t index, NeighbourSums& sums) const;
+        void gatherExact(std::size_t index, NeighbourSums& sums) const;
+        atlas::math::Vector combineForces(Boid const& self,
+            NeighbourSums const& sums) const;
+
+        atlas::math::Vector computeObstacleAvoidance(Boid &boid);
+
+        void scatterBoids();
+
+        float randomFloat(float max);
+
+        atlas::math::Vector random2DVector(float max);
+
+        atlas::math::Vector random3DVector(float max);
+
+        float dot(atlas::math::Vector v1, atlas::math::Vector v2) const;
+
+        float mag(atlas::math::Vector v) const;
+
+        FlockParameters mParams;
+        std::mt19937 mRandom;
+        std::uint64_t mFrame;
+        SignedDistanceField const* mObstacles;
+        std::vector<Boid> mBoids;
+        std::vector<std::uint32_t> mSlots;
+        std::vector<Boid> mReordered;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> mOrder;
+        std::vector<Boid> mGhosts;
+        std::vector<Boid> mNeighbourhood;
+        std::vector<Boid> const* mNeighbours;
+        float mCosViewAngle;
+        std::vector<atlas::math::Vector> mForces;
+        std::unique_ptr<Integrator> mIntegrator;
+        IntegratorType mIntegratorType;
+        std::vector<atlas::math::Vector> mDisplacements;
+        SpatialGrid mGrid;
+        NeighbourList mNeighbourList;
+        SpatialGrid mCollisionGrid;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> mCollisionPairs;
+        std::vector<float> mAdvance;
+        std::vector<atlas::math::Vector> mImpulses;
+        Octree mOctree;
+        std::vector<atlas::math::Point> mPositions;
+        std::vector<FarFieldAggregate> mAggregates;
+        FlockAnalytics mAnalytics;
+        std::unique_ptr<ThreadPool> mPool;
+        WorkPartitioner mPartitioner;
+        std::vector<float> mCosts;
+        std::vector<FlockAnalytics> mThreadAnalytics;
+        std::vector<double> mThreadMilliseconds;
+        LoadBalanceStats mLoadBalance;
+        StepTuner mTuner;
+        FlockMetrics mMetrics;
+        CheckpointStore mCheckpoints;
+    };
+}
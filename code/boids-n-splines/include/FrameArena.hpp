@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace bns
+{
+    // Bump allocator for memory that only lives until the end of a frame.
+    // Allocations are carved out of one block, deallocation does nothing and
+    // reset() hands everything back at once. A frame that outgrows the block
+    // takes extra blocks from the upstream resource; the next reset() swaps
+    // them all for a single block big enough for that frame, so a steady
+    // workload stops touching the heap after its first few frames.
+    class FrameArena : public std::pmr::memory_resource
+    {
+    public:
+        explicit FrameArena(std::size_t initialCapacity = 64 * 1024,
+            std::pmr::memory_resource* upstream =
+                std::pmr::new_delete_resource());
+        ~FrameArena();
+
+        FrameArena(FrameArena const&) = delete;
+        FrameArena& operator=(FrameArena const&) = delete;
+
+        // Invalidates everything allocated since the last reset.
+        void reset();
+
+        std::size_t getUsedBytes() const;
+        std::size_t getPeakBytes() const;
+        std::size_t getCapacity() const;
+        // Blocks taken from the upstream resource since construction.
+        std::uint64_t getUpstreamAllocations() const;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* pointer, std::size_t bytes,
+            std::size_t alignment) override;
+        bool do_is_equal(std::pmr::memory_resource const& other) const
+            noexcept override;
+
+    private:
+        struct Block
+        {
+            std::byte* data;
+            std::size_t size;
+        };
+
+        static std::size_t alignOffset(Block const& block, std::size_t offset,
+            std::size_t alignment);
+
+        void addBlock(std::size_t size);
+        void releaseBlocks();
+
+        std::pmr::memory_resource* mUpstream;
+        std::vector<Block> mBlocks;
+        std::size_t mOffset;
+        std::size_t mUsed;
+        std::size_t mPeak;
+        std::uint64_t mUpstreamAllocations;
+    };
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Boid.hpp"
+#include "FlockParameters.hpp"
+
+#include <atlas/math/Math.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace bns
+{
+    // Advances the flock by one step from the accelerations the boid rules
+    // give it. Time is measured in ticks of the original 60 Hz step, which
+    // is what speeds and forces are expressed in.
+    class Integrator
+    {
+    public:
+        // Fills in the acceleration of every boid as the flock currently
+        // stands (positions, velocities and headings).
+        using Evaluate =
+            std::function<void(std::vector<atlas::math::Vector>&)>;
+
+        virtual ~Integrator() = default;
+
+        // Integrates over ticks. evaluate must read the very boids passed
+        // in; intermediate stages are written into them before it is
+        // called. On return every boid has its new velocity but is still at
+        // its old position, with displacements holding how far it moves, so
+        // the caller can sweep the motion for collisions; headings are left
+        // for the caller too. Speeds are kept to maxSpeed at every stage
+        // unless it is 0.
+        virtual void step(std::vector<Boid>& boids, float ticks,
+            float maxSpeed, Evaluate const& evaluate,
+            std::vector<atlas::math::Vector>& displacements) = 0;
+
+        // Force evaluations per step.
+        virtual int getStageCount() const = 0;
+    };
+
+    std::unique_ptr<Integrator> makeIntegrator(IntegratorType type);
+    char const* getIntegratorName(IntegratorType type);
+
+    // v scaled down to at most maxLength long; 0 leaves it alone.
+    atlas::math::Vector clampLength(atlas::math::Vector const& v,
+        float maxLength);
+
+    // One evaluation per step. Velocities are updated first and positions
+    // from the new velocities, which keeps it stable for small steps where
+    // explicit Euler slowly gains energy. This is the original update.
+    class SemiImplicitEuler : public Integrator
+    {
+    public:
+        void step(std::vector<Boid>& boids, float ticks, float maxSpeed,
+            Evaluate const& evaluate,
+            std::vector<atlas::math::Vector>& displacements) override;
+        int getStageCount() const override;
+
+    private:
+        std::vector<atlas::math::Vector> mAccelerations;
+    };
+
+    // Second order: moves by the start velocity and acceleration, then
+    // averages the accelerations at both ends of the step. The rules also
+    // depend on velocity, so the end is evaluated at the Euler-predicted
+    // velocity; two evaluations per step.
+    class VelocityVerlet : public Integrator
+    {
+    public:
+        void step(std::vector<Boid>& boids, float ticks, float maxSpeed,
+            Evaluate const& evaluate,
+            std::vector<atlas::math::Vector>& displacements) override;
+        int getStageCount() const override;
+
+    private:
+        std::vector<atlas::math::Point> mPositions;
+        std::vector<atlas::math::Vector> mVelocities;
+        std::vector<atlas::math::Vector> mStart;
+        std::vector<atlas::math::Vector> mEnd;
+    };
+
+    // Classic fourth-order Runge-Kutta over positions and velocities; four
+    // evaluations per step.
+    class RungeKutta4 : public Integrator
+    {
+    public:
+        void step(std::vector<Boid>& boids, float ticks, float maxSpeed,
+            Evaluate const& evaluate,
+            std::vector<atlas::math::Vector>& displacements) override;
+        int getStageCount() const override;
+
+    private:
+        std::vector<atlas::math::Point> mPositions;
+        std::vector<atlas::math::Vector> mVelocities;
+        std::vector<atlas::math::Vector> mAccelerations;
+        std::vector<atlas::math::Vector> mVelocitySum;
+        std::vector<atlas::math::Vector> mAccelerationSum;
+    };
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bns
+{
+    // A decoded RGBA8 image together with every mip level down to 1x1,
+    // stored back to back in one block so it can be uploaded (or written to
+    // disk) in a single copy.
+    struct MipChain
+    {
+        struct Level
+        {
+            int width;
+            int height;
+            // Byte offset of the level in pixels.
+            std::size_t offset;
+        };
+
+        std::vector<Level> levels;
+        std::vector<std::uint8_t> pixels;
+    };
+
+    // On-disk layout of a cached mip chain:
+    //
+    //   MipCacheHeader, { int32 width, int32 height } * levelCount, pixels
+    //
+    // Levels follow each other tightly packed, largest first.
+    constexpr char MipCacheMagic[8] = { 'B', 'N', 'S', 'M', 'I', 'P', 'S', '\0' };
+    constexpr std::uint32_t MipCacheVersion = 1;
+
+    struct MipCacheHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t levelCount;
+        std::uint64_t pixelBytes;
+    };
+
+    // Decodes the image at path and builds its mip chain with a 2x2 box
+    // filter. Returns false if the image cannot be read.
+    bool decodeMipChain(std::string const& path, MipChain& chain);
+
+    // Fills in the smaller levels of a chain whose first level is set.
+    void buildMipLevels(MipChain& chain);
+
+    // Name of the cache file for the image at path within directory. The
+    // name covers the image's size and modification time, so an edited
+    // image misses the cache instead of loading stale pixels.
+    std::string getMipCachePath(std::string const& directory,
+        std::string const& path);
+
+    bool readMipCache(std::string const& cachePath, MipChain& chain);
+    // Written to a temporary file and renamed into place, so a reader never
+    // sees a half-written cache.
+    bool writeMipCache(std::string const& cachePath, MipChain const& chain);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Boid.hpp"
+#include "SpatialGrid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bns
+{
+    // Verlet neighbour lists: for every boid, the boids within radius + skin
+    // of it, stored back to back in one flat (CSR) array. As long as no two
+    // boids have moved more than the skin between them since the lists were
+    // built (so in particular while none has moved half the skin), no pair
+    // can have closed from beyond radius + skin to within radius, and the
+    // lists still hold every neighbour.
+    //
+    // Each list is sorted by index, so the neighbours within the radius are
+    // visited in the same order no matter when the list was built or how
+    // large the skin is; the skin only ever changes the speed.
+    class NeighbourList
+    {
+    public:
+        NeighbourList();
+
+        bool isStale(std::vector<Boid> const& boids, float radius,
+            float skin) const;
+
+        // Lists are built for the first count boids; any after that (ghosts)
+        // only ever appear as neighbours.
+        void build(std::vector<Boid> const& boids, std::size_t count,
+            SpatialGrid& grid, float radius, float skin);
+        void invalidate();
+
+        template <typename Visitor>
+        void forEachNeighbour(std::size_t index, Visitor&& visit) const
+        {
+            for (std::uint32_t k = mOffsets[index]; k < mOffsets[index + 1];
+                ++k)
+            {
+                visit(mIndices[k]);
+            }
+        }
+
+        std::size_t getNeighbourCount(std::size_t index) const
+        {
+            return mOffsets[index + 1] - mOffsets[index];
+        }
+
+        // Entries over all lists, counting each pair from both ends.
+        std::size_t getPairCount() const;
+        std::uint64_t getBuildCount() const;
+
+    private:
+        std::vector<std::uint32_t> mOffsets;
+        std::vector<std::uint32_t> mIndices;
+        std::vector<atlas::math::Point> mBuiltPositions;
+        float mRadius;
+        float mSkin;
+        bool mValid;
+        std::uint64_t mBuildCount;
+    };
+}
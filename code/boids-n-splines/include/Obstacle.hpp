@@ -0,0 +1,34 @@
+#pragma once
+
+#include "SignedDistanceField.hpp"
+
+#include <atlas/utils/Geometry.hpp>
+#include <atlas/gl/Buffer.hpp>
+#include <atlas/gl/VertexArrayObject.hpp>
+
+#include <string>
+
+namespace bns
+{
+    // Static scene mesh that boids steer around. The mesh is baked into a
+    // signed distance field in world space when it is loaded.
+    class Obstacle : public atlas::utils::Geometry
+    {
+    public:
+        Obstacle(std::string const& meshFile, atlas::math::Matrix4 const& model);
+
+        void renderGeometry(atlas::math::Matrix4 const& projection,
+            atlas::math::Matrix4 const& view) override;
+
+        SignedDistanceField const& getField() const;
+
+    private:
+        atlas::gl::Buffer mVertexBuffer;
+        atlas::gl::Buffer mIndexBuffer;
+        atlas::gl::VertexArrayObject mVao;
+
+        GLsizei mIndexCount;
+
+        SignedDistanceField mField;
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atlas/math/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bns
+{
+    struct OctreeNode
+    {
+        atlas::math::Point center;
+        float halfSize;
+        // Index of the first of eight consecutive children, or 0 for a leaf
+        // (the root is node 0, so it can never be anyone's child).
+        std::uint32_t firstChild;
+        // Range of getIndices() holding the points inside this node.
+        std::uint32_t begin;
+        std::uint32_t end;
+    };
+
+    // Octree over a set of points, stored as a flat array of nodes with every
+    // child after its parent. Aggregates such as centres of mass are kept by
+    // the caller in arrays indexed like the nodes and can be filled bottom-up
+    // by walking the nodes in reverse.
+    class Octree
+    {
+    public:
+        Octree();
+
+        void build(std::vector<atlas::math::Point> const& points,
+            std::size_t leafSize);
+
+        std::vector<OctreeNode> const& getNodes() const;
+        // Point indices, grouped so that each node's points are contiguous.
+        std::vector<std::uint32_t> const& getIndices() const;
+
+        // Depth-first walk from the root; visit(nodeIndex, node) returns
+        // whether to descend into that node's children.
+        template <typename Visitor>
+        void traverse(Visitor&& visit) const
+        {
+            if (mNodes.empty())
+            {
+                return;
+            }
+
+            std::uint32_t stack[MaxDepth * 8 + 1];
+            int top = 0;
+            stack[top++] = 0;
+            while (top > 0)
+            {
+                std::uint32_t index = stack[--top];
+                OctreeNode const& node = mNodes[index];
+                if (visit(index, node) && node.firstChild != 0)
+                {
+                    for (std::uint32_t c = 0; c < 8; ++c)
+                    {
+                        stack[top++] = node.firstChild + c;
+                    }
+                }
+            }
+        }
+
+    private:
+        // Points closer together than the root size / 2^MaxDepth stay in a
+        // shared leaf rather than splitting forever.
+        static constexpr int MaxDepth = 20;
+
+        void split(std::uint32_t nodeIndex, int depth,
+            std::vector<atlas::math::Point> const& points,
+            std::size_t leafSize);
+
+        std::vector<OctreeNode> mNodes;
+        std::vector<std::uint32_t> mIndices;
+        std::vector<std::uint32_t> mScratch;
+    };
+}
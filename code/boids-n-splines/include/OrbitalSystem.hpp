@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Octree.hpp"
+#include "ThreadPool.hpp"
+
+#include <atlas/math/Math.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bns
+{
+    struct OrbitalParameters
+    {
+        // Every body orbits a fixed central mass at the origin.
+        float gravity = 1.0f;
+        float centralMass = 100.0f;
+        // Keeps close encounters from producing unbounded accelerations.
+        float softening = 0.1f;
+
+        // Whether the bodies also attract each other. Pairs are summed
+        // through a Barnes-Hut octree: a distant node whose width over its
+        // distance is below openingAngle acts as one body at its centre of
+        // mass.
+        bool mutualGravity = false;
+        float openingAngle = 0.6f;
+        std::size_t leafSize = 8;
+
+        // Threads for the acceleration pass; 0 uses every hardware thread.
+        int threadCount = 1;
+    };
+
+    // Many bodies orbiting one central mass, integrated together. Bodies are
+    // stored as separate arrays per component (structure of arrays), so the
+    // integration loops stream through memory and the renderer can pack
+    // exactly what it needs. Steps use kick-drift-kick leapfrog, which is
+    // symplectic: orbits keep their energy over long runs instead of
+    // spiralling in or out as they would under explicit Euler.
+    class OrbitalSystem
+    {
+    public:
+        OrbitalSystem(OrbitalParameters const& params = OrbitalParameters());
+
+        void clear();
+        void addBody(atlas::math::Point const& position,
+            atlas::math::Vector const& velocity, float mass, float radius);
+
+        // Replaces the bodies with count on circular orbits in a thin disc
+        // between innerRadius and outerRadius, sharing totalMass.
+        void scatterDisc(std::size_t count, float innerRadius,
+            float outerRadius, float totalMass, std::uint32_t seed);
+
+        void step(float dt);
+
+        void setMutualGravity(bool enabled);
+        OrbitalParameters const& getParameters() const;
+
+        std::size_t getBodyCount() const;
+        std::vector<float> const& getX() const;
+        std::vector<float> const& getY() const;
+        std::vector<float> const& getZ() const;
+        std::vector<float> const& getRadii() const;
+
+        // Kinetic plus potential energy, for checking the integration. The
+        // mutual part is summed exactly, so this is O(N^2) with mutual
+        // gravity on.
+        double computeEnergy() const;
+
+    private:
+        // Per node of the octree.
+        struct NodeMass
+        {
+            float mass;
+            atlas::math::Point centre;
+        };
+
+        void computeAccelerations();
+        void buildTree();
+        void accumulateMutual(std::size_t index, atlas::math::Vector& sum)
+            const;
+
+        OrbitalParameters mParams;
+
+        std::vector<float> mX;
+        std::vector<float> mY;
+        std::vector<float> mZ;
+        std::vector<float> mVx;
+        std::vector<float> mVy;
+        std::vector<float> mVz;
+        std::vector<float> mAx;
+        std::vector<float> mAy;
+        std::vector<float> mAz;
+        std::vector<float> mMass;
+        std::vector<float> mRadius;
+        // Accelerations carry over from one step's last kick to the next
+        // step's first; false until they have been computed for the
+        // current bodies and settings.
+        bool mAccelerationsValid;
+
+        Octree mTree;
+        std::vector<atlas::math::Point> mPoints;
+        std::vector<NodeMass> mNodeMasses;
+        std::unique_ptr<ThreadPool> mPool;
+    };
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "FlockMetrics.hpp"
+#include "FlockParameters.hpp"
+#include "StepTuner.hpp"
+
+#include <string>
+#include <vector>
+
+namespace bns
+{
+    struct SweepResult
+    {
+        FlockParameters params;
+        FlockMetrics metrics;
+        double meanStepMilliseconds;
+        double maxStepMilliseconds;
+        // Where the tuner ended up, for runs with FlockParameters::autoTune.
+        TunerStatus tuner;
+    };
+
+    // Runs every combination of the values listed in a sweep specification
+    // as an independent headless simulation. A specification is a text file
+    // of `name = values` lines, where values is either a comma separated list
+    // or a `start:stop:step` range, for example:
+    //
+    //     # 600 steps per run, metrics averaged every 10 steps of the
+    //     # second half
+    //     steps = 600
+    //     sampleEvery = 10
+    //     alignmentWeight = 50, 100, 200
+    //     viewRadius = 0.5:2.0:0.5
+    //
+    // Parameter names match the fields of FlockParameters.
+    class ParameterSweep
+    {
+    public:
+        ParameterSweep();
+
+        bool loadSpecification(std::string const& path);
+
+        void run(unsigned threadCount);
+
+        bool writeResults(std::string const& path) const;
+
+        std::size_t getRunCount() const;
+
+    private:
+        SweepResult runOne(FlockParameters const& params) const;
+
+        int mSteps;
+        int mSampleEvery;
+        std::vector<FlockParameters> mRuns;
+        std::vector<SweepResult> mResults;
+    };
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "OrbitalSystem.hpp"
+
+#include <atlas/utils/Geometry.hpp>
+#include <atlas/gl/Buffer.hpp>
+#include <atlas/gl/VertexArrayObject.hpp>
+
+#include <memory_resource>
+
+namespace bns
+{
+    // Per-instance data for the instanced planet draw.
+    struct PlanetInstance
+    {
+        // Centre in xyz, radius in w.
+        atlas::math::Vector4 sphere;
+        atlas::math::Vector colour;
+    };
+
+    // A field of planets orbiting the origin, drawn with one instanced draw
+    // of a single sphere mesh however many bodies there are. The vertex
+    // shader scales and offsets the sphere itself, so an instance is just
+    // its centre, radius and colour.
+    class PlanetField : public atlas::utils::Geometry
+    {
+    public:
+        // The instance data is packed in frameMemory, which must stay valid
+        // until the frame ends.
+        PlanetField(std::pmr::memory_resource* frameMemory =
+            std::pmr::get_default_resource());
+
+        void updateGeometry(atlas::core::Time<> const& t) override;
+
+        // Same as prepareFrame() followed by renderView().
+        void renderGeometry(atlas::math::Matrix4 const& projection,
+            atlas::math::Matrix4 const& view) override;
+
+        // Packs and uploads this frame's instances once for every view
+        // drawn after it.
+        void prepareFrame();
+        // Draws the instances of the last prepareFrame().
+        void renderView(atlas::math::Matrix4 const& projection,
+            atlas::math::Matrix4 const& view);
+
+        // Scatters a fresh disc of the current body count.
+        void resetGeometry() override;
+
+        int getBodyCount() const;
+        void setBodyCount(int count);
+
+        // Wraps every body in the given texture, tinted by its colour; 0
+        // shades the bodies in flat colour.
+        void setTexture(GLuint texture);
+
+        OrbitalSystem& getSystem();
+
+    private:
+        atlas::gl::Buffer mVertexBuffer;
+        atlas::gl::Buffer mIndexBuffer;
+        atlas::gl::Buffer mInstanceBuffer;
+        atlas::gl::VertexArrayObject mVao;
+
+        GLsizei mIndexCount;
+        GLsizei mInstanceCount;
+        GLuint mTexture;
+        std::pmr::memory_resource* mFrameMemory;
+
+        int mBodyCount;
+        OrbitalSystem mSystem;
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atlas/math/Math.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace bns
+{
+    // Signed distance to a closed triangle mesh, baked onto a regular grid
+    // once so that queries cost the same regardless of how many triangles
+    // the mesh has. Distances are negative inside the mesh.
+    class SignedDistanceField
+    {
+    public:
+        SignedDistanceField();
+
+        // Bakes the field over the mesh bounds grown by padding on every
+        // side. Vertices are expected in world space.
+        void bake(std::vector<atlas::math::Point> const& vertices,
+            std::vector<std::uint32_t> const& indices, float cellSize,
+            float padding);
+
+        bool isEmpty() const;
+
+        // Trilinearly interpolated distance and its gradient at point. Points
+        // outside the baked volume report `far` and a zero gradient.
+        float sample(atlas::math::Point const& point,
+            atlas::math::Vector& gradient, float far) const;
+
+    private:
+        float at(int x, int y, int z) const;
+
+        atlas::math::Point mOrigin;
+        float mCellSize;
+        int mSize[3];
+        std::vector<float> mDistances;
+    };
+}
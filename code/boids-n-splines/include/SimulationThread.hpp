@@ -0,0 +1,124 @@
+#pragma once
+
+#include "FlockSimulation.hpp"
+#include "Telemetry.hpp"
+#include "TripleBuffer.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bns
+{
+    enum class SimCommandType
+    {
+        Step,
+        Reset,
+        Seek,
+        SetObstacles,
+        SetSpecies,
+        SetFarField,
+        SetCollisions,
+        SetThreads,
+        SetAutoTune,
+        SetIntegrator
+    };
+
+    struct SimCommand
+    {
+        SimCommandType type;
+        std::uint64_t frame;
+        SignedDistanceField const* obstacles;
+        // Species count for SetSpecies, thread count for SetThreads,
+        // IntegratorType for SetIntegrator.
+        int count;
+        // Switch for SetFarField, SetCollisions and SetAutoTune.
+        bool enabled;
+        // Seconds of flock time for Step; 0 keeps the current time step.
+        float seconds;
+
+        // One per command type, with the fields it does not use zeroed.
+        static SimCommand step(float seconds);
+        static SimCommand reset();
+        static SimCommand seek(std::uint64_t frame);
+        static SimCommand setObstacles(SignedDistanceField const* obstacles);
+        static SimCommand setSpecies(int count);
+        static SimCommand setFarField(bool enabled);
+        static SimCommand setCollisions(bool enabled);
+        static SimCommand setThreads(int count);
+        static SimCommand setAutoTune(bool enabled);
+        static SimCommand setIntegrator(IntegratorType integrator);
+    };
+
+    struct FlockSnapshot
+    {
+        std::vector<Boid> boids;
+        std::vector<std::uint32_t> slots;
+        std::uint64_t frame;
+        FlockMetrics metrics;
+        LoadBalanceStats loadBalance;
+        TunerStatus tuner;
+    };
+
+    void executeCommand(FlockSimulation& simulation, SimCommand const& command);
+
+    // Metrics the simulation thread records into; any of them may be null.
+    struct SimulationInstruments
+    {
+        Histogram* stepSeconds = nullptr;
+        Counter* droppedSteps = nullptr;
+        Gauge* queueDepth = nullptr;
+    };
+
+    // Runs a FlockSimulation on its own thread. The scene posts commands
+    // (steps, resets) and draws whichever snapshot was completed last, so
+    // step N + 1 overlaps with rendering step N.
+    class SimulationThread
+    {
+    public:
+        SimulationThread(FlockSimulation& simulation);
+        ~SimulationThread();
+
+        void start();
+        // Joins the thread, then applies any queued command other than a
+        // step on the calling thread.
+        void stop();
+        bool isRunning() const;
+
+        void post(SimCommand const& command);
+
+        // Only call while the thread is stopped.
+        void setInstruments(SimulationInstruments const& instruments);
+
+        // Consumer side; only call from the render thread.
+        FlockSnapshot const& acquireSnapshot();
+
+    private:
+        void run();
+        void publishSnapshot();
+        // Call these with mMutex held.
+        void updateQueueDepth();
+        void pushCommand(SimCommand const& command);
+        SimCommand popCommand();
+
+        FlockSimulation& mSimulation;
+        TripleBuffer<FlockSnapshot> mSnapshots;
+
+        std::thread mThread;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        // Pending commands as a ring buffer, oldest at mCommandHead. Its
+        // storage is reserved up front and only grows if the HUD manages
+        // to queue more settings changes than that between two steps.
+        std::vector<SimCommand> mCommands;
+        std::size_t mCommandHead;
+        std::size_t mCommandCount;
+        int mPendingSteps;
+        bool mStopRequested;
+        std::atomic<bool> mRunning;
+        SimulationInstruments mInstruments;
+    };
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Boid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bns
+{
+    // Uniform grid over boid positions, hashed so that the world does not
+    // need bounds. Boid indices are bucketed with a counting sort into one
+    // flat array, so a rebuild does no allocation once the buffers have grown
+    // to size.
+    class SpatialGrid
+    {
+    public:
+        SpatialGrid();
+
+        void build(std::vector<Boid> const& boids, float cellSize);
+
+        float getCellSize() const;
+
+        // Calls visit(index) for every boid in the 3x3x3 block of cells
+        // around point; that covers everything within one cell size of it.
+        // Candidates still need a distance test.
+        template <typename Visitor>
+        void forEachNear(atlas::math::Point const& point, Visitor&& visit) const
+        {
+            int cx, cy, cz;
+            getCell(point, cx, cy, cz);
+
+            // Distinct cells can hash to the same bucket; visit each once.
+            std::size_t visited[27];
+            int visitedCount = 0;
+
+            for (int dz = -1; dz <= 1; ++dz)
+            {
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        std::size_t bucket = hashCell(cx + dx, cy + dy, cz + dz);
+
+                        bool seen = false;
+                        for (int v = 0; v < visitedCount; ++v)
+                        {
+                            seen = seen || (visited[v] == bucket);
+                        }
+                        if (seen)
+                        {
+                            continue;
+                        }
+                        visited[visitedCount++] = bucket;
+
+                        for (std::uint32_t k = mBucketStart[bucket];
+                            k < mBucketStart[bucket + 1]; ++k)
+                        {
+                            visit(mIndices[k]);
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        void getCell(atlas::math::Point const& point, int& x, int& y,
+            int& z) const;
+        std::size_t hashCell(int x, int y, int z) const;
+
+        float mCellSize;
+        float mInverseCellSize;
+        std::size_t mBucketMask;
+        std::vector<std::uint32_t> mBucketStart;
+        std::vector<std::uint32_t> mIndices;
+        std::vector<std::uint32_t> mBucketOf;
+    };
+}
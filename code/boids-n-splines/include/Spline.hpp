@@ -1,15 +1,23 @@
 #pragma once
 
+#include "SplineCurve.hpp"
+
 #include <atlas/utils/Geometry.hpp>
 #include <atlas/gl/Buffer.hpp>
 #include <atlas/gl/VertexArrayObject.hpp>
 
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+
 namespace bns
 {
     class Spline : public atlas::utils::Geometry
     {
     public:
-        Spline(int totalFrames);
+        // Scratch used while building the curve is taken from frameMemory.
+        Spline(int totalFrames, std::pmr::memory_resource* frameMemory =
+            std::pmr::get_default_resource());
 
         void updateGeometry(atlas::core::Time<> const& t) override;
         void renderGeometry(atlas::math::Matrix4 const& projection,
@@ -17,22 +25,42 @@ namespace bns
         void drawGui() override;
 
         void resetGeometry();
+        void setFrame(int frame);
 
         atlas::math::Point getPosition() const;
         bool doneInterpolation() const;
 
-    private:
-        atlas::math::Point interpolateOnSpline() const;
+        // Draws the curve as a polyline refined for each view (see
+        // SplineCurve::tessellate) rather than the uniform samples.
+        void setAdaptive(bool enabled);
+        bool getAdaptive() const;
 
-        atlas::math::Point evaluateSpline(float t) const;
-        void generateArcLengthTable();
-        int tableLookUp(float distance) const;
-        float chooseEpsilon() const;
+    private:
+        // A tessellation for one camera, kept in its own range of the
+        // spline buffer. Each camera mode draws the curve every frame, so
+        // there is a slot per view that can be on screen at once.
+        struct TessellationSlot
+        {
+            atlas::math::Matrix4 projection;
+            atlas::math::Point eye;
+            atlas::math::Vector look;
+            float viewportWidth;
+            float viewportHeight;
+            GLsizei count;
+            std::uint64_t lastUsed;
+        };
+        static constexpr std::size_t TessellationSlotCount = 3;
 
-        atlas::math::Matrix4 mBasisMatrix;
-        std::vector<atlas::math::Point> mControlPoints;
+        atlas::math::Point interpolateOnSpline() const;
+        // Returns the slot holding a tessellation for this view, refining
+        // the curve again only if no slot was made from a camera close
+        // enough to this one.
+        TessellationSlot const& tessellateForView(
+            atlas::math::Matrix4 const& projection,
+            atlas::math::Matrix4 const& view);
+        GLint getSlotFirst(TessellationSlot const& slot) const;
 
-        std::vector<float> mTable;
+        SplineCurve mCurve;
 
         atlas::math::Point mSplinePosition;
 
@@ -41,7 +69,6 @@ namespace bns
         atlas::gl::Buffer mControlBuffer;
         atlas::gl::Buffer mSplineBuffer;
 
-        int mResolution;
         int mTotalFrames;
         int mCurrentFrame;
 
@@ -50,5 +77,12 @@ namespace bns
         bool mShowSplinePoints;
         bool mShowSpline;
         bool mIsInterpolationDone;
+
+        std::array<TessellationSlot, TessellationSlotCount> mSlots;
+        std::vector<atlas::math::Point> mTessellation;
+        atlas::math::Point mCurveCentre;
+        std::uint64_t mDrawCount;
+        int mRefineCount;
+        bool mAdaptive;
     };
 }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atlas/math/Math.hpp>
+
+#include <vector>
+
+namespace bns
+{
+    // SplineCurve::tessellate halves each segment at most this many times.
+    constexpr int MaxTessellationDepth = 8;
+
+    // A cubic Bezier curve through four control points, sampled at a fixed
+    // resolution into an arc length table so it can be travelled at
+    // constant speed. Holds no GL state, so it can be used (and timed)
+    // without a context.
+    class SplineCurve
+    {
+    public:
+        SplineCurve(std::vector<atlas::math::Point> const& controlPoints,
+            int resolution);
+
+        atlas::math::Point evaluateSpline(float t) const;
+        void generateArcLengthTable();
+        // Index of a table entry within one sample spacing of distance, or
+        // -1.
+        int tableLookUp(float distance) const;
+
+        // Replaces points with a polyline along the curve as seen through
+        // clip (projection * view) on a viewport of the given size in
+        // pixels. The curve is cut into segments uniform spans, and a span
+        // is halved while its midpoint strays more than pixelTolerance
+        // pixels off the drawn chord, or while it bends sharply and still
+        // covers more than a few pixels. Spans behind the camera are only
+        // split for bending. Straight or distant stretches thus get few
+        // vertices and close, tight bends many.
+        void tessellate(atlas::math::Matrix4 const& clip,
+            float viewportWidth, float viewportHeight, float pixelTolerance,
+            int segments, std::vector<atlas::math::Point>& points) const;
+
+        // Arc length over the whole curve.
+        float getLength() const;
+        int getResolution() const;
+        std::vector<atlas::math::Point> const& getControlPoints() const;
+
+    private:
+        float chooseEpsilon() const;
+
+        struct ScreenPoint
+        {
+            atlas::math::Point world;
+            float x;
+            float y;
+            // False behind the camera, where x and y mean nothing.
+            bool visible;
+        };
+
+        void refine(float t0, ScreenPoint const& p0, float t1,
+            ScreenPoint const& p1, int depth,
+            atlas::math::Matrix4 const& clip, float halfWidth,
+            float halfHeight, float pixelTolerance,
+            std::vector<atlas::math::Point>& points) const;
+
+        atlas::math::Matrix4 mBasisMatrix;
+        std::vector<atlas::math::Point> mControlPoints;
+
+        std::vector<float> mTable;
+        int mResolution;
+    };
+}
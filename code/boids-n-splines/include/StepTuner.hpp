@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace bns
+{
+    // The knobs that change how fast a step runs but not what it computes.
+    struct TunedSettings
+    {
+        float neighbourSkin;
+        int threadCount;
+        int partsPerThread;
+    };
+
+    struct TunerStatus
+    {
+        bool locked;
+        TunedSettings settings;
+        // Candidate being timed, out of how many in the current search.
+        std::size_t candidate;
+        std::size_t candidateCount;
+        // Mean step time of the locked-in settings.
+        float milliseconds;
+        int retunes;
+    };
+
+    // Picks the fastest step settings for the machine and flock at hand by
+    // timing real steps. The search goes one knob at a time (threads, then
+    // parts per thread, then neighbour skin), giving every candidate a
+    // short run of steps and keeping the fastest before moving on to the
+    // next knob. Once all knobs are settled the settings stay locked until
+    // the neighbour density drifts far enough from what it was at lock-in
+    // that the choice is likely stale, at which point the search restarts.
+    class StepTuner
+    {
+    public:
+        StepTuner();
+
+        // Starts a fresh search from initial. Skin candidates are fractions
+        // of queryRadius; thread candidates go up to hardwareThreads.
+        void start(TunedSettings const& initial, float queryRadius,
+            unsigned hardwareThreads);
+        bool isStarted() const;
+        bool isLocked() const;
+
+        // Settings the next step should run with.
+        TunedSettings const& getSettings() const;
+        TunerStatus getStatus() const;
+
+        // Feeds the time of one step run with getSettings() and the mean
+        // number of neighbours per boid it saw.
+        void record(double milliseconds, float density);
+
+    private:
+        enum class Knob
+        {
+            Threads,
+            Parts,
+            Skin,
+            Done
+        };
+
+        void beginKnob(Knob knob);
+        void applyCandidate();
+        void lock();
+
+        Knob mKnob;
+        std::vector<float> mCandidates;
+        std::size_t mCandidate;
+        std::size_t mSamples;
+        double mTotal;
+        double mBestTotal;
+        std::size_t mBestCandidate;
+
+        TunedSettings mBest;
+        TunedSettings mSettings;
+        float mQueryRadius;
+        unsigned mHardwareThreads;
+        float mMilliseconds;
+        int mRetunes;
+
+        // Running density after lock-in, and what it was when locked.
+        float mDensity;
+        float mLockedDensity;
+        std::size_t mLockedSamples;
+    };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace bns
+{
+    // Instruments for live metrics. Updates are single relaxed atomic
+    // operations, so the frame and simulation threads can record into them
+    // freely while the telemetry server reads them from its own thread.
+    class Metric
+    {
+    public:
+        Metric(std::string const& name, std::string const& help);
+        virtual ~Metric() = default;
+
+        Metric(Metric const&) = delete;
+        Metric& operator=(Metric const&) = delete;
+
+        // Appends the metric in the Prometheus text exposition format.
+        virtual void write(std::string& out) const = 0;
+
+    protected:
+        void writeHeader(std::string& out, char const* type) const;
+
+        std::string mName;
+        std::string mHelp;
+    };
+
+    class Counter : public Metric
+    {
+    public:
+        Counter(std::string const& name, std::string const& help);
+
+        void add(std::uint64_t amount = 1)
+        {
+            mValue.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        std::uint64_t get() const;
+        void write(std::string& out) const override;
+
+    private:
+        std::atomic<std::uint64_t> mValue;
+    };
+
+    class Gauge : public Metric
+    {
+    public:
+        Gauge(std::string const& name, std::string const& help);
+
+        void set(double value)
+        {
+            mValue.store(value, std::memory_order_relaxed);
+        }
+
+        double get() const;
+        void write(std::string& out) const override;
+
+    private:
+        std::atomic<double> mValue;
+    };
+
+    // Counts observations into fixed buckets given by their upper bounds.
+    class Histogram : public Metric
+    {
+    public:
+        Histogram(std::string const& name, std::string const& help,
+            std::vector<double> const& bounds);
+
+        void observe(double value);
+
+        void write(std::string& out) const override;
+
+    private:
+        std::vector<double> mBounds;
+        // One count per bound, plus the overflow bucket.
+        std::unique_ptr<std::atomic<std::uint64_t>[]> mCounts;
+        std::atomic<double> mSum;
+    };
+
+    // count bounds starting at start, each factor times the last.
+    std::vector<double> exponentialBuckets(double start, double factor,
+        int count);
+
+    // Owns every metric of the process. Registration and rendering take a
+    // lock; recording into an instrument never does.
+    class MetricsRegistry
+    {
+    public:
+        Counter& addCounter(std::string const& name, std::string const& help);
+        Gauge& addGauge(std::string const& name, std::string const& help);
+        Histogram& addHistogram(std::string const& name,
+            std::string const& help, std::vector<double> const& bounds);
+
+        std::string render() const;
+
+    private:
+        mutable std::mutex mMutex;
+        std::vector<std::unique_ptr<Metric>> mMetrics;
+    };
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Telemetry.hpp"
+#include "Transport.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace bns
+{
+    // Default endpoint of the viewer's metrics, overridden by the
+    // BNS_TELEMETRY_ADDRESS environment variable (see parseAddress for the
+    // format).
+    constexpr char TelemetryDefaultAddress[] = "tcp:127.0.0.1:9464";
+
+    // Serves a MetricsRegistry as a Prometheus scrape target: any HTTP GET
+    // on the address returns the current metrics as text. Requests are
+    // answered one at a time on a background thread, which only reads the
+    // instruments, so scraping never holds up the threads that record them.
+    class TelemetryServer
+    {
+    public:
+        explicit TelemetryServer(MetricsRegistry const& registry);
+        ~TelemetryServer();
+
+        TelemetryServer(TelemetryServer const&) = delete;
+        TelemetryServer& operator=(TelemetryServer const&) = delete;
+
+        bool start(Address const& address);
+        void stop();
+        bool isRunning() const;
+
+        std::uint64_t getScrapeCount() const;
+
+    private:
+        void run();
+        void serve(Connection& connection);
+
+        MetricsRegistry const& mRegistry;
+        Listener mListener;
+        std::thread mThread;
+        std::atomic<bool> mStopRequested;
+        std::atomic<std::uint64_t> mScrapes;
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "MipChain.hpp"
+
+#include <atlas/gl/GL.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace bns
+{
+    // Loads image textures shared by path. Images are decoded on worker
+    // threads, so asking for a texture never blocks: acquire() hands back a
+    // texture name at once, showing a flat placeholder, and update() later
+    // uploads the real image into that same name through a pixel unpack
+    // buffer. Asking for the same path again gives the same texture.
+    //
+    // With a cache directory, decoded mip chains are also written to disk
+    // and read back on later runs instead of decoding and filtering the
+    // image again.
+    class TextureCache
+    {
+    public:
+        // An empty cacheDirectory turns the disk cache off.
+        explicit TextureCache(unsigned threadCount = 2,
+            std::string const& cacheDirectory = "");
+        ~TextureCache();
+
+        TextureCache(TextureCache const&) = delete;
+        TextureCache& operator=(TextureCache const&) = delete;
+
+        // Needs a current GL context, as do update() and the destructor.
+        GLuint acquire(std::string const& path);
+
+        // Uploads finished images, stopping once about byteBudget bytes
+        // have gone up this call so a burst of loads is spread over a few
+        // frames rather than stalling one. Call once per frame.
+        void update(std::size_t byteBudget = 16 * 1024 * 1024);
+
+        // Whether the image at path has been uploaded.
+        bool isReady(std::string const& path) const;
+
+        std::size_t getTextureCount() const;
+        // Textures still showing the placeholder (not failed).
+        std::size_t getPendingCount() const;
+        std::size_t getCacheHits() const;
+
+    private:
+        enum class State
+        {
+            Pending,
+            Ready,
+            Failed
+        };
+
+        struct Entry
+        {
+            std::string path;
+            GLuint texture;
+            State state;
+        };
+
+        struct Request
+        {
+            std::size_t entry;
+            std::string path;
+        };
+
+        struct Decoded
+        {
+            std::size_t entry;
+            bool valid;
+            MipChain chain;
+        };
+
+        void run();
+        void upload(Entry& entry, MipChain const& chain);
+
+        std::string mCacheDirectory;
+
+        std::vector<Entry> mEntries;
+        std::unordered_map<std::string, std::size_t> mByPath;
+        std::size_t mPendingCount;
+
+        GLuint mUnpackBuffer;
+
+        // Guards everything below, shared with the workers.
+        mutable std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<Request> mRequests;
+        std::deque<Decoded> mDecoded;
+        std::size_t mCacheHits;
+        bool mStopRequested;
+        std::vector<std::thread> mWorkers;
+    };
+}
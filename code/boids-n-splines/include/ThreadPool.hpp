@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bns
+{
+    // Fixed set of worker threads for data-parallel loops. run() hands out
+    // task indices to the workers and to the calling thread, which counts as
+    // one of the threads, and returns once every task has finished. Tasks
+    // are also told which thread runs them (the caller is thread 0), so
+    // they can keep per-thread scratch.
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(unsigned threadCount);
+        ~ThreadPool();
+
+        ThreadPool(ThreadPool const&) = delete;
+        ThreadPool& operator=(ThreadPool const&) = delete;
+
+        unsigned getThreadCount() const;
+
+        // Not reentrant: tasks must not call run() on the same pool. task is
+        // any callable taking (task index, thread). It is only referenced
+        // while run() lasts, never copied, so capturing lambdas cost no
+        // allocation.
+        template <typename Task>
+        void run(std::size_t taskCount, Task const& task)
+        {
+            dispatch(taskCount, &task,
+                [](void const* callable, std::size_t index, unsigned thread)
+            {
+                (*static_cast<Task const*>(callable))(index, thread);
+            });
+        }
+
+    private:
+        using TaskFunction = void (*)(void const*, std::size_t, unsigned);
+
+        void dispatch(std::size_t taskCount, void const* task,
+            TaskFunction function);
+        void work(unsigned thread);
+        void runTasks(unsigned thread);
+
+        std::vector<std::thread> mThreads;
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::condition_variable mDone;
+
+        void const* mTask;
+        TaskFunction mTaskFunction;
+        std::size_t mTaskCount;
+        std::atomic<std::size_t> mNextTask;
+        // Bumped by every run() so sleeping workers can tell a new batch
+        // from a spurious wake-up.
+        std::uint64_t mGeneration;
+        unsigned mBusyWorkers;
+        bool mStopping;
+    };
+}
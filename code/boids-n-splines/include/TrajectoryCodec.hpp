@@ -0,0 +1,88 @@
+#pragma once
+
+#include "FlockSimulation.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bns
+{
+    // On-disk layout of a trajectory recording:
+    //
+    //   TrajectoryFileHeader
+    //   { TrajectoryChunkHeader, { uint32 blockSize, block } * frameCount } *
+    //   block = uint32 planeSize[6], plane bytes * 6
+    //
+    // Positions are quantised to 16 bits against the bounding box of their
+    // chunk and forward vectors to 16 bits against [-1, 1]. Each frame stores
+    // the per-component difference to the previous frame of the same chunk
+    // (the first frame is stored against zero), one component plane at a
+    // time, zigzag + varint encoded and then run-length coded on zero bytes.
+    // Every block can be decoded on its own given the previous frame, so
+    // replay never inflates more than one frame at a time, and the six planes
+    // of a block can be decoded in parallel.
+    constexpr char TrajectoryMagic[8] = { 'B', 'N', 'S', 'T', 'R', 'A', 'J', '\0' };
+    constexpr std::uint32_t TrajectoryVersion = 1;
+
+    struct TrajectoryFileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t boidCount;
+        std::uint32_t framesPerChunk;
+        float boidRadius;
+    };
+
+    struct TrajectoryChunkHeader
+    {
+        std::uint32_t firstFrame;
+        std::uint32_t frameCount;
+        float boundsMin[3];
+        float boundsMax[3];
+        std::uint32_t payloadSize;
+    };
+
+    // Quantised state of one frame, stored as six planes of boidCount values:
+    // position x, y, z (unsigned, against the chunk bounds) followed by
+    // forward x, y, z (signed, stored as their two's complement bits).
+    using QuantisedFrame = std::vector<std::uint16_t>;
+
+    constexpr std::size_t QuantisedComponents = 6;
+
+    void quantiseBoid(atlas::math::Vector const& position,
+        atlas::math::Vector const& forward, atlas::math::Vector const& boundsMin,
+        atlas::math::Vector const& boundsExtent, std::size_t index,
+        QuantisedFrame& frame);
+
+    // Writes boids [begin, end) from frame.
+    void dequantiseFrame(QuantisedFrame const& frame, std::size_t begin,
+        std::size_t end, atlas::math::Vector const& boundsMin,
+        atlas::math::Vector const& boundsExtent, std::vector<Boid>& boids);
+
+    // Appends the encoded block for current (relative to previous) to out.
+    void encodeFrame(QuantisedFrame const& previous,
+        QuantisedFrame const& current, std::vector<std::uint8_t>& out);
+
+    struct FramePlane
+    {
+        std::uint8_t const* data;
+        std::size_t size;
+    };
+
+    using FramePlanes = std::array<FramePlane, QuantisedComponents>;
+
+    // Splits an encoded block into its component planes.
+    bool getFramePlanes(std::uint8_t const* data, std::size_t size,
+        FramePlanes& planes);
+
+    // Applies one encoded plane on top of count values.
+    bool decodePlane(FramePlane const& plane, std::uint16_t* values,
+        std::size_t count);
+
+    // Applies one encoded block on top of frame. Returns false if the block
+    // is truncated or malformed.
+    bool decodeFrame(std::uint8_t const* data, std::size_t size,
+        QuantisedFrame& frame);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "TrajectoryCodec.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bns
+{
+    // Streams per-frame boid state to a chunked trajectory file (see
+    // TrajectoryCodec.hpp). Frames are buffered until a chunk is full, since
+    // quantisation needs the chunk's bounding box; full chunks are encoded and
+    // written on a background thread while the next one fills up.
+    class TrajectoryRecorder
+    {
+    public:
+        TrajectoryRecorder();
+        ~TrajectoryRecorder();
+
+        bool open(std::string const& path, std::size_t boidCount,
+            float boidRadius, std::uint32_t framesPerChunk = 30);
+        void close();
+        bool isOpen() const;
+
+        void record(std::vector<Boid> const& boids);
+
+        std::uint32_t getFramesRecorded() const;
+
+    private:
+        struct PendingChunk
+        {
+            std::uint32_t firstFrame;
+            std::uint32_t frameCount;
+            atlas::math::Vector boundsMin;
+            atlas::math::Vector boundsMax;
+            std::vector<atlas::math::Vector> positions;
+            std::vector<atlas::math::Vector> forwards;
+        };
+
+        void flushChunk();
+        void writerLoop();
+        void writeChunk(PendingChunk const& chunk);
+
+        std::ofstream mFile;
+        std::size_t mBoidCount;
+        std::uint32_t mFramesPerChunk;
+        std::uint32_t mFramesRecorded;
+
+        PendingChunk mFilling;
+        PendingChunk mWriting;
+        QuantisedFrame mPrevious;
+        QuantisedFrame mCurrent;
+        std::vector<std::uint8_t> mBlock;
+        std::vector<std::uint8_t> mPayload;
+
+        std::thread mWriter;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mHasWork;
+        bool mStopRequested;
+    };
+}
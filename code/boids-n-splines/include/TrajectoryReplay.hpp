@@ -0,0 +1,83 @@
+#pragma once
+
+#include "TrajectoryCodec.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bns
+{
+    // Read-only memory mapping of a whole file.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        bool open(std::string const& path);
+        void close();
+
+        std::uint8_t const* getData() const;
+        std::size_t getSize() const;
+
+    private:
+        std::uint8_t const* mData;
+        std::size_t mSize;
+#ifdef _WIN32
+        void* mFileHandle;
+        void* mMappingHandle;
+#endif
+    };
+
+    // Plays back a recording made by TrajectoryRecorder. The file is memory
+    // mapped and decoded one frame at a time straight into a vector of boids
+    // that BoidFlock can draw in place of a live simulation.
+    class TrajectoryReplay
+    {
+    public:
+        TrajectoryReplay();
+
+        bool open(std::string const& path);
+        void close();
+        bool isOpen() const;
+
+        std::uint32_t getFrameCount() const;
+        std::uint32_t getCurrentFrame() const;
+
+        bool seek(std::uint32_t frame);
+
+        // Moves to the next frame; returns false once the end is reached.
+        bool advance();
+
+        std::vector<Boid> const& getBoids() const;
+
+    private:
+        struct ChunkEntry
+        {
+            TrajectoryChunkHeader header;
+            std::size_t payloadOffset;
+        };
+
+        void beginChunk(std::size_t chunk);
+        bool decodeNextFrame();
+        void dequantise();
+
+        MappedFile mFile;
+        TrajectoryFileHeader mHeader;
+        std::vector<ChunkEntry> mChunks;
+        std::uint32_t mFrameCount;
+
+        std::size_t mChunk;
+        std::uint32_t mFrameInChunk;
+        std::size_t mCursor;
+        std::uint32_t mCurrentFrame;
+
+        QuantisedFrame mState;
+        std::vector<Boid> mBoids;
+    };
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace bns
+{
+    // Where a stream endpoint lives. Written as "unix:<path>" for a Unix
+    // domain socket on this host, or "tcp:<host>:<port>" to go between hosts.
+    // Both are stream sockets, so everything above the address is shared.
+    struct Address
+    {
+        enum class Kind
+        {
+            Unix,
+            Tcp
+        };
+
+        Kind kind;
+        std::string path;
+        std::string host;
+        std::uint16_t port;
+    };
+
+    bool parseAddress(std::string const& text, Address& address);
+    std::string formatAddress(Address const& address);
+
+    // Flat byte buffer for building and reading messages. Values are copied
+    // in host byte order: every process in a run is the same build.
+    class MessageBuffer
+    {
+    public:
+        MessageBuffer();
+
+        void clear();
+
+        template <typename T>
+        void put(T const& value)
+        {
+            std::size_t offset = mData.size();
+            mData.resize(offset + sizeof(T));
+            std::memcpy(mData.data() + offset, &value, sizeof(T));
+        }
+
+        template <typename T>
+        void putArray(T const* values, std::size_t count)
+        {
+            std::size_t offset = mData.size();
+            mData.resize(offset + sizeof(T) * count);
+            std::memcpy(mData.data() + offset, values, sizeof(T) * count);
+        }
+
+        // Reads return false once the buffer runs out, and leave the value
+        // untouched.
+        template <typename T>
+        bool get(T& value)
+        {
+            if (mRead + sizeof(T) > mData.size())
+            {
+                return false;
+            }
+            std::memcpy(&value, mData.data() + mRead, sizeof(T));
+            mRead += sizeof(T);
+            return true;
+        }
+
+        template <typename T>
+        bool getArray(T* values, std::size_t count)
+        {
+            if (mRead + sizeof(T) * count > mData.size())
+            {
+                return false;
+            }
+            std::memcpy(values, mData.data() + mRead, sizeof(T) * count);
+            mRead += sizeof(T) * count;
+            return true;
+        }
+
+        std::vector<std::uint8_t>& getData();
+        std::vector<std::uint8_t> const& getData() const;
+
+    private:
+        std::vector<std::uint8_t> mData;
+        std::size_t mRead;
+    };
+
+    // One end of a connected stream socket. Messages are framed as a type and
+    // a length followed by the payload; sends and receives block until the
+    // whole message has gone through.
+    class Connection
+    {
+    public:
+        Connection();
+        explicit Connection(int socket);
+        ~Connection();
+
+        Connection(Connection&& other);
+        Connection& operator=(Connection&& other);
+        Connection(Connection const&) = delete;
+        Connection& operator=(Connection const&) = delete;
+
+        // Keeps retrying for up to timeoutMilliseconds, so a client may be
+        // started before the server it talks to is listening.
+        bool connect(Address const& address, int timeoutMilliseconds);
+        void close();
+        bool isOpen() const;
+
+        bool send(std::uint32_t type, MessageBuffer const& message);
+        bool receive(std::uint32_t& type, MessageBuffer& message);
+
+        // Unframed access for plain-text protocols. receiveSome returns as
+        // soon as any bytes arrive, with the count, or 0 once the peer has
+        // closed, an error occurred or the receive timeout ran out.
+        bool sendBytes(void const* data, std::size_t size);
+        std::size_t receiveSome(void* data, std::size_t size);
+        void setReceiveTimeout(int timeoutMilliseconds);
+
+    private:
+        bool sendAll(void const* data, std::size_t size);
+        bool receiveAll(void* data, std::size_t size);
+
+        int mSocket;
+    };
+
+    class Listener
+    {
+    public:
+        Listener();
+        ~Listener();
+
+        Listener(Listener const&) = delete;
+        Listener& operator=(Listener const&) = delete;
+
+        bool listen(Address const& address);
+        void close();
+
+        Connection accept();
+        // Gives up after timeoutMilliseconds and returns a closed Connection,
+        // so a serving thread can check whether it should stop.
+        Connection accept(int timeoutMilliseconds);
+
+    private:
+        int mSocket;
+        std::string mUnixPath;
+    };
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace bns
+{
+    // Single-producer, single-consumer triple buffer. The producer always owns
+    // a back buffer it can fill freely, the consumer always owns a front buffer
+    // it can read freely, and the middle slot is handed between them with one
+    // atomic exchange. Neither side ever blocks; the consumer simply sees the
+    // most recently published value.
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer() :
+            mMiddle(1),
+            mBack(0),
+            mFront(2)
+        { }
+
+        // Producer side.
+        T& getWriteBuffer()
+        {
+            return mBuffers[mBack];
+        }
+
+        void publish()
+        {
+            std::uint8_t old = mMiddle.exchange(
+                static_cast<std::uint8_t>(mBack | FreshBit),
+                std::memory_order_acq_rel);
+            mBack = old & IndexMask;
+        }
+
+        // Consumer side. Returns true if a newer value became visible.
+        bool update()
+        {
+            if ((mMiddle.load(std::memory_order_relaxed) & FreshBit) == 0)
+            {
+                return false;
+            }
+
+            std::uint8_t old = mMiddle.exchange(mFront,
+                std::memory_order_acq_rel);
+            mFront = old & IndexMask;
+            return true;
+        }
+
+        T const& getReadBuffer() const
+        {
+            return mBuffers[mFront];
+        }
+
+    private:
+        static constexpr std::uint8_t IndexMask = 0x3;
+        static constexpr std::uint8_t FreshBit = 0x4;
+
+        T mBuffers[3];
+        std::atomic<std::uint8_t> mMiddle;
+        std::uint8_t mBack;
+        std::uint8_t mFront;
+    };
+}
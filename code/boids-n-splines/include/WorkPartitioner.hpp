@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Boid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bns
+{
+    // Splits the flock into parts of roughly equal estimated work for the
+    // parallel force pass. Splitting by index or by fixed cells fails on
+    // clustered flocks, where a few dense clumps hold most of the neighbour
+    // pairs. Instead, the boids are cut recursively in an adaptive k-d
+    // fashion: each region is cut across its longest axis at the point where
+    // the summed cost on either side matches the share of parts it gets.
+    class WorkPartitioner
+    {
+    public:
+        WorkPartitioner();
+
+        // costs holds one estimate per boid (say, its neighbour count).
+        void partition(std::vector<Boid> const& boids,
+            std::vector<float> const& costs, std::size_t partCount);
+
+        std::size_t getPartCount() const;
+
+        // The boids of a part are getIndices()[getPartBegin(part)] up to
+        // getPartBegin(part + 1), and lie in one box of the k-d split.
+        std::vector<std::uint32_t> const& getIndices() const;
+        std::size_t getPartBegin(std::size_t part) const;
+        float getPartCost(std::size_t part) const;
+
+        // Largest part cost over the mean; 1 is a perfect split.
+        float getPredictedImbalance() const;
+
+    private:
+        void split(std::vector<Boid> const& boids,
+            std::vector<float> const& costs, std::size_t begin,
+            std::size_t end, std::size_t firstPart, std::size_t partCount);
+
+        // Coordinate along axis below which the first target of the total
+        // cost of [begin, end) lies.
+        float findCut(std::vector<Boid> const& boids,
+            std::vector<float> const& costs, std::size_t begin,
+            std::size_t end, int axis, float low, float high, float target);
+
+        std::vector<std::uint32_t> mIndices;
+        std::vector<std::size_t> mPartBegin;
+        std::vector<float> mPartCost;
+        std::vector<float> mBins;
+    };
+}
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Compares two bns-bench result files and flags regressions.
+
+usage: bench_compare.py <baseline.json> <current.json> [threshold]
+
+A case regresses when its median grows by more than threshold (a fraction,
+0.1 by default) over the baseline and the growth is also larger than the
+noise in both runs (twice the sum of their median absolute deviations).
+Exits with 1 if any case regressed, so it can gate a build.
+"""
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {case["name"]: case for case in json.load(f)["cases"]}
+
+
+def main(argv):
+    if len(argv) < 3:
+        print(__doc__.strip().splitlines()[2], file=sys.stderr)
+        return 2
+
+    baseline = load(argv[1])
+    current = load(argv[2])
+    threshold = float(argv[3]) if len(argv) > 3 else 0.1
+
+    regressions = 0
+    for name, case in current.items():
+        base = baseline.get(name)
+        if base is None:
+            print("%-28s %10.4f ms  (new)" % (name, case["median"]))
+            continue
+
+        change = case["median"] / base["median"] - 1.0
+        noise = 2.0 * (base["mad"] + case["mad"])
+        regressed = (change > threshold and
+                     case["median"] - base["median"] > noise)
+        faster = (change < -threshold and
+                  base["median"] - case["median"] > noise)
+        mark = "REGRESSION" if regressed else ("faster" if faster else "")
+        print("%-28s %10.4f -> %10.4f ms  %+7.1f%%  %s" %
+              (name, base["median"], case["median"], 100.0 * change, mark))
+        regressions += 1 if regressed else 0
+
+    for name in baseline:
+        if name not in current:
+            print("%-28s missing from %s" % (name, argv[2]))
+
+    if regressions > 0:
+        print("%d case(s) regressed by more than %.0f%%" %
+              (regressions, 100.0 * threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -16,6 +16,9 @@ out VertexData
 
 #include "UniformMatrices.glsl"
 
+// inverse(transpose(view * model)), worked out once per draw.
+uniform mat3 normalMatrix;
+
 void main()
 {
     gl_Position = projection * view * model * vec4(position, 1.0);
@@ -29,6 +32,6 @@ void main()
     vec3 lightPos = (view * vec4(outData.lightPosition, 1.0)).xyz;
     outData.lightDirection = lightPos + outData.eyeDirection;
 
-    outData.normal = (inverse(transpose(view * model)) * vec4(normal, 0)).xyz;
+    outData.normal = normalMatrix * normal;
 }
 
@@ -0,0 +1,21 @@
+#version 330 core
+
+in VertexData
+{
+    vec3 position;
+    vec3 normal;
+    vec3 eyeDirection;
+    vec3 lightDirection;
+    vec3 lightPosition;
+} inData;
+
+flat in vec3 colour;
+
+out vec4 fragColour;
+
+#include "Shading.glsl"
+
+void main()
+{
+    fragColour = vec4(shadedColour(colour), 1.0);
+}
@@ -0,0 +1,58 @@
+#version 330 core
+
+#include "LayoutLocations.glsl"
+layout(location = VERTICES_LAYOUT_LOCATION) in vec3 position;
+layout(location = NORMALS_LAYOUT_LOCATION) in vec3 normal;
+layout(location = TEXTURES_LAYOUT_LOCATION) in vec2 tex;
+layout(location = INSTANCE_POSITION_LAYOUT_LOCATION) in vec4 instancePosition;
+layout(location = INSTANCE_FORWARD_LAYOUT_LOCATION) in vec3 instanceForward;
+layout(location = INSTANCE_COLOUR_LAYOUT_LOCATION) in vec3 instanceColour;
+
+out VertexData
+{
+    vec3 position;
+    vec3 normal;
+    vec3 eyeDirection;
+    vec3 lightDirection;
+    vec3 lightPosition;
+} outData;
+
+flat out vec3 colour;
+
+#include "UniformMatrices.glsl"
+
+// Rotation taking +z onto the heading, keeping +y as close to up as it can.
+mat3 headingBasis(vec3 forward)
+{
+    float len = length(forward);
+    vec3 f = (len > 1e-6) ? forward / len : vec3(0, 0, 1);
+    vec3 side = cross(vec3(0, 1, 0), f);
+    float sideLen = length(side);
+    vec3 r = (sideLen > 1e-6) ? side / sideLen : vec3(1, 0, 0);
+    return mat3(r, cross(f, r), f);
+}
+
+void main()
+{
+    // The model transform is a rotation, a uniform scale and a translation,
+    // so the rotation is also the normal transform; the view is rigid, so
+    // its own upper 3x3 carries normals into eye space. Nothing needs
+    // inverting.
+    mat3 rotation = headingBasis(instanceForward);
+    vec3 worldPos = instancePosition.xyz +
+        rotation * (position * instancePosition.w);
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+
+    outData.position = worldPos;
+
+    vec3 vertexPos = (view * vec4(worldPos, 1.0)).xyz;
+    outData.eyeDirection = vec3(0, 0, 0) - vertexPos;
+
+    outData.lightPosition = vec3(0, 5, 0);
+    vec3 lightPos = (view * vec4(outData.lightPosition, 1.0)).xyz;
+    outData.lightDirection = lightPos + outData.eyeDirection;
+
+    outData.normal = mat3(view) * (rotation * normal);
+
+    colour = instanceColour;
+}
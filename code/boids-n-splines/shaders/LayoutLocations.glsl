@@ -5,4 +5,11 @@
 #define NORMALS_LAYOUT_LOCATION 1
 #define TEXTURES_LAYOUT_LOCATION 2
 
+// Per-instance attributes. Boids send a centre with a uniform scale and a
+// heading; planets send a centre and radius.
+#define INSTANCE_POSITION_LAYOUT_LOCATION 3
+#define INSTANCE_FORWARD_LAYOUT_LOCATION 4
+#define INSTANCE_SPHERE_LAYOUT_LOCATION 3
+#define INSTANCE_COLOUR_LAYOUT_LOCATION 7
+
 #endif
@@ -0,0 +1,26 @@
+#version 330 core
+
+in VertexData
+{
+    vec3 position;
+    vec3 normal;
+    vec3 eyeDirection;
+    vec3 lightDirection;
+    vec3 lightPosition;
+} inData;
+
+flat in vec3 colour;
+in vec2 uv;
+
+out vec4 fragColour;
+
+uniform sampler2D surface;
+uniform bool textured;
+
+#include "Shading.glsl"
+
+void main()
+{
+    vec3 albedo = textured ? colour * texture(surface, uv).rgb : colour;
+    fragColour = vec4(shadedColour(albedo), 1.0);
+}
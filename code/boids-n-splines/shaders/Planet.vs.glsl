@@ -0,0 +1,44 @@
+#version 330 core
+
+#include "LayoutLocations.glsl"
+layout(location = VERTICES_LAYOUT_LOCATION) in vec3 position;
+layout(location = NORMALS_LAYOUT_LOCATION) in vec3 normal;
+layout(location = TEXTURES_LAYOUT_LOCATION) in vec2 tex;
+layout(location = INSTANCE_SPHERE_LAYOUT_LOCATION) in vec4 instanceSphere;
+layout(location = INSTANCE_COLOUR_LAYOUT_LOCATION) in vec3 instanceColour;
+
+out VertexData
+{
+    vec3 position;
+    vec3 normal;
+    vec3 eyeDirection;
+    vec3 lightDirection;
+    vec3 lightPosition;
+} outData;
+
+flat out vec3 colour;
+out vec2 uv;
+
+#include "UniformMatrices.glsl"
+
+void main()
+{
+    // A uniform scale and an offset leave normals alone, so only the view
+    // (a rotation and a translation) acts on them.
+    vec3 worldPos = instanceSphere.xyz + position * instanceSphere.w;
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+
+    outData.position = worldPos;
+
+    vec3 vertexPos = (view * vec4(worldPos, 1.0)).xyz;
+    outData.eyeDirection = vec3(0, 0, 0) - vertexPos;
+
+    outData.lightPosition = vec3(0, 5, 0);
+    vec3 lightPos = (view * vec4(outData.lightPosition, 1.0)).xyz;
+    outData.lightDirection = lightPos + outData.eyeDirection;
+
+    outData.normal = (view * vec4(normal, 0)).xyz;
+
+    colour = instanceColour;
+    uv = tex;
+}
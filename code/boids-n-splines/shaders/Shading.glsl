@@ -0,0 +1,35 @@
+#ifndef SHADING_GLSL
+#define SHADING_GLSL
+
+// Expects the including shader to declare the VertexData block as inData.
+vec3 shadedColour(vec3 materialDiffuseColour)
+{
+    vec3 lightColour = vec3(1, 1, 1);
+    float lightPower = 100.0;
+
+    vec3 materialAmbientColour = vec3(0.5, 0.5, 0.5) * materialDiffuseColour;
+    vec3 materialSpecularColour = vec3(0.3, 0.3, 0.3);
+
+    // Distance to light.
+    float dist = length(inData.lightPosition - inData.position);
+
+    // Normal of the fragment.
+    vec3 n = normalize(inData.normal);
+
+    // Direction of the light.
+    vec3 l = normalize(inData.lightDirection);
+    float cosTheta = clamp(dot(n, l), 0, 1);
+
+    // Eye vector.
+    vec3 E = normalize(inData.eyeDirection);
+    vec3 R = reflect(-l, n);
+    float cosAlpha = clamp(dot(E, R), 0, 1);
+
+    return materialAmbientColour + 
+        materialDiffuseColour * lightColour * lightPower * 
+        cosTheta / (dist * dist) + 
+        materialSpecularColour * lightColour * lightPower * pow(cosAlpha, 5) /
+        (dist * dist);
+}
+
+#endif
@@ -0,0 +1,12 @@
+#version 330 core
+
+uniform vec3 colour;
+
+in float age;
+
+out vec4 fragColour;
+
+void main()
+{
+    fragColour = vec4(colour, 1.0 - age);
+}
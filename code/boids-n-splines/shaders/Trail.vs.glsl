@@ -0,0 +1,43 @@
+#version 330 core
+
+#include "UniformMatrices.glsl"
+
+// Ring buffer of past positions: slice s occupies rows
+// [s * sliceRows, (s + 1) * sliceRows) and boid i sits at texel i of its
+// slice.
+uniform sampler2D history;
+uniform int trailLength;
+uniform int head;
+uniform int filled;
+uniform int width;
+uniform int sliceRows;
+uniform int skipped;
+
+out float age;
+
+vec3 pastPosition(int boid, int stepsBack)
+{
+    int slice = (head - stepsBack + trailLength) % trailLength;
+    ivec2 texel = ivec2(boid % width, slice * sliceRows + boid / width);
+    return texelFetch(history, texel, 0).xyz;
+}
+
+void main()
+{
+    // Each pair of vertices is one segment, from stepsBack to stepsBack + 1.
+    int segment = gl_VertexID / 2;
+    int stepsBack = segment + gl_VertexID % 2;
+
+    // Segments older than the recorded history, and the boid carrying the
+    // POV camera, are pushed outside the clip volume.
+    if (segment + 1 >= filled || gl_InstanceID == skipped)
+    {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        age = 1.0;
+        return;
+    }
+
+    vec3 position = pastPosition(gl_InstanceID, stepsBack);
+    gl_Position = projection * view * vec4(position, 1.0);
+    age = float(stepsBack) / float(trailLength - 1);
+}
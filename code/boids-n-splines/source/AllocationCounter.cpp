@@ -0,0 +1,162 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::uint64_t> allocationCount(0);
+
+    void* countedAllocate(std::size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* countedAllocate(std::size_t size, std::align_val_t alignment)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+        return _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+        // aligned_alloc wants the size to be a multiple of the alignment.
+        std::size_t rounded = (size + align - 1) / align * align;
+        return std::aligned_alloc(align, rounded == 0 ? align : rounded);
+#endif
+    }
+
+    void alignedFree(void* pointer)
+    {
+#ifdef _MSC_VER
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+}
+
+namespace bns
+{
+    std::uint64_t getHeapAllocationCount()
+    {
+        return allocationCount.load(std::memory_order_relaxed);
+    }
+}
+
+// Replacements for the global allocation functions, including the
+// over-aligned forms that std::pmr::new_delete_resource uses.
+void* operator new(std::size_t size)
+{
+    void* pointer = countedAllocate(size);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::nothrow_t const&) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::nothrow_t const&) noexcept
+{
+    std::free(pointer);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    void* pointer = countedAllocate(size, alignment);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+    std::nothrow_t const&) noexcept
+{
+    return countedAllocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+    std::nothrow_t const&) noexcept
+{
+    return countedAllocate(size, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    alignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    alignedFree(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    alignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    alignedFree(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t,
+    std::nothrow_t const&) noexcept
+{
+    alignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t,
+    std::nothrow_t const&) noexcept
+{
+    alignedFree(pointer);
+}
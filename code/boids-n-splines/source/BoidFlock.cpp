@@ -6,15 +6,54 @@
 #include <atlas/core/STB.hpp>
 #include <atlas/core/Float.hpp>
 #include <atlas/utils/GUI.hpp>
-#include <stdlib.h>
-#include <stdio.h>
-#include <math.h>
+#include <atlas/core/Macros.hpp>
+
+#include <cmath>
+#include <cstddef>
 
 namespace bns
 {
-    BoidFlock::BoidFlock() :
+    namespace
+    {
+        // Whether the box lies at least partly inside the frustum of clip,
+        // by testing the corner furthest along each plane's normal.
+        bool intersectsFrustum(atlas::math::Matrix4 const& clip,
+            atlas::math::Point const& lower, atlas::math::Point const& upper)
+        {
+            atlas::math::Vector4 row[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                row[i] = atlas::math::Vector4(clip[0][i], clip[1][i],
+                    clip[2][i], clip[3][i]);
+            }
+
+            for (int plane = 0; plane < 6; ++plane)
+            {
+                atlas::math::Vector4 p = (plane % 2 == 0) ?
+                    row[3] + row[plane / 2] : row[3] - row[plane / 2];
+                atlas::math::Point corner(
+                    (p.x >= 0.0f) ? upper.x : lower.x,
+                    (p.y >= 0.0f) ? upper.y : lower.y,
+                    (p.z >= 0.0f) ? upper.z : lower.z);
+                if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w <
+                    0.0f)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    BoidFlock::BoidFlock(std::pmr::memory_resource* frameMemory) :
         mVertexBuffer(GL_ARRAY_BUFFER),
-        mIndexBuffer(GL_ELEMENT_ARRAY_BUFFER)
+        mIndexBuffer(GL_ELEMENT_ARRAY_BUFFER),
+        mInstanceBuffer(GL_ARRAY_BUFFER),
+        mPovInstances(0),
+        mHalfInstances(false),
+        mFrameMemory(frameMemory),
+        mSnapshot(nullptr),
+        mSnapshotSlots(nullptr)
     {
         using atlas::utils::Mesh;
         namespace gl = atlas::gl;
@@ -27,27 +66,8 @@ namespace bns
 
         mIndexCount = static_cast<GLsizei>(sphere.indices().size());
 
-        mMass = 1000.0f;
-        mFlockRadius = 5.0f;
-        mViewRadius = 1.0f;
-        mViewAngle = 0.75 * 3.1419f;
-        mNumBoids = 100;
-
-        for (int i = 0; i < mNumBoids; i++)
-        {
-            atlas::math::Vector rp = normalize(random2DVector(1.0f));
-
-            float rr = static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * mFlockRadius;
-            rp.x *= rr;
-            rp.z *= rr;
-
-            atlas::math::Vector rv = random2DVector(1.0f);
-
-            Boid mBoid = Boid(rp, rv * 0.001f, 0.15f);
-            mBoids.push_back(mBoid);
-        }
-
-        std::vector<float> data;
+        std::pmr::vector<float> data(mFrameMemory);
+        data.reserve(sphere.vertices().size() * 8);
         for (std::size_t i = 0; i < sphere.vertices().size(); ++i)
         {
             data.push_back(sphere.vertices()[i].x);
@@ -77,18 +97,35 @@ namespace bns
         mVao.enableVertexAttribArray(NORMALS_LAYOUT_LOCATION);
         mVao.enableVertexAttribArray(TEXTURES_LAYOUT_LOCATION);
 
+        // Instance data is re-uploaded every frame; the attributes advance
+        // once per instance rather than once per vertex.
+        mInstanceBuffer.bindBuffer();
+        mInstanceBuffer.bufferData(0, nullptr, GL_STREAM_DRAW);
+        pointInstances(0);
+        GLuint const instanceLocations[] = {
+            INSTANCE_POSITION_LAYOUT_LOCATION,
+            INSTANCE_FORWARD_LAYOUT_LOCATION,
+            INSTANCE_COLOUR_LAYOUT_LOCATION
+        };
+        for (GLuint location : instanceLocations)
+        {
+            mVao.enableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+
         mIndexBuffer.bindBuffer();
         mIndexBuffer.bufferData(gl::size<GLuint>(sphere.indices().size()),
             sphere.indices().data(), GL_STATIC_DRAW);
 
         mIndexBuffer.unBindBuffer();
+        mInstanceBuffer.unBindBuffer();
         mVertexBuffer.unBindBuffer();
         mVao.unBindVertexArray();
 
         std::vector<gl::ShaderUnit> shaders
         {
-            {std::string(ShaderDirectory) + "Ball.vs.glsl", GL_VERTEX_SHADER},
-            {std::string(ShaderDirectory) + "Ball.fs.glsl", GL_FRAGMENT_SHADER}
+            {std::string(ShaderDirectory) + "Boid.vs.glsl", GL_VERTEX_SHADER},
+            {std::string(ShaderDirectory) + "Boid.fs.glsl", GL_FRAGMENT_SHADER}
         };
 
         mShaders.emplace_back(shaders);
@@ -96,44 +133,68 @@ namespace bns
         mShaders[0].compileShaders();
         mShaders[0].linkShaders();
 
-        auto var = mShaders[0].getUniformVariable("model");
-        mUniforms.insert(UniformKey("model", var));
-        var = mShaders[0].getUniformVariable("projection");
+        auto var = mShaders[0].getUniformVariable("projection");
         mUniforms.insert(UniformKey("projection", var));
         var = mShaders[0].getUniformVariable("view");
         mUniforms.insert(UniformKey("view", var));
-        var = mShaders[0].getUniformVariable("materialColour");
-        mUniforms.insert(UniformKey("materialColour", var));
 
         mShaders[0].disableShaders();
     }
 
     void BoidFlock::updateGeometry(atlas::core::Time<> const& t)
     {
-        //for each boid:
-        for(std::size_t i = 0; i < mBoids.size(); i++)
-        {
-            //determine forces at current state
-            atlas::math::Vector separation = computeSeparation(mBoids[i]);
-            atlas::math::Vector alignment = computeAlignment(mBoids[i]);
-            atlas::math::Vector cohesion = computeCohesion(mBoids[i]);
-            atlas::math::Vector avoidance = computeAvoidance(mBoids[i]);
-
-            //sum forces & move boids
-            atlas::math::Vector forces = separation*3.0f + alignment*100.0f + cohesion*2.0f + avoidance;
-            mBoids[i].mVelocity += forces / mMass;
-            mBoids[i].mPosition += mBoids[i].mVelocity;
-            mBoids[i].mForward = normalize(mBoids[i].mVelocity);
-        }
+        mSimulation.setTimeStep(static_cast<float>(t.deltaTime));
+        mSimulation.step();
     }
 
     void BoidFlock::renderGeometry(atlas::math::Matrix4 const& projection,
         atlas::math::Matrix4 const& view)
     {
-        namespace math = atlas::math;
+        prepareFrame();
+        renderView(projection, view, false);
+    }
+
+    void BoidFlock::prepareFrame()
+    {
+        namespace gl = atlas::gl;
 
         mShaders[0].hotReloadShaders();
-        if (!mShaders[0].shaderProgramValid())
+        mCells.clear();
+        mPovInstances = 0;
+
+        std::vector<Boid> const& boids = getBoids();
+        if (boids.empty())
+        {
+            return;
+        }
+
+        mInstanceBuffer.bindBuffer();
+        if (mHalfInstances)
+        {
+            std::pmr::vector<HalfBoidInstance> instances(mFrameMemory);
+            mPovInstances = static_cast<GLsizei>(buildBoidInstances(boids,
+                getSlot(PovBoidId), instances, mCells, mCellStarts));
+            mInstanceBuffer.bufferData(
+                gl::size<HalfBoidInstance>(instances.size()),
+                instances.data(), GL_STREAM_DRAW);
+        }
+        else
+        {
+            std::pmr::vector<BoidInstance> instances(mFrameMemory);
+            mPovInstances = static_cast<GLsizei>(buildBoidInstances(boids,
+                getSlot(PovBoidId), instances, mCells, mCellStarts));
+            mInstanceBuffer.bufferData(
+                gl::size<BoidInstance>(instances.size()), instances.data(),
+                GL_STREAM_DRAW);
+        }
+        mInstanceBuffer.unBindBuffer();
+    }
+
+    void BoidFlock::renderView(atlas::math::Matrix4 const& projection,
+        atlas::math::Matrix4 const& view, bool showPovBoid)
+    {
+        if (!mShaders[0].shaderProgramValid() ||
+            (mCells.empty() && (!showPovBoid || mPovInstances == 0)))
         {
             return;
         }
@@ -141,188 +202,156 @@ namespace bns
         mShaders[0].enableShaders();
 
         mVao.bindVertexArray();
+        mInstanceBuffer.bindBuffer();
         mIndexBuffer.bindBuffer();
 
         glUniformMatrix4fv(mUniforms["projection"], 1, GL_FALSE,
             &projection[0][0]);
         glUniformMatrix4fv(mUniforms["view"], 1, GL_FALSE, &view[0][0]);
 
-        for (std::size_t i = 1; i < mBoids.size(); i++)
+        // Neighbouring visible cells sit next to each other in the buffer,
+        // so they are merged into one draw.
+        atlas::math::Matrix4 clip = projection * view;
+        GLsizei first = 0;
+        GLsizei count = showPovBoid ? mPovInstances : 0;
+        for (CullCell const& cell : mCells)
         {
-            atlas::math::Vector offset = {0,0.2f,0};
-            //draw boid "body"
-            const math::Vector white{ 1.0f, 1.0f, 1.0f };
-            auto bodyModel = glm::translate(math::Matrix4(1.0f), mBoids[i].mPosition + offset) * glm::scale(math::Matrix4(1.0f), math::Vector(0.1f));
-            glUniformMatrix4fv(mUniforms["model"], 1, GL_FALSE, &bodyModel[0][0]);
-            glUniform3fv(mUniforms["materialColour"], 1, &white[0]);
-            glDrawElements(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, 0);
-
-            //draw boid "head"
-            const math::Vector black{ 0.0f, 0.0f, 0.0f };
-            auto headModel = glm::translate(math::Matrix4(1.0f), mBoids[i].mPosition + mBoids[i].mForward*0.15f + offset) * glm::scale(math::Matrix4(1.0f), math::Vector(0.05f));
-            glUniformMatrix4fv(mUniforms["model"], 1, GL_FALSE, &headModel[0][0]);
-            glUniform3fv(mUniforms["materialColour"], 1, &black[0]);
-            glDrawElements(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, 0);
+            if (!intersectsFrustum(clip, cell.lower, cell.upper))
+            {
+                continue;
+            }
+            GLsizei begin = static_cast<GLsizei>(cell.begin);
+            if (count > 0 && first + count != begin)
+            {
+                drawInstances(first, count);
+                count = 0;
+            }
+            if (count == 0)
+            {
+                first = begin;
+            }
+            count += static_cast<GLsizei>(cell.count);
+        }
+        if (count > 0)
+        {
+            drawInstances(first, count);
         }
+        pointInstances(0);
 
         mIndexBuffer.unBindBuffer();
+        mInstanceBuffer.unBindBuffer();
         mVao.unBindVertexArray();
         mShaders[0].disableShaders();
     }
 
-    atlas::math::Vector BoidFlock::getBoidPosition()
+    void BoidFlock::pointInstances(GLsizei first)
     {
-        return mBoids[0].mPosition;
+        namespace gl = atlas::gl;
+
+        // Offsets are in bytes.
+        GLenum type = mHalfInstances ? GL_HALF_FLOAT : GL_FLOAT;
+        std::size_t stride = mHalfInstances ? sizeof(HalfBoidInstance) :
+            sizeof(BoidInstance);
+        std::size_t base = static_cast<std::size_t>(first) * stride;
+        std::size_t forward = mHalfInstances ?
+            offsetof(HalfBoidInstance, forward) :
+            offsetof(BoidInstance, forward);
+        std::size_t colour = mHalfInstances ?
+            offsetof(HalfBoidInstance, colour) :
+            offsetof(BoidInstance, colour);
+
+        mInstanceBuffer.vertexAttribPointer(INSTANCE_POSITION_LAYOUT_LOCATION,
+            4, type, GL_FALSE, static_cast<GLsizei>(stride),
+            gl::bufferOffset<std::uint8_t>(base));
+        mInstanceBuffer.vertexAttribPointer(INSTANCE_FORWARD_LAYOUT_LOCATION,
+            3, type, GL_FALSE, static_cast<GLsizei>(stride),
+            gl::bufferOffset<std::uint8_t>(base + forward));
+        mInstanceBuffer.vertexAttribPointer(INSTANCE_COLOUR_LAYOUT_LOCATION, 3,
+            GL_UNSIGNED_BYTE, GL_TRUE, static_cast<GLsizei>(stride),
+            gl::bufferOffset<std::uint8_t>(base + colour));
     }
 
-    atlas::math::Vector BoidFlock::getBoidLook()
+    void BoidFlock::drawInstances(GLsizei first, GLsizei count)
     {
-        return mBoids[0].mForward;
+        pointInstances(first);
+        glDrawElementsInstanced(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, 0,
+            count);
     }
 
-    atlas::math::Vector BoidFlock::computeSeparation(Boid &self)
+    atlas::math::Vector BoidFlock::getBoidPosition()
     {
-        atlas::math::Vector sForce = {0,0,0};
-
-        for (std::size_t i = 0; i < mBoids.size(); i++)
-        {
-            Boid other = mBoids[i];
-
-            float distance = mag(self.mPosition - other.mPosition);
-
-            if(distance > 0 && distance <= mViewRadius * 0.5f &&
-                angle(self.mForward, self.mPosition - other.mPosition) <= mViewAngle)
-            {
-                atlas::math::Vector direction = self.mPosition - other.mPosition;
-                float weight = 1.0 / distance*distance;
-                sForce += direction * weight;
-            }
-        }
-        return sForce;
+        std::uint32_t slot = getSlot(PovBoidId);
+        return (slot != NoBoidSlot) ? getBoids()[slot].mPosition :
+            atlas::math::Vector(0.0f);
     }
 
-    atlas::math::Vector BoidFlock::computeAlignment(Boid &self)
+    atlas::math::Vector BoidFlock::getBoidLook()
     {
-        atlas::math::Vector avgAlignment = {0,0,0};
-        float neighbours = 0;
-
-        for (std::size_t i = 0; i < mBoids.size(); i++)
-        {
-            Boid other = mBoids[i];
-            float distance = mag(self.mPosition - other.mPosition);
-
-            if(distance > 0 && distance <= mViewRadius &&
-                angle(self.mForward, self.mPosition - other.mPosition) <= mViewAngle)
-            {
-                avgAlignment += other.mVelocity;
-                neighbours++;
-            }
-        }
-        if (neighbours > 0)
-        {
-            avgAlignment = avgAlignment / neighbours;
-            return avgAlignment - self.mVelocity;
-        }
-        return {0,0,0};
+        std::uint32_t slot = getSlot(PovBoidId);
+        return (slot != NoBoidSlot) ? getBoids()[slot].mForward :
+            atlas::math::Vector(0.0f, 0.0f, 1.0f);
     }
 
-    atlas::math::Vector BoidFlock::computeCohesion(Boid &self)
+    void BoidFlock::setHalfInstances(bool enabled)
     {
-        atlas::math::Vector avgPosition = {0,0,0};
-        float neighbours = 0;
-
-        for (std::size_t i = 0; i < mBoids.size(); i++)
-        {
-            Boid other = mBoids[i];
-            float distance = mag(self.mPosition - other.mPosition);
-
-            if(distance > 0 && distance <= mViewRadius &&
-                angle(self.mForward, self.mPosition - other.mPosition) <= mViewAngle)
-            {
-                avgPosition += other.mPosition;
-                neighbours++;
-            }
-        }
-
-        if (neighbours > 0)
-        {
-            avgPosition = avgPosition / neighbours;
-            return (avgPosition - self.mPosition);
-        }
-
-        return {0,0,0};
+        // renderView() points the attributes afresh for every draw.
+        mHalfInstances = enabled;
     }
 
-    atlas::math::Vector BoidFlock::computeAvoidance(Boid &self)
+    bool BoidFlock::getHalfInstances() const
     {
-        atlas::math::Vector avoidance = {0,0,0};
-        atlas::math::Vector ahead = self.mPosition + self.mForward;
-
-        for (std::size_t i = 0; i < mBoids.size(); i++)
-        {
-            Boid other = mBoids[i];
-
-            float distance = mag(other.mPosition - self.mPosition);
-            float aheadDistance = mag(other.mPosition - ahead);
-            float halfDistance = mag(other.mPosition - (ahead * 0.5f));
-
-            if((distance > 0) && (distance <= other.mRadius ||
-                aheadDistance <= other.mRadius ||
-                halfDistance <= other.mRadius))
-            {
-                avoidance = normalize(ahead - other.mPosition);
-            }
-        }
-
-        return avoidance;
+        return mHalfInstances;
     }
 
     void BoidFlock::resetGeometry()
     {
-        for (std::size_t i = 0; i < mBoids.size(); i++)
-        {
-            atlas::math::Vector rp = normalize(random2DVector(1.0f));
-
-            float rr = static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * mFlockRadius;
-            rp.x *= rr;
-            rp.z *= rr;
-
-            atlas::math::Vector rv = random2DVector(1.0f);
-
-            mBoids[i] = Boid(rp, rv * 0.001f, 0.15f);
-        }
+        mSimulation.reset();
     }
 
-    atlas::math::Vector BoidFlock::random2DVector(float max)
+    void BoidFlock::setSnapshot(std::vector<Boid> const* boids,
+        std::vector<std::uint32_t> const* slots)
     {
-        float rx = static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * max;
-        float rz = static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * max;
-        atlas::math::Vector rv = {2*rx-1,0,2*rz-1};
-        return rv;
+        mSnapshot = boids;
+        mSnapshotSlots = slots;
     }
 
-    atlas::math::Vector BoidFlock::random3DVector(float max)
+    std::uint32_t BoidFlock::getSlot(std::uint32_t id) const
     {
-        float rx = static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * max;
-        float ry= static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * max;
-        float rz = static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * max;
-        atlas::math::Vector rv = {2*rx-1,2*ry-1,2*rz-1};
-        return rv;
+        std::vector<std::uint32_t> const* slots = (mSnapshot != nullptr) ?
+            mSnapshotSlots : &mSimulation.getSlots();
+        if (slots == nullptr)
+        {
+            return (id < getBoids().size()) ? id : NoBoidSlot;
+        }
+        return (id < slots->size()) ? (*slots)[id] : NoBoidSlot;
     }
 
-    float BoidFlock::dot(atlas::math::Vector v1, atlas::math::Vector v2)
+    FlockSimulation& BoidFlock::getSimulation()
     {
-        return v1.x*v2.x + v1.y*v2.y + v1.z*v2.z;
+        return mSimulation;
     }
 
-    float BoidFlock::mag(atlas::math::Vector v)
+    std::vector<Boid> const& BoidFlock::getBoids() const
     {
-        return sqrt(v.x*v.x + v.y*v.y + v.z*v.z);
+        return (mSnapshot != nullptr) ? *mSnapshot : mSimulation.getBoids();
     }
 
-    float BoidFlock::angle(atlas::math::Vector v1, atlas::math::Vector v2)
+    std::vector<Boid> const& BoidFlock::getBoidsById()
     {
-        return acos(dot(v1,v2)/(mag(v1)*mag(v2)));
-    }
+        std::vector<Boid> const& boids = getBoids();
+        if (mSnapshot != nullptr && mSnapshotSlots == nullptr)
+        {
+            return boids;
+        }
 
+        mById.resize(boids.size());
+        for (Boid const& boid : boids)
+        {
+            if (boid.mId < mById.size())
+            {
+                mById[boid.mId] = boid;
+            }
+        }
+        return mById;
+    }
 }
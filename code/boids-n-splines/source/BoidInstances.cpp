@@ -0,0 +1,215 @@
+#include "BoidInstances.hpp"
+#include "FlockSimulation.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace bns
+{
+    namespace
+    {
+        // Body colours by species; species 0 keeps the original white.
+        const atlas::math::Vector SpeciesColours[] =
+        {
+            { 1.0f, 1.0f, 1.0f },
+            { 0.9f, 0.3f, 0.3f },
+            { 0.3f, 0.6f, 0.9f },
+            { 0.9f, 0.8f, 0.2f },
+            { 0.4f, 0.8f, 0.4f },
+            { 0.7f, 0.4f, 0.9f },
+            { 0.9f, 0.6f, 0.2f },
+            { 0.3f, 0.8f, 0.8f },
+            { 0.9f, 0.5f, 0.7f },
+            { 0.5f, 0.5f, 0.5f }
+        };
+
+        constexpr std::size_t SpeciesColourCount =
+            sizeof(SpeciesColours) / sizeof(SpeciesColours[0]);
+
+        // Cull cells aim for this many boids each, up to a 16^3 grid; fewer,
+        // fuller cells keep the per-view work (one box test and at most one
+        // draw per cell) small next to the instance upload it saves.
+        constexpr std::size_t BoidsPerCullCell = 256;
+        constexpr int MaxCullCellsPerAxis = 16;
+        // How far a boid's body and head reach beyond its position, with
+        // slack for the mesh.
+        constexpr float CullMargin = 0.5f;
+
+        void setInstance(atlas::math::Point const& position, float scale,
+            atlas::math::Vector const& forward,
+            atlas::math::Vector const& colour, BoidInstance& instance)
+        {
+            instance.position = position;
+            instance.scale = scale;
+            instance.forward = forward;
+            for (int c = 0; c < 3; ++c)
+            {
+                instance.colour[c] = static_cast<std::uint8_t>(
+                    colour[c] * 255.0f + 0.5f);
+            }
+            instance.colour[3] = 255;
+        }
+
+        void setInstance(atlas::math::Point const& position, float scale,
+            atlas::math::Vector const& forward,
+            atlas::math::Vector const& colour, HalfBoidInstance& instance)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                instance.position[c] = glm::packHalf1x16(position[c]);
+                instance.forward[c] = glm::packHalf1x16(forward[c]);
+                instance.colour[c] = static_cast<std::uint8_t>(
+                    colour[c] * 255.0f + 0.5f);
+            }
+            instance.scale = glm::packHalf1x16(scale);
+            instance.forward[3] = 0;
+            instance.colour[3] = 255;
+        }
+
+        template <typename Instance>
+        void appendInstances(Boid const& boid,
+            std::pmr::vector<Instance>& instances)
+        {
+            namespace math = atlas::math;
+
+            math::Vector offset = {0,0.2f,0};
+            //boid "body"
+            instances.emplace_back();
+            setInstance(boid.mPosition + offset, 0.1f, boid.mForward,
+                SpeciesColours[boid.mSpecies % SpeciesColourCount],
+                instances.back());
+
+            //boid "head"
+            instances.emplace_back();
+            setInstance(boid.mPosition + boid.mForward*0.15f + offset, 0.05f,
+                boid.mForward, math::Vector{ 0.0f, 0.0f, 0.0f },
+                instances.back());
+        }
+
+        // Shared by both instance formats.
+        template <typename Instance>
+        std::size_t buildInstances(std::vector<Boid> const& boids,
+            std::uint32_t povSlot, std::pmr::vector<Instance>& instances,
+            std::vector<CullCell>& cells,
+            std::vector<std::uint32_t>& cellStarts)
+        {
+            namespace math = atlas::math;
+
+            std::pmr::memory_resource* memory =
+                instances.get_allocator().resource();
+            instances.clear();
+            cells.clear();
+            if (boids.empty())
+            {
+                return 0;
+            }
+
+            math::Point lower = boids[0].mPosition;
+            math::Point upper = lower;
+            for (Boid const& boid : boids)
+            {
+                lower = glm::min(lower, boid.mPosition);
+                upper = glm::max(upper, boid.mPosition);
+            }
+
+            int perAxis = static_cast<int>(std::cbrt(
+                static_cast<float>(boids.size()) / BoidsPerCullCell));
+            perAxis = std::min(std::max(perAxis, 1), MaxCullCellsPerAxis);
+            math::Vector extent = upper - lower;
+            auto cellOf = [&](math::Point const& position)
+            {
+                std::uint32_t cell = 0;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float t = (position[axis] - lower[axis]) /
+                        std::max(extent[axis], 1e-6f);
+                    int index = std::min(static_cast<int>(t * perAxis),
+                        perAxis - 1);
+                    cell = cell * perAxis + static_cast<std::uint32_t>(
+                        std::max(index, 0));
+                }
+                return cell;
+            };
+
+            // Counting sort of the boids by cell, so that every cell ends up as
+            // one contiguous range of instances.
+            std::size_t cellCount =
+                static_cast<std::size_t>(perAxis * perAxis * perAxis);
+            cellStarts.assign(cellCount + 1, 0);
+            for (std::size_t i = 0; i < boids.size(); i++)
+            {
+                if (i != povSlot)
+                {
+                    cellStarts[cellOf(boids[i].mPosition) + 1]++;
+                }
+            }
+            for (std::size_t cell = 0; cell < cellCount; cell++)
+            {
+                cellStarts[cell + 1] += cellStarts[cell];
+            }
+            std::pmr::vector<std::uint32_t> order(cellStarts[cellCount],
+                memory);
+            std::pmr::vector<std::uint32_t> next(cellStarts.begin(),
+                cellStarts.end() - 1, memory);
+            for (std::size_t i = 0; i < boids.size(); i++)
+            {
+                if (i != povSlot)
+                {
+                    order[next[cellOf(boids[i].mPosition)]++] =
+                        static_cast<std::uint32_t>(i);
+                }
+            }
+
+            //build one body and one head instance per boid
+            instances.reserve(boids.size() * 2);
+            std::size_t povInstances = 0;
+            if (povSlot != NoBoidSlot)
+            {
+                appendInstances(boids[povSlot], instances);
+                povInstances = instances.size();
+            }
+            for (std::size_t cell = 0; cell < cellCount; cell++)
+            {
+                if (cellStarts[cell] == cellStarts[cell + 1])
+                {
+                    continue;
+                }
+
+                CullCell cull;
+                cull.begin = static_cast<std::uint32_t>(instances.size());
+                cull.lower = boids[order[cellStarts[cell]]].mPosition;
+                cull.upper = cull.lower;
+                for (std::uint32_t k = cellStarts[cell];
+                    k < cellStarts[cell + 1]; k++)
+                {
+                    Boid const& boid = boids[order[k]];
+                    cull.lower = glm::min(cull.lower, boid.mPosition);
+                    cull.upper = glm::max(cull.upper, boid.mPosition);
+                    appendInstances(boid, instances);
+                }
+                cull.lower -= math::Vector(CullMargin);
+                cull.upper += math::Vector(CullMargin);
+                cull.count = static_cast<std::uint32_t>(instances.size()) -
+                    cull.begin;
+                cells.push_back(cull);
+            }
+            return povInstances;
+        }
+    }
+
+    std::size_t buildBoidInstances(std::vector<Boid> const& boids,
+        std::uint32_t povSlot, std::pmr::vector<BoidInstance>& instances,
+        std::vector<CullCell>& cells, std::vector<std::uint32_t>& cellStarts)
+    {
+        return buildInstances(boids, povSlot, instances, cells, cellStarts);
+    }
+
+    std::size_t buildBoidInstances(std::vector<Boid> const& boids,
+        std::uint32_t povSlot, std::pmr::vector<HalfBoidInstance>& instances,
+        std::vector<CullCell>& cells, std::vector<std::uint32_t>& cellStarts)
+    {
+        return buildInstances(boids, povSlot, instances, cells, cellStarts);
+    }
+}
@@ -1,20 +1,106 @@
 #include "BoidScene.hpp"
+#include "AllocationCounter.hpp"
 
 #include <atlas/gl/GL.hpp>
 #include <atlas/utils/GUI.hpp>
 #include <atlas/core/Log.hpp>
 #include <atlas/math/Math.hpp>
 
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
 namespace bns
 {
+    namespace
+    {
+        constexpr char TrajectoryFile[] = "flock.bnstraj";
+        constexpr char MetricsFile[] = "flock_metrics.csv";
+        constexpr std::size_t FarFieldErrorSamples = 64;
+        constexpr unsigned TextureThreads = 2;
+
+        std::string getEnvironment(char const* name)
+        {
+            char const* value = std::getenv(name);
+            return (value != nullptr) ? value : "";
+        }
+
+        char const* const CameraModes[] =
+        {
+            "Stage", "Spline Track", "Boid POV"
+        };
+        constexpr int CameraModeCount =
+            static_cast<int>(sizeof(CameraModes) / sizeof(CameraModes[0]));
+        constexpr int PovCameraMode = 2;
+
+        // In IntegratorType order.
+        char const* const Integrators[] =
+        {
+            "Semi-implicit Euler", "Velocity Verlet", "RK4"
+        };
+    }
+
     BoidScene::BoidScene() :
         mCameraMode(0),
+        mMultiView(false),
         mPlay(false),
+        mPipelined(false),
+        mShowObstacle(false),
+        mSpecies(1),
+        mFarField(false),
+        mSweptCollisions(false),
+        mIntegrator(0),
+        mShowTrails(false),
+        mShowPlanets(false),
+        mMutualGravity(false),
         mFPS(60.0f),
         mAnimLength(10.0f),
-        mSpline(int(mAnimLength * mFPS)),
-        mCounter(mFPS)
-    { }
+        mCounter(mFPS),
+        mFrameStartAllocations(getHeapAllocationCount()),
+        mFrameAllocations(0),
+        mTelemetryServer(mTelemetry),
+        mFrameSeconds(nullptr),
+        mRenderSeconds(nullptr),
+        mStepSeconds(nullptr),
+        mFramesRendered(nullptr),
+        mBoidCount(nullptr),
+        mSimFrame(nullptr),
+        mHeapAllocations(nullptr),
+        mCollisions(nullptr),
+        mLoadImbalance(nullptr),
+        mLastUpdate(std::chrono::steady_clock::now()),
+        mTextures(TextureThreads, getEnvironment("BNS_TEXTURE_CACHE")),
+        mBoidFlock(&mFrameArena),
+        mTrails(&mFrameArena),
+        mObstacle("sphere.obj", glm::scale(atlas::math::Matrix4(1.0f),
+            atlas::math::Vector(1.5f))),
+        mPlanets(&mFrameArena),
+        mSpline(int(mAnimLength * mFPS), &mFrameArena),
+        mSimThread(mBoidFlock.getSimulation()),
+        mLastRecordedFrame(std::numeric_limits<std::uint64_t>::max()),
+        mDisplayedFrame(0),
+        mFurthestFrame(0),
+        mLastPublishedFrame(std::numeric_limits<std::uint64_t>::max()),
+        mMetrics{ 0.0f, 0.0f, 0, 0 },
+        mLoadBalance{ 0, 0, 0.0f, 0.0f, 0.0f, 0.0f },
+        mThreads(1),
+        mAutoTune(false),
+        mTunerStatus{ false, { 0.0f, 1, 1 }, 0, 0, 0.0f, 0 },
+        mLastLoggedFrame(std::numeric_limits<std::uint64_t>::max()),
+        mFarFieldError{ 0.0f, 0.0f, 0 }
+    {
+        registerMetrics();
+        std::string planetTexture = getEnvironment("BNS_PLANET_TEXTURE");
+        if (!planetTexture.empty())
+        {
+            mPlanets.setTexture(mTextures.acquire(planetTexture));
+        }
+        if (std::getenv("BNS_TELEMETRY_ADDRESS") != nullptr)
+        {
+            startTelemetry();
+        }
+    }
 
     void BoidScene::mousePressEvent(int button, int action, int modifiers,
         double xPos, double yPos)
@@ -86,6 +172,18 @@ namespace bns
     {
         using atlas::core::Time;
 
+        // A frame runs from one update to the next, render included.
+        std::uint64_t allocations = getHeapAllocationCount();
+        mFrameAllocations = allocations - mFrameStartAllocations;
+        mFrameStartAllocations = allocations;
+        mFrameArena.reset();
+
+        auto now = std::chrono::steady_clock::now();
+        mFrameSeconds->observe(
+            std::chrono::duration<double>(now - mLastUpdate).count());
+        mLastUpdate = now;
+        mHeapAllocations->set(static_cast<double>(mFrameAllocations));
+
         ModellingScene::updateScene(time);
         if (mPlay && mCounter.isFPS(mTime))
         {
@@ -95,19 +193,83 @@ namespace bns
             mAnimTime.totalTime = mAnimTime.currentTime;
 
             mSpline.updateGeometry(mAnimTime);
-            mBoidFlock.updateGeometry(mAnimTime);
+            if (mShowPlanets)
+            {
+                mPlanets.updateGeometry(mAnimTime);
+            }
+            if (mReplay.isOpen())
+            {
+                if (!mReplay.advance())
+                {
+                    mPlay = false;
+                }
+            }
+            else if (mPipelined)
+            {
+                mSimThread.post(SimCommand::step(delta));
+            }
+            else
+            {
+                auto start = std::chrono::steady_clock::now();
+                mBoidFlock.updateGeometry(mAnimTime);
+                mStepSeconds->observe(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
         }
 
-        if(mCameraMode == 0)
+        if (mReplay.isOpen())
+        {
+            mBoidFlock.setSnapshot(&mReplay.getBoids());
+            mDisplayedFrame = mReplay.getCurrentFrame();
+        }
+        else if (mPipelined)
+        {
+            // Draw (and track the POV camera against) the latest completed
+            // step while the simulation thread works on the next one.
+            auto const& snapshot = mSimThread.acquireSnapshot();
+            mBoidFlock.setSnapshot(&snapshot.boids, &snapshot.slots);
+            mDisplayedFrame = snapshot.frame;
+            mMetrics = snapshot.metrics;
+            mLoadBalance = snapshot.loadBalance;
+            mTunerStatus = snapshot.tuner;
+            recordFrame(mDisplayedFrame);
+            logMetrics(mDisplayedFrame);
+        }
+        else
+        {
+            mDisplayedFrame = mBoidFlock.getSimulation().getFrame();
+            mMetrics = mBoidFlock.getSimulation().getMetrics();
+            mLoadBalance = mBoidFlock.getSimulation().getLoadBalance();
+            mTunerStatus = mBoidFlock.getSimulation().getTunerStatus();
+            recordFrame(mDisplayedFrame);
+            logMetrics(mDisplayedFrame);
+        }
+        mFurthestFrame = std::max(mFurthestFrame, mDisplayedFrame);
+        publishFrame(mDisplayedFrame);
+        mBoidCount->set(static_cast<double>(mBoidFlock.getBoids().size()));
+        mSimFrame->set(static_cast<double>(mDisplayedFrame));
+        mCollisions->set(static_cast<double>(mMetrics.collisions));
+        mLoadImbalance->set(mLoadBalance.measuredImbalance);
+        if (mShowTrails)
+        {
+            mTrails.update(mBoidFlock.getBoids(), mDisplayedFrame);
+        }
+
+        placeCamera(mCameraMode);
+    }
+
+    void BoidScene::placeCamera(int mode)
+    {
+        if(mode == 0)
         {
             mCamera.setCameraPosition({20,20,20});
         }
-        else if(mCameraMode == 1)
+        else if(mode == 1)
         {
             auto point = mSpline.getPosition();
             mCamera.setCameraPosition(point);
         }
-        else if(mCameraMode ==2)
+        else if(mode ==2)
         {
             atlas::math::Vector offset = {0,0.2f,0};
             mCamera.setCameraPosition(mBoidFlock.getBoidPosition() + offset);
@@ -115,24 +277,75 @@ namespace bns
         }
     }
 
+    void BoidScene::renderView(int mode, int x, int width)
+    {
+        glViewport(x, 0, width, mHeight);
+
+        // Every view borrows the one camera, and with it the orientation
+        // the mouse gave it; renderScene() puts it back afterwards.
+        placeCamera(mode);
+        atlas::math::Matrix4 projection = glm::perspective(
+            glm::radians(mCamera.getCameraFOV()),
+            (float)width / mHeight, 1.0f, 100000000.0f);
+        atlas::math::Matrix4 view = mCamera.getCameraMatrix();
+
+        mGrid.renderGeometry(projection, view);
+        mBoidFlock.renderView(projection, view, mode != PovCameraMode);
+        if (mShowTrails)
+        {
+            mTrails.renderGeometry(projection, view);
+        }
+        if (mShowObstacle)
+        {
+            mObstacle.renderGeometry(projection, view);
+        }
+        if (mShowPlanets)
+        {
+            mPlanets.renderView(projection, view);
+        }
+        mSpline.renderGeometry(projection, view);
+
+        if (mode == mCameraMode)
+        {
+            mProjection = projection;
+            mView = view;
+        }
+    }
+
     void BoidScene::renderScene()
     {
         using atlas::utils::Gui;
 
+        auto renderStart = std::chrono::steady_clock::now();
         Gui::getInstance().newFrame();
         const float grey = 92.0f / 255.0f;
         glClearColor(grey, grey, grey, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        mProjection = glm::perspective(
-            glm::radians(mCamera.getCameraFOV()),
-            (float)mWidth / mHeight, 1.0f, 100000000.0f);
-
-        mView = mCamera.getCameraMatrix();
+        mTextures.update();
 
-        mGrid.renderGeometry(mProjection, mView);
-        mBoidFlock.renderGeometry(mProjection, mView);
-        mSpline.renderGeometry(mProjection, mView);
+        // Instances are built and uploaded once, however many views draw
+        // them.
+        mBoidFlock.prepareFrame();
+        if (mShowPlanets)
+        {
+            mPlanets.prepareFrame();
+        }
+        if (mMultiView)
+        {
+            for (int mode = 0; mode < CameraModeCount; ++mode)
+            {
+                int left = mWidth * mode / CameraModeCount;
+                int right = mWidth * (mode + 1) / CameraModeCount;
+                renderView(mode, left, right - left);
+            }
+            placeCamera(mCameraMode);
+        }
+        else
+        {
+            renderView(mCameraMode, 0, mWidth);
+        }
+        glViewport(0, 0, mWidth, mHeight);
 
         // Global HUD
         ImGui::SetNextWindowSize(ImVec2(350, 150), ImGuiSetCond_FirstUseEver);
@@ -164,21 +377,441 @@ namespace bns
 
         if (ImGui::Button("Reset Boids"))
         {
-            mBoidFlock.resetGeometry();
+            runCommand(SimCommand::reset());
+            mFurthestFrame = 0;
             mAnimTime.currentTime = 0.0f;
             mAnimTime.totalTime = 0.0f;
             mPlay = false;
         }
 
-        std::vector<const char*> options = { "Stage", "Spline Track", "Boid POV" };
-        ImGui::Combo("Camera mode: ", &mCameraMode, options.data(),
-            ((int)options.size()));
+        ImGui::Combo("Camera mode: ", &mCameraMode, CameraModes,
+            CameraModeCount);
+        ImGui::Checkbox("All Views", &mMultiView);
+        bool halfInstances = mBoidFlock.getHalfInstances();
+        if (ImGui::Checkbox("Half-Float Instances", &halfInstances))
+        {
+            mBoidFlock.setHalfInstances(halfInstances);
+        }
+
+        if (ImGui::Checkbox("Obstacle", &mShowObstacle))
+        {
+            runCommand(SimCommand::setObstacles(
+                mShowObstacle ? &mObstacle.getField() : nullptr));
+        }
+
+        if (ImGui::SliderInt("Species", &mSpecies, 1, 10))
+        {
+            runCommand(SimCommand::setSpecies(mSpecies));
+        }
+
+        if (ImGui::Checkbox("Far Field", &mFarField))
+        {
+            runCommand(SimCommand::setFarField(mFarField));
+        }
+
+        ImGui::Checkbox("Trails", &mShowTrails);
+        int trailLength = mTrails.getLength();
+        if (mShowTrails &&
+            ImGui::SliderInt("Trail Length", &trailLength, 2, 128))
+        {
+            mTrails.setLength(trailLength);
+        }
+
+        ImGui::Checkbox("Planets", &mShowPlanets);
+        if (mShowPlanets)
+        {
+            int planetCount = mPlanets.getBodyCount();
+            if (ImGui::SliderInt("Planet Count", &planetCount, 0, 50000))
+            {
+                mPlanets.setBodyCount(planetCount);
+            }
+            if (ImGui::Checkbox("Mutual Gravity", &mMutualGravity))
+            {
+                mPlanets.getSystem().setMutualGravity(mMutualGravity);
+            }
+            if (mTextures.getTextureCount() > 0)
+            {
+                ImGui::Text("Textures: %zu loading, %zu from disk cache",
+                    mTextures.getPendingCount(), mTextures.getCacheHits());
+            }
+        }
+
+        if (ImGui::Checkbox("Swept Collisions", &mSweptCollisions))
+        {
+            runCommand(SimCommand::setCollisions(mSweptCollisions));
+        }
+
+        if (ImGui::Combo("Integrator", &mIntegrator, Integrators,
+            static_cast<int>(sizeof(Integrators) / sizeof(Integrators[0]))))
+        {
+            runCommand(SimCommand::setIntegrator(
+                static_cast<IntegratorType>(mIntegrator)));
+        }
+
+        bool exporting = mPublisher.isOpen();
+        if (ImGui::Checkbox("Shared Memory Export", &exporting))
+        {
+            if (exporting)
+            {
+                mPublisher.open(FlockExportDefaultName,
+                    mBoidFlock.getBoids().size());
+                mLastPublishedFrame = std::numeric_limits<std::uint64_t>::max();
+            }
+            else
+            {
+                mPublisher.close();
+            }
+        }
+
+        bool serving = mTelemetryServer.isRunning();
+        if (ImGui::Checkbox("Telemetry Endpoint", &serving))
+        {
+            if (serving)
+            {
+                startTelemetry();
+            }
+            else
+            {
+                mTelemetryServer.stop();
+            }
+        }
+        if (serving)
+        {
+            ImGui::SameLine();
+            ImGui::Text("%llu scrapes", static_cast<unsigned long long>(
+                mTelemetryServer.getScrapeCount()));
+        }
+
+        bool pipelined = mPipelined;
+        if (ImGui::Checkbox("Pipelined Simulation", &pipelined))
+        {
+            setPipelined(pipelined);
+        }
 
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
             1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+        ImGui::Text("Heap allocations last frame: %llu",
+            static_cast<unsigned long long>(mFrameAllocations));
+        ImGui::Text("Frame arena: %.1f / %.1f KB (peak %.1f KB)",
+            mFrameArena.getUsedBytes() / 1024.0f,
+            mFrameArena.getCapacity() / 1024.0f,
+            mFrameArena.getPeakBytes() / 1024.0f);
         ImGui::End();
 
+        drawTimelineGui();
+        drawRecordingGui();
+        drawAnalyticsGui();
         mSpline.drawGui();
         ImGui::Render();
+
+        mFramesRendered->add();
+        mRenderSeconds->observe(std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - renderStart).count());
+    }
+
+    void BoidScene::runCommand(SimCommand const& command)
+    {
+        if (mPipelined)
+        {
+            mSimThread.post(command);
+        }
+        else
+        {
+            executeCommand(mBoidFlock.getSimulation(), command);
+        }
+    }
+
+    void BoidScene::setPipelined(bool pipelined)
+    {
+        if (pipelined == mPipelined)
+        {
+            return;
+        }
+
+        mPipelined = pipelined;
+        if (mPipelined)
+        {
+            mSimThread.start();
+            auto const& snapshot = mSimThread.acquireSnapshot();
+            mBoidFlock.setSnapshot(&snapshot.boids, &snapshot.slots);
+        }
+        else
+        {
+            mSimThread.stop();
+            mBoidFlock.setSnapshot(nullptr);
+        }
+    }
+
+    void BoidScene::recordFrame(std::uint64_t frame)
+    {
+        if (!mRecorder.isOpen() || frame == mLastRecordedFrame)
+        {
+            return;
+        }
+
+        mRecorder.record(mBoidFlock.getBoidsById());
+        mLastRecordedFrame = frame;
+    }
+
+    void BoidScene::publishFrame(std::uint64_t frame)
+    {
+        if (!mPublisher.isOpen() || frame == mLastPublishedFrame)
+        {
+            return;
+        }
+
+        mPublisher.publish(mBoidFlock.getBoidsById(), frame);
+        mLastPublishedFrame = frame;
+    }
+
+    void BoidScene::logMetrics(std::uint64_t frame)
+    {
+        if (!mMetricsLog.is_open() || frame == mLastLoggedFrame)
+        {
+            return;
+        }
+
+        mMetricsLog << frame << ',' << mMetrics.polarisation << ','
+            << mMetrics.meanNearestDistance << ',' << mMetrics.collisions
+            << ',' << mMetrics.clusters << '\n';
+        mLastLoggedFrame = frame;
+    }
+
+    void BoidScene::drawAnalyticsGui()
+    {
+        ImGui::SetNextWindowSize(ImVec2(300, 140), ImGuiSetCond_FirstUseEver);
+        ImGui::Begin("Analytics");
+
+        if (mReplay.isOpen())
+        {
+            ImGui::Text("Not measured during replay");
+        }
+        else
+        {
+            ImGui::Text("Polarisation: %.3f", mMetrics.polarisation);
+            ImGui::Text("Mean nearest distance: %.3f",
+                mMetrics.meanNearestDistance);
+            ImGui::Text("Collisions: %d", mMetrics.collisions);
+            ImGui::Text("Clusters: %d", mMetrics.clusters);
+        }
+
+        // The check gathers every boid exactly, so it runs on demand and
+        // only while this thread owns the simulation.
+        if (!mPipelined && ImGui::Button("Measure Far Field Error"))
+        {
+            mFarFieldError = mBoidFlock.getSimulation().measureFarFieldError(
+                FarFieldErrorSamples);
+        }
+        if (mFarFieldError.samples > 0)
+        {
+            ImGui::Text("Force error: %.2f%% mean, %.2f%% max (%d boids)",
+                mFarFieldError.meanRelative * 100.0f,
+                mFarFieldError.maxRelative * 100.0f,
+                static_cast<int>(mFarFieldError.samples));
+        }
+
+        if (ImGui::SliderInt("Threads", &mThreads, 1, 64))
+        {
+            runCommand(SimCommand::setThreads(mThreads));
+        }
+        if (ImGui::Checkbox("Auto-Tune", &mAutoTune))
+        {
+            runCommand(SimCommand::setAutoTune(mAutoTune));
+        }
+        if (mAutoTune && mTunerStatus.locked)
+        {
+            ImGui::Text("Tuned: skin %.2f, %d threads x %d parts, %.2f ms",
+                mTunerStatus.settings.neighbourSkin,
+                mTunerStatus.settings.threadCount,
+                mTunerStatus.settings.partsPerThread,
+                mTunerStatus.milliseconds);
+        }
+        else if (mAutoTune)
+        {
+            ImGui::Text("Tuning: candidate %d of %d",
+                static_cast<int>(mTunerStatus.candidate + 1),
+                static_cast<int>(mTunerStatus.candidateCount));
+        }
+        if (mLoadBalance.threads > 1)
+        {
+            ImGui::Text("Load imbalance: %.2f predicted, %.2f measured",
+                mLoadBalance.predictedImbalance,
+                mLoadBalance.measuredImbalance);
+            ImGui::Text("Threads: %.2f ms max, %.2f ms mean (%d parts)",
+                mLoadBalance.maxThreadMilliseconds,
+                mLoadBalance.meanThreadMilliseconds,
+                static_cast<int>(mLoadBalance.parts));
+        }
+
+        bool logging = mMetricsLog.is_open();
+        if (ImGui::Checkbox("Log to CSV", &logging))
+        {
+            if (logging)
+            {
+                mMetricsLog.open(MetricsFile);
+                mMetricsLog << "frame,polarisation,meanNearestDistance,"
+                    "collisions,clusters\n";
+                mLastLoggedFrame = std::numeric_limits<std::uint64_t>::max();
+            }
+            else
+            {
+                mMetricsLog.close();
+            }
+        }
+
+        ImGui::End();
+    }
+
+    void BoidScene::drawRecordingGui()
+    {
+        ImGui::SetNextWindowSize(ImVec2(300, 120), ImGuiSetCond_FirstUseEver);
+        ImGui::Begin("Recording");
+
+        if (mRecorder.isOpen())
+        {
+            if (ImGui::Button("Stop Recording"))
+            {
+                mRecorder.close();
+            }
+            ImGui::Text("Recorded %u frames", mRecorder.getFramesRecorded());
+        }
+        else if (!mReplay.isOpen())
+        {
+            if (ImGui::Button("Start Recording"))
+            {
+                auto const& boids = mBoidFlock.getBoids();
+                mRecorder.open(TrajectoryFile, boids.size(),
+                    boids.empty() ? 0.0f : boids[0].mRadius);
+                mLastRecordedFrame = std::numeric_limits<std::uint64_t>::max();
+            }
+        }
+
+        if (mReplay.isOpen())
+        {
+            if (ImGui::Button("Stop Replay"))
+            {
+                mReplay.close();
+                if (mPipelined)
+                {
+                    auto const& snapshot = mSimThread.acquireSnapshot();
+                    mBoidFlock.setSnapshot(&snapshot.boids, &snapshot.slots);
+                }
+                else
+                {
+                    mBoidFlock.setSnapshot(nullptr);
+                }
+                mFurthestFrame = 0;
+            }
+            ImGui::Text("Frame %u / %u", mReplay.getCurrentFrame(),
+                mReplay.getFrameCount());
+        }
+        else if (!mRecorder.isOpen())
+        {
+            if (ImGui::Button("Replay Recording"))
+            {
+                if (mReplay.open(TrajectoryFile))
+                {
+                    mBoidFlock.setSnapshot(&mReplay.getBoids());
+                    mFurthestFrame = mReplay.getFrameCount() - 1;
+                }
+            }
+        }
+
+        ImGui::End();
+    }
+
+    void BoidScene::seekTo(std::uint64_t frame)
+    {
+        if (mReplay.isOpen())
+        {
+            mReplay.seek(static_cast<std::uint32_t>(frame));
+        }
+        else
+        {
+            runCommand(SimCommand::seek(frame));
+        }
+
+        mSpline.setFrame(static_cast<int>(frame));
+        mAnimTime.currentTime = frame / mFPS;
+        mAnimTime.totalTime = mAnimTime.currentTime;
+    }
+
+    void BoidScene::drawTimelineGui()
+    {
+        ImGui::SetNextWindowSize(ImVec2(400, 100), ImGuiSetCond_FirstUseEver);
+        ImGui::Begin("Timeline");
+
+        // Allow scrubbing over the whole animation even before it has been
+        // simulated; seeking ahead simply simulates the missing frames.
+        int lastFrame = std::max(static_cast<int>(mAnimLength * mFPS),
+            static_cast<int>(mFurthestFrame));
+        int frame = static_cast<int>(mDisplayedFrame);
+        if (ImGui::SliderInt("Frame", &frame, 0, lastFrame))
+        {
+            seekTo(static_cast<std::uint64_t>(frame));
+        }
+
+        if (!mPipelined && !mReplay.isOpen())
+        {
+            auto const& checkpoints = mBoidFlock.getSimulation().getCheckpoints();
+            ImGui::Text("%u checkpoints every %u frames (%.1f KB)",
+                static_cast<unsigned>(checkpoints.getCount()),
+                static_cast<unsigned>(checkpoints.getInterval()),
+                checkpoints.getMemoryUsage() / 1024.0f);
+        }
+
+        ImGui::End();
+    }
+
+    void BoidScene::registerMetrics()
+    {
+        // Frame phases run from well under a millisecond to whole seconds
+        // for large flocks.
+        std::vector<double> seconds = exponentialBuckets(0.0005, 2.0, 14);
+
+        mFrameSeconds = &mTelemetry.addHistogram("bns_frame_seconds",
+            "Time between the starts of consecutive frames.", seconds);
+        mRenderSeconds = &mTelemetry.addHistogram("bns_render_seconds",
+            "CPU time spent issuing the draw calls of a frame.", seconds);
+        mStepSeconds = &mTelemetry.addHistogram("bns_step_seconds",
+            "Time taken by one flock simulation step.", seconds);
+        mFramesRendered = &mTelemetry.addCounter("bns_frames_total",
+            "Frames rendered.");
+        mBoidCount = &mTelemetry.addGauge("bns_boids",
+            "Boids in the displayed flock.");
+        mSimFrame = &mTelemetry.addGauge("bns_sim_frame",
+            "Simulation frame currently displayed.");
+        mHeapAllocations = &mTelemetry.addGauge("bns_heap_allocations",
+            "Heap allocations made during the last frame.");
+        mCollisions = &mTelemetry.addGauge("bns_collisions",
+            "Overlapping boid pairs in the displayed frame.");
+        mLoadImbalance = &mTelemetry.addGauge("bns_load_imbalance",
+            "Busiest thread of the parallel force pass over the mean thread.");
+
+        SimulationInstruments instruments;
+        instruments.stepSeconds = mStepSeconds;
+        instruments.droppedSteps = &mTelemetry.addCounter(
+            "bns_dropped_steps_total",
+            "Steps skipped because the simulation thread fell behind.");
+        instruments.queueDepth = &mTelemetry.addGauge("bns_sim_queue_depth",
+            "Commands waiting for the simulation thread.");
+        mSimThread.setInstruments(instruments);
+    }
+
+    void BoidScene::startTelemetry()
+    {
+        char const* text = std::getenv("BNS_TELEMETRY_ADDRESS");
+        if (text == nullptr)
+        {
+            text = TelemetryDefaultAddress;
+        }
+
+        Address address;
+        if (!parseAddress(text, address))
+        {
+            ERROR_LOG_V("Invalid telemetry address %s", text);
+            return;
+        }
+        mTelemetryServer.start(address);
     }
 }
@@ -0,0 +1,215 @@
+#include "BoidTrails.hpp"
+#include "BoidFlock.hpp"
+#include "Paths.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace bns
+{
+    namespace
+    {
+        constexpr int DefaultTrailLength = 32;
+        constexpr int MinTrailLength = 2;
+
+        // Trails start where BoidFlock draws the boid bodies.
+        const atlas::math::Vector TrailOffset = { 0.0f, 0.2f, 0.0f };
+        const atlas::math::Vector TrailColour = { 0.9f, 0.9f, 0.9f };
+
+        constexpr std::uint64_t NoFrame =
+            std::numeric_limits<std::uint64_t>::max();
+    }
+
+    BoidTrails::BoidTrails(std::pmr::memory_resource* frameMemory) :
+        mHistory(0),
+        mFrameMemory(frameMemory),
+        mLength(DefaultTrailLength),
+        mBoidCount(0),
+        mWidth(0),
+        mSliceRows(0),
+        mHead(0),
+        mFilled(0),
+        mLastFrame(NoFrame)
+    {
+        namespace gl = atlas::gl;
+
+        glGenTextures(1, &mHistory);
+        glBindTexture(GL_TEXTURE_2D, mHistory);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        std::vector<gl::ShaderUnit> shaders
+        {
+            {std::string(ShaderDirectory) + "Trail.vs.glsl", GL_VERTEX_SHADER},
+            {std::string(ShaderDirectory) + "Trail.fs.glsl", GL_FRAGMENT_SHADER}
+        };
+
+        mShaders.emplace_back(shaders);
+        mShaders[0].setShaderIncludeDir(ShaderDirectory);
+        mShaders[0].compileShaders();
+        mShaders[0].linkShaders();
+
+        const char* names[] =
+        {
+            "projection", "view", "history", "trailLength", "head", "filled",
+            "width", "sliceRows", "skipped", "colour"
+        };
+        for (const char* name : names)
+        {
+            auto var = mShaders[0].getUniformVariable(name);
+            mUniforms.insert(UniformKey(name, var));
+        }
+
+        mShaders[0].disableShaders();
+    }
+
+    BoidTrails::~BoidTrails()
+    {
+        glDeleteTextures(1, &mHistory);
+    }
+
+    void BoidTrails::update(std::vector<Boid> const& boids,
+        std::uint64_t frame)
+    {
+        if (frame == mLastFrame && boids.size() == mBoidCount)
+        {
+            return;
+        }
+
+        if (boids.size() != mBoidCount)
+        {
+            allocateHistory(boids.size());
+        }
+        if (mLastFrame == NoFrame || frame != mLastFrame + 1)
+        {
+            mFilled = 0;
+        }
+        mLastFrame = frame;
+        if (boids.empty())
+        {
+            return;
+        }
+
+        // Overwrite the oldest slice with this frame's positions, placed by
+        // boid ID so each boid keeps its texel as the flock is re-sorted.
+        std::size_t texels = static_cast<std::size_t>(mWidth) * mSliceRows;
+        std::pmr::vector<float> slice(texels * 3, 0.0f, mFrameMemory);
+        for (Boid const& boid : boids)
+        {
+            if (boid.mId >= mBoidCount)
+            {
+                continue;
+            }
+            atlas::math::Vector position = boid.mPosition + TrailOffset;
+            std::size_t texel = boid.mId * 3;
+            slice[texel + 0] = position.x;
+            slice[texel + 1] = position.y;
+            slice[texel + 2] = position.z;
+        }
+
+        mHead = (mHead + 1) % mLength;
+        mFilled = std::min(mFilled + 1, mLength);
+
+        glBindTexture(GL_TEXTURE_2D, mHistory);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, mHead * mSliceRows, mWidth,
+            mSliceRows, GL_RGB, GL_FLOAT, slice.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void BoidTrails::renderGeometry(atlas::math::Matrix4 const& projection,
+        atlas::math::Matrix4 const& view)
+    {
+        mShaders[0].hotReloadShaders();
+        if (!mShaders[0].shaderProgramValid() || mFilled < 2)
+        {
+            return;
+        }
+
+        mShaders[0].enableShaders();
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, mHistory);
+
+        glUniformMatrix4fv(mUniforms["projection"], 1, GL_FALSE,
+            &projection[0][0]);
+        glUniformMatrix4fv(mUniforms["view"], 1, GL_FALSE, &view[0][0]);
+        glUniform1i(mUniforms["history"], 0);
+        glUniform1i(mUniforms["trailLength"], mLength);
+        glUniform1i(mUniforms["head"], mHead);
+        glUniform1i(mUniforms["filled"], mFilled);
+        glUniform1i(mUniforms["width"], mWidth);
+        glUniform1i(mUniforms["sliceRows"], mSliceRows);
+        glUniform1i(mUniforms["skipped"], static_cast<GLint>(PovBoidId));
+        glUniform3f(mUniforms["colour"], TrailColour.x, TrailColour.y,
+            TrailColour.z);
+
+        // Trails fade out with age, so blend them without hiding each other.
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+
+        // The segments carry no attributes: the shader derives everything
+        // from the vertex and instance IDs.
+        mVao.bindVertexArray();
+        glDrawArraysInstanced(GL_LINES, 0, 2 * (mLength - 1),
+            static_cast<GLsizei>(mBoidCount));
+        mVao.unBindVertexArray();
+
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        mShaders[0].disableShaders();
+    }
+
+    void BoidTrails::resetGeometry()
+    {
+        mFilled = 0;
+        mLastFrame = NoFrame;
+    }
+
+    int BoidTrails::getLength() const
+    {
+        return mLength;
+    }
+
+    void BoidTrails::setLength(int length)
+    {
+        length = std::max(length, MinTrailLength);
+        if (length == mLength)
+        {
+            return;
+        }
+
+        mLength = length;
+        allocateHistory(mBoidCount);
+        resetGeometry();
+    }
+
+    void BoidTrails::allocateHistory(std::size_t boidCount)
+    {
+        mBoidCount = boidCount;
+        mHead = 0;
+        mFilled = 0;
+
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        std::size_t width = std::min<std::size_t>(std::max<std::size_t>(
+            boidCount, 1), static_cast<std::size_t>(maxSize));
+        mWidth = static_cast<GLsizei>(width);
+        mSliceRows = static_cast<GLsizei>((boidCount + width - 1) / width);
+        mSliceRows = std::max<GLsizei>(mSliceRows, 1);
+
+        // Very large flocks get shorter trails rather than a texture the
+        // driver cannot allocate.
+        mLength = std::max(MinTrailLength, std::min(mLength,
+            static_cast<int>(maxSize / mSliceRows)));
+
+        glBindTexture(GL_TEXTURE_2D, mHistory);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, mWidth,
+            mSliceRows * mLength, 0, GL_RGB, GL_FLOAT, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
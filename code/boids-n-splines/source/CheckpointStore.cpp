@@ -0,0 +1,186 @@
+#include "CheckpointStore.hpp"
+
+#include <algorithm>
+
+namespace bns
+{
+    CheckpointStore::CheckpointStore(std::uint64_t interval,
+        std::size_t memoryBudget) :
+        mBaseInterval(std::max<std::uint64_t>(interval, 1)),
+        mInterval(mBaseInterval),
+        mMemoryBudget(memoryBudget),
+        mMemoryUsage(0),
+        mSlotSize(0),
+        mSlotCount(0)
+    { }
+
+    void CheckpointStore::clear()
+    {
+        for (auto const& checkpoint : mCheckpoints)
+        {
+            releaseSlot(checkpoint);
+        }
+        mCheckpoints.clear();
+        mInterval = mBaseInterval;
+        mMemoryUsage = 0;
+    }
+
+    void CheckpointStore::capture(std::uint64_t frame,
+        std::vector<Boid> const& boids)
+    {
+        if (frame % mInterval != 0)
+        {
+            return;
+        }
+
+        if (boids.size() != mSlotSize || mSlotCount == 0)
+        {
+            allocateSlots(boids.size());
+        }
+
+        auto find = [this](std::uint64_t f)
+        {
+            return std::lower_bound(mCheckpoints.begin(), mCheckpoints.end(),
+                f, [](Checkpoint const& checkpoint, std::uint64_t value)
+            {
+                return checkpoint.frame < value;
+            });
+        };
+
+        // The simulation is deterministic, so a frame that was captured
+        // before (e.g. when stepping again after a seek) has not changed.
+        auto it = find(frame);
+        if (it != mCheckpoints.end() && it->frame == frame)
+        {
+            return;
+        }
+
+        // Make room first; the coarser grid may leave this frame out too.
+        if (mCheckpoints.size() >= mSlotCount)
+        {
+            evict();
+            if (frame % mInterval != 0)
+            {
+                return;
+            }
+            it = find(frame);
+        }
+
+        std::uint32_t slot;
+        if (!mFreeSlots.empty())
+        {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else
+        {
+            // Within the reservation, so earlier slots do not move.
+            slot = static_cast<std::uint32_t>(mSlotStorage.size() / mSlotSize);
+            mSlotStorage.resize(mSlotStorage.size() + mSlotSize);
+        }
+
+        CompactBoid* saved = mSlotStorage.data() + slot * mSlotSize;
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            saved[i] = { boids[i].mPosition, boids[i].mVelocity,
+                boids[i].mId };
+        }
+
+        mMemoryUsage += mSlotSize * sizeof(CompactBoid);
+        mCheckpoints.insert(it, Checkpoint{ frame, saved, slot });
+    }
+
+    void CheckpointStore::discardAfter(std::uint64_t frame)
+    {
+        auto it = std::upper_bound(mCheckpoints.begin(), mCheckpoints.end(),
+            frame, [](std::uint64_t f, Checkpoint const& checkpoint)
+        {
+            return f < checkpoint.frame;
+        });
+
+        for (auto dropped = it; dropped != mCheckpoints.end(); ++dropped)
+        {
+            mMemoryUsage -= mSlotSize * sizeof(CompactBoid);
+            releaseSlot(*dropped);
+        }
+        mCheckpoints.erase(it, mCheckpoints.end());
+    }
+
+    Checkpoint const* CheckpointStore::findNearest(std::uint64_t frame) const
+    {
+        auto it = std::upper_bound(mCheckpoints.begin(), mCheckpoints.end(),
+            frame, [](std::uint64_t f, Checkpoint const& checkpoint)
+        {
+            return f < checkpoint.frame;
+        });
+
+        if (it == mCheckpoints.begin())
+        {
+            return nullptr;
+        }
+
+        return &*(it - 1);
+    }
+
+    std::uint64_t CheckpointStore::getInterval() const
+    {
+        return mInterval;
+    }
+
+    std::size_t CheckpointStore::getCount() const
+    {
+        return mCheckpoints.size();
+    }
+
+    std::size_t CheckpointStore::getMemoryUsage() const
+    {
+        return mMemoryUsage;
+    }
+
+    void CheckpointStore::allocateSlots(std::size_t boidCount)
+    {
+        mCheckpoints.clear();
+        mInterval = mBaseInterval;
+        mMemoryUsage = 0;
+
+        mSlotSize = std::max<std::size_t>(boidCount, 1);
+        mSlotCount = std::max<std::size_t>(
+            mMemoryBudget / (mSlotSize * sizeof(CompactBoid)), 2);
+
+        // A fresh vector, so the old reservation is given back.
+        std::vector<CompactBoid>().swap(mSlotStorage);
+        mSlotStorage.reserve(mSlotCount * mSlotSize);
+        mFreeSlots.clear();
+        mFreeSlots.reserve(mSlotCount);
+        mCheckpoints.reserve(mSlotCount);
+    }
+
+    void CheckpointStore::releaseSlot(Checkpoint const& checkpoint)
+    {
+        mFreeSlots.push_back(checkpoint.slot);
+    }
+
+    void CheckpointStore::evict()
+    {
+        // Frame 0 is always a multiple of the interval, so at least the
+        // starting state survives no matter how tight the budget is.
+        while (mCheckpoints.size() >= mSlotCount && mCheckpoints.size() > 1)
+        {
+            mInterval *= 2;
+
+            auto last = std::remove_if(mCheckpoints.begin(), mCheckpoints.end(),
+                [this](Checkpoint const& checkpoint)
+            {
+                if (checkpoint.frame % mInterval == 0)
+                {
+                    return false;
+                }
+
+                mMemoryUsage -= mSlotSize * sizeof(CompactBoid);
+                releaseSlot(checkpoint);
+                return true;
+            });
+            mCheckpoints.erase(last, mCheckpoints.end());
+        }
+    }
+}
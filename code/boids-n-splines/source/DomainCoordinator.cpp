@@ -0,0 +1,234 @@
+#include "DomainCoordinator.hpp"
+#include "FlockSimulation.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace bns
+{
+    namespace
+    {
+        constexpr int ConnectTimeoutMilliseconds = 10000;
+    }
+
+    DomainCoordinator::DomainCoordinator()
+    { }
+
+    bool DomainCoordinator::start(std::vector<std::string> const& workers,
+        FlockParameters const& params)
+    {
+        mParams = params;
+        mWorkers.clear();
+        if (workers.empty())
+        {
+            return false;
+        }
+
+        // Connect to everyone before sending any setup: a worker takes its
+        // first connection to be ours.
+        for (std::string const& text : workers)
+        {
+            Address address;
+            Connection connection;
+            if (!parseAddress(text, address))
+            {
+                ERROR_LOG_V("Bad worker address %s", text.c_str());
+                return false;
+            }
+            if (!connection.connect(address, ConnectTimeoutMilliseconds))
+            {
+                return false;
+            }
+            mWorkers.push_back(std::move(connection));
+        }
+
+        // Scatter exactly as a single-process run with the same seed would,
+        // then cut slabs at the x quantiles so each worker starts with an
+        // equal share.
+        FlockSimulation scatter(params);
+        std::vector<Boid> const& boids = scatter.getBoids();
+
+        std::vector<float> xs;
+        xs.reserve(boids.size());
+        for (Boid const& boid : boids)
+        {
+            xs.push_back(boid.mPosition.x);
+        }
+        std::sort(xs.begin(), xs.end());
+
+        std::size_t count = workers.size();
+        std::vector<float> cuts(count + 1);
+        cuts.front() = -std::numeric_limits<float>::infinity();
+        cuts.back() = std::numeric_limits<float>::infinity();
+        for (std::size_t k = 1; k < count; ++k)
+        {
+            cuts[k] = xs.empty() ? 0.0f : xs[k * xs.size() / count];
+        }
+
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            DomainSetup setup;
+            setup.index = static_cast<std::uint32_t>(k);
+            setup.count = static_cast<std::uint32_t>(count);
+            setup.lower = cuts[k];
+            setup.upper = cuts[k + 1];
+            setup.params = params;
+            if (k + 1 < count)
+            {
+                setup.rightAddress = workers[k + 1];
+            }
+            for (Boid const& boid : boids)
+            {
+                if (boid.mPosition.x >= setup.lower &&
+                    boid.mPosition.x < setup.upper)
+                {
+                    setup.boids.push_back(boid);
+                }
+            }
+
+            MessageBuffer message;
+            writeSetup(message, setup);
+            if (!sendMessage(mWorkers[k], DomainMessage::Setup, message))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool DomainCoordinator::step(DistributedStepStats& stats)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        MessageBuffer message;
+        for (Connection& worker : mWorkers)
+        {
+            if (!sendMessage(worker, DomainMessage::Step, message))
+            {
+                return false;
+            }
+        }
+
+        stats.totalBoids = 0;
+        stats.minOwned = std::numeric_limits<std::uint32_t>::max();
+        stats.maxOwned = 0;
+        stats.haloBoids = 0;
+        stats.migratedBoids = 0;
+        stats.maxStepMilliseconds = 0.0f;
+        for (Connection& worker : mWorkers)
+        {
+            DomainStepReport report;
+            if (!expectMessage(worker, DomainMessage::StepDone, message) ||
+                !message.get(report))
+            {
+                return false;
+            }
+
+            stats.totalBoids += report.ownedBoids;
+            stats.minOwned = std::min(stats.minOwned, report.ownedBoids);
+            stats.maxOwned = std::max(stats.maxOwned, report.ownedBoids);
+            stats.haloBoids += report.haloBoids;
+            stats.migratedBoids += report.migratedBoids;
+            stats.maxStepMilliseconds = std::max(stats.maxStepMilliseconds,
+                report.stepMilliseconds);
+        }
+
+        stats.wallMilliseconds = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    bool DomainCoordinator::gather(std::vector<Boid>& boids)
+    {
+        MessageBuffer message;
+        for (Connection& worker : mWorkers)
+        {
+            if (!sendMessage(worker, DomainMessage::Gather, message))
+            {
+                return false;
+            }
+        }
+
+        boids.clear();
+        std::vector<Boid> owned;
+        for (Connection& worker : mWorkers)
+        {
+            if (!expectMessage(worker, DomainMessage::Boids, message) ||
+                !readBoids(message, mParams.boidRadius, owned))
+            {
+                return false;
+            }
+            boids.insert(boids.end(), owned.begin(), owned.end());
+        }
+
+        // Boids migrate between workers, so put them back in the order they
+        // were scattered in.
+        std::sort(boids.begin(), boids.end(), [](Boid const& a, Boid const& b)
+        {
+            return a.mId < b.mId;
+        });
+        return true;
+    }
+
+    void DomainCoordinator::stop()
+    {
+        MessageBuffer message;
+        for (Connection& worker : mWorkers)
+        {
+            sendMessage(worker, DomainMessage::Stop, message);
+            worker.close();
+        }
+        mWorkers.clear();
+    }
+
+    bool launchLocalWorkers(std::string const& executable, std::size_t count,
+        bool useTcp, std::uint16_t basePort, std::vector<std::string>& addresses,
+        std::vector<int>& processes)
+    {
+        addresses.clear();
+        processes.clear();
+
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            std::string address = useTcp ?
+                "tcp:127.0.0.1:" + std::to_string(basePort + k) :
+                "unix:/tmp/bns-sim-" + std::to_string(getpid()) + "-" +
+                    std::to_string(k) + ".sock";
+
+            std::string mode = "worker";
+            char* argv[] = { const_cast<char*>(executable.c_str()),
+                &mode[0], &address[0], nullptr };
+
+            pid_t process;
+            if (posix_spawn(&process, executable.c_str(), nullptr, nullptr,
+                argv, environ) != 0)
+            {
+                ERROR_LOG_V("Could not start %s", executable.c_str());
+                return false;
+            }
+
+            addresses.push_back(address);
+            processes.push_back(static_cast<int>(process));
+        }
+        return true;
+    }
+
+    void waitForWorkers(std::vector<int> const& processes)
+    {
+        for (int process : processes)
+        {
+            int status;
+            waitpid(static_cast<pid_t>(process), &status, 0);
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#include "DomainProtocol.hpp"
+
+#include <atlas/core/Log.hpp>
+
+namespace bns
+{
+    namespace
+    {
+        struct WireBoid
+        {
+            float position[3];
+            float velocity[3];
+            std::int32_t species;
+            std::uint32_t id;
+        };
+    }
+
+    void writeParameters(MessageBuffer& message, FlockParameters const& params)
+    {
+        message.put(params.separationWeight);
+        message.put(params.alignmentWeight);
+        message.put(params.cohesionWeight);
+        message.put(params.avoidanceWeight);
+        message.put(params.obstacleWeight);
+        message.put(params.fleeWeight);
+        message.put(params.mass);
+        message.put(static_cast<std::int32_t>(params.integrator));
+        message.put(params.timeStep);
+        message.put(params.maxSpeed);
+        message.put(params.maxForce);
+        message.put(params.flockRadius);
+        message.put(params.viewRadius);
+        message.put(params.viewAngle);
+        message.put(params.boidRadius);
+        message.put(params.obstacleMargin);
+        message.put(params.neighbourSkin);
+        message.put(params.farField);
+        message.put(params.nearRadius);
+        message.put(params.farFieldAngle);
+        message.put(params.reorderInterval);
+        message.put(params.continuousCollision);
+        message.put(params.threadCount);
+        message.put(params.partsPerThread);
+        message.put(params.autoTune);
+        message.put(params.numBoids);
+        message.put(params.seed);
+        message.put(params.numSpecies);
+        message.putArray(params.speciesInteraction.data(),
+            params.speciesInteraction.size());
+    }
+
+    bool readParameters(MessageBuffer& message, FlockParameters& params)
+    {
+        std::int32_t integrator = 0;
+        bool ok = message.get(params.separationWeight) &&
+            message.get(params.alignmentWeight) &&
+            message.get(params.cohesionWeight) &&
+            message.get(params.avoidanceWeight) &&
+            message.get(params.obstacleWeight) &&
+            message.get(params.fleeWeight) &&
+            message.get(params.mass) &&
+            message.get(integrator) &&
+            message.get(params.timeStep) &&
+            message.get(params.maxSpeed) &&
+            message.get(params.maxForce) &&
+            message.get(params.flockRadius) &&
+            message.get(params.viewRadius) &&
+            message.get(params.viewAngle) &&
+            message.get(params.boidRadius) &&
+            message.get(params.obstacleMargin) &&
+            message.get(params.neighbourSkin) &&
+            message.get(params.farField) &&
+            message.get(params.nearRadius) &&
+            message.get(params.farFieldAngle) &&
+            message.get(params.reorderInterval) &&
+            message.get(params.continuousCollision) &&
+            message.get(params.threadCount) &&
+            message.get(params.partsPerThread) &&
+            message.get(params.autoTune) &&
+            message.get(params.numBoids) &&
+            message.get(params.seed) &&
+            message.get(params.numSpecies);
+        if (!ok || params.numSpecies < 1 || integrator < 0 || integrator >
+            static_cast<std::int32_t>(IntegratorType::RungeKutta4))
+        {
+            return false;
+        }
+        params.integrator = static_cast<IntegratorType>(integrator);
+
+        std::size_t n = static_cast<std::size_t>(params.numSpecies);
+        params.speciesInteraction.resize(n * n);
+        return message.getArray(params.speciesInteraction.data(), n * n);
+    }
+
+    void writeBoids(MessageBuffer& message, std::vector<Boid> const& boids)
+    {
+        message.put(static_cast<std::uint32_t>(boids.size()));
+        for (Boid const& boid : boids)
+        {
+            WireBoid wire;
+            for (int c = 0; c < 3; ++c)
+            {
+                wire.position[c] = boid.mPosition[c];
+                wire.velocity[c] = boid.mVelocity[c];
+            }
+            wire.species = boid.mSpecies;
+            wire.id = boid.mId;
+            message.put(wire);
+        }
+    }
+
+    bool readBoids(MessageBuffer& message, float radius,
+        std::vector<Boid>& boids)
+    {
+        std::uint32_t count;
+        if (!message.get(count))
+        {
+            return false;
+        }
+
+        boids.clear();
+        boids.reserve(count);
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            WireBoid wire;
+            if (!message.get(wire))
+            {
+                return false;
+            }
+            atlas::math::Vector position(wire.position[0], wire.position[1],
+                wire.position[2]);
+            atlas::math::Vector velocity(wire.velocity[0], wire.velocity[1],
+                wire.velocity[2]);
+            boids.emplace_back(position, velocity, radius, wire.species,
+                wire.id);
+        }
+        return true;
+    }
+
+    void writeSetup(MessageBuffer& message, DomainSetup const& setup)
+    {
+        message.put(setup.index);
+        message.put(setup.count);
+        message.put(setup.lower);
+        message.put(setup.upper);
+        writeParameters(message, setup.params);
+        message.put(static_cast<std::uint32_t>(setup.rightAddress.size()));
+        message.putArray(setup.rightAddress.data(), setup.rightAddress.size());
+        writeBoids(message, setup.boids);
+    }
+
+    bool readSetup(MessageBuffer& message, DomainSetup& setup)
+    {
+        std::uint32_t addressLength;
+        if (!(message.get(setup.index) && message.get(setup.count) &&
+            message.get(setup.lower) && message.get(setup.upper) &&
+            readParameters(message, setup.params) &&
+            message.get(addressLength)))
+        {
+            return false;
+        }
+
+        setup.rightAddress.resize(addressLength);
+        return message.getArray(&setup.rightAddress[0], addressLength) &&
+            readBoids(message, setup.params.boidRadius, setup.boids);
+    }
+
+    bool sendMessage(Connection& connection, DomainMessage type,
+        MessageBuffer const& message)
+    {
+        return connection.send(static_cast<std::uint32_t>(type), message);
+    }
+
+    bool expectMessage(Connection& connection, DomainMessage type,
+        MessageBuffer& message)
+    {
+        std::uint32_t received;
+        if (!connection.receive(received, message))
+        {
+            return false;
+        }
+
+        if (received != static_cast<std::uint32_t>(type))
+        {
+            ERROR_LOG_V("Expected message %u but received %u",
+                static_cast<unsigned>(type), static_cast<unsigned>(received));
+            return false;
+        }
+        return true;
+    }
+}
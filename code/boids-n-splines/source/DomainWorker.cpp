@@ -0,0 +1,309 @@
+#include "DomainWorker.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <chrono>
+
+namespace bns
+{
+    namespace
+    {
+        constexpr int ConnectTimeoutMilliseconds = 10000;
+    }
+
+    DomainWorker::DomainWorker() :
+        mIndex(0),
+        mCount(0),
+        mLower(0.0f),
+        mUpper(0.0f),
+        mHaloWidth(0.0f)
+    { }
+
+    bool DomainWorker::run(Address const& address)
+    {
+        if (!mListener.listen(address))
+        {
+            return false;
+        }
+
+        // The coordinator connects to every worker before it sends any
+        // setup, so it is always the first connection to arrive.
+        mCoordinator = mListener.accept();
+        MessageBuffer message;
+        if (!mCoordinator.isOpen() ||
+            !expectMessage(mCoordinator, DomainMessage::Setup, message) ||
+            !setup(message))
+        {
+            ERROR_LOG("Worker setup failed");
+            return false;
+        }
+
+        for (;;)
+        {
+            std::uint32_t type;
+            if (!mCoordinator.receive(type, message))
+            {
+                return false;
+            }
+
+            switch (static_cast<DomainMessage>(type))
+            {
+            case DomainMessage::Step:
+            {
+                DomainStepReport report;
+                if (!step(report))
+                {
+                    return false;
+                }
+                message.clear();
+                message.put(report);
+                if (!sendMessage(mCoordinator, DomainMessage::StepDone,
+                    message))
+                {
+                    return false;
+                }
+                break;
+            }
+
+            case DomainMessage::Gather:
+                message.clear();
+                writeBoids(message, mSimulation->getBoids());
+                if (!sendMessage(mCoordinator, DomainMessage::Boids, message))
+                {
+                    return false;
+                }
+                break;
+
+            case DomainMessage::Stop:
+                return true;
+
+            default:
+                ERROR_LOG_V("Unexpected message %u", type);
+                return false;
+            }
+        }
+    }
+
+    bool DomainWorker::setup(MessageBuffer& message)
+    {
+        DomainSetup setup;
+        if (!readSetup(message, setup))
+        {
+            return false;
+        }
+
+        mIndex = setup.index;
+        mCount = setup.count;
+        mLower = setup.lower;
+        mUpper = setup.upper;
+
+        FlockParameters params = setup.params;
+        params.numBoids = static_cast<int>(setup.boids.size());
+        mSimulation.reset(new FlockSimulation(params));
+        mSimulation->setBoids(setup.boids);
+        mHaloWidth = mSimulation->getQueryRadius();
+
+        // Each worker opens the link to its right neighbour and accepts the
+        // one from its left, so every link is made exactly once.
+        MessageBuffer hello;
+        hello.put(mIndex);
+        if (!setup.rightAddress.empty())
+        {
+            Address right;
+            if (!parseAddress(setup.rightAddress, right) ||
+                !mRight.connect(right, ConnectTimeoutMilliseconds) ||
+                !sendMessage(mRight, DomainMessage::Hello, hello))
+            {
+                return false;
+            }
+        }
+
+        if (mIndex > 0)
+        {
+            mLeft = mListener.accept();
+            std::uint32_t leftIndex;
+            if (!mLeft.isOpen() ||
+                !expectMessage(mLeft, DomainMessage::Hello, hello) ||
+                !hello.get(leftIndex) || leftIndex + 1 != mIndex)
+            {
+                return false;
+            }
+        }
+
+        INFO_LOG_V("Worker %u/%u owns x in [%g, %g) with %u boids", mIndex,
+            mCount, mLower, mUpper,
+            static_cast<unsigned>(setup.boids.size()));
+        return true;
+    }
+
+    bool DomainWorker::step(DomainStepReport& report)
+    {
+        std::vector<Boid> ghosts;
+        if (!exchangeHalos(ghosts))
+        {
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        mSimulation->setGhosts(ghosts);
+        mSimulation->step();
+        auto end = std::chrono::steady_clock::now();
+
+        if (!migrate(report.migratedBoids))
+        {
+            return false;
+        }
+
+        report.ownedBoids =
+            static_cast<std::uint32_t>(mSimulation->getBoids().size());
+        report.haloBoids = static_cast<std::uint32_t>(ghosts.size());
+        report.stepMilliseconds =
+            std::chrono::duration<float, std::milli>(end - start).count();
+        return true;
+    }
+
+    bool DomainWorker::exchangeHalos(std::vector<Boid>& ghosts)
+    {
+        std::vector<Boid> leftHalo;
+        std::vector<Boid> rightHalo;
+        for (Boid const& boid : mSimulation->getBoids())
+        {
+            if (boid.mPosition.x < mLower + mHaloWidth)
+            {
+                leftHalo.push_back(boid);
+            }
+            if (boid.mPosition.x >= mUpper - mHaloWidth)
+            {
+                rightHalo.push_back(boid);
+            }
+        }
+
+        MessageBuffer toLeft, toRight, fromLeft, fromRight;
+        writeBoids(toLeft, leftHalo);
+        writeBoids(toRight, rightHalo);
+        if (!exchange(DomainMessage::Halo, toLeft, toRight, fromLeft,
+            fromRight))
+        {
+            return false;
+        }
+
+        float radius = mSimulation->getParameters().boidRadius;
+        std::vector<Boid> received;
+        ghosts.clear();
+        if (mLeft.isOpen())
+        {
+            if (!readBoids(fromLeft, radius, received))
+            {
+                return false;
+            }
+            ghosts.insert(ghosts.end(), received.begin(), received.end());
+        }
+        if (mRight.isOpen())
+        {
+            if (!readBoids(fromRight, radius, received))
+            {
+                return false;
+            }
+            ghosts.insert(ghosts.end(), received.begin(), received.end());
+        }
+        return true;
+    }
+
+    bool DomainWorker::migrate(std::uint32_t& migrated)
+    {
+        std::vector<Boid> kept;
+        std::vector<Boid> leaving[2];
+        for (Boid const& boid : mSimulation->getBoids())
+        {
+            if (boid.mPosition.x < mLower)
+            {
+                leaving[0].push_back(boid);
+            }
+            else if (boid.mPosition.x >= mUpper)
+            {
+                leaving[1].push_back(boid);
+            }
+            else
+            {
+                kept.push_back(boid);
+            }
+        }
+
+        MessageBuffer toLeft, toRight, fromLeft, fromRight;
+        writeBoids(toLeft, leaving[0]);
+        writeBoids(toRight, leaving[1]);
+        if (!exchange(DomainMessage::Migrate, toLeft, toRight, fromLeft,
+            fromRight))
+        {
+            return false;
+        }
+
+        float radius = mSimulation->getParameters().boidRadius;
+        std::vector<Boid> arrived;
+        migrated = 0;
+        if (mLeft.isOpen())
+        {
+            if (!readBoids(fromLeft, radius, arrived))
+            {
+                return false;
+            }
+            kept.insert(kept.end(), arrived.begin(), arrived.end());
+            migrated += static_cast<std::uint32_t>(arrived.size());
+        }
+        if (mRight.isOpen())
+        {
+            if (!readBoids(fromRight, radius, arrived))
+            {
+                return false;
+            }
+            kept.insert(kept.end(), arrived.begin(), arrived.end());
+            migrated += static_cast<std::uint32_t>(arrived.size());
+        }
+
+        // A boid that skipped past a whole slab in one step lands out of
+        // bounds here and is passed on again after the next step.
+        mSimulation->setBoids(kept);
+        return true;
+    }
+
+    bool DomainWorker::exchange(DomainMessage type,
+        MessageBuffer const& toLeft, MessageBuffer const& toRight,
+        MessageBuffer& fromLeft, MessageBuffer& fromRight)
+    {
+        // Links (0,1), (2,3), ... go first, then (1,2), (3,4), ...; the
+        // lower index of each pair sends first.
+        bool even = (mIndex % 2) == 0;
+        for (int phase = 0; phase < 2; ++phase)
+        {
+            bool rightPhase = (phase == 0) == even;
+            if (rightPhase && mRight.isOpen())
+            {
+                if (!exchangeWith(mRight, true, type, toRight, fromRight))
+                {
+                    return false;
+                }
+            }
+            else if (!rightPhase && mLeft.isOpen())
+            {
+                if (!exchangeWith(mLeft, false, type, toLeft, fromLeft))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool DomainWorker::exchangeWith(Connection& peer, bool sendFirst,
+        DomainMessage type, MessageBuffer const& outgoing,
+        MessageBuffer& incoming)
+    {
+        if (sendFirst)
+        {
+            return sendMessage(peer, type, outgoing) &&
+                expectMessage(peer, type, incoming);
+        }
+        return expectMessage(peer, type, incoming) &&
+            sendMessage(peer, type, outgoing);
+    }
+}
@@ -0,0 +1,153 @@
+#include "FlockExportReader.hpp"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bns
+{
+    namespace
+    {
+        // Only so many attempts are made to catch a slot between writes; a
+        // reader losing that race every time is simply too slow.
+        constexpr int AcquireAttempts = 16;
+    }
+
+    FlockExportReader::FlockExportReader() :
+        mData(nullptr),
+        mSize(0),
+        mHeader(nullptr)
+    { }
+
+    FlockExportReader::~FlockExportReader()
+    {
+        close();
+    }
+
+    bool FlockExportReader::open(std::string const& name)
+    {
+        close();
+
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 ||
+            static_cast<std::size_t>(info.st_size) < sizeof(FlockExportHeader))
+        {
+            ::close(fd);
+            return false;
+        }
+
+        std::size_t size = static_cast<std::size_t>(info.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+
+        mData = static_cast<std::uint8_t const*>(data);
+        mSize = size;
+        mHeader = reinterpret_cast<FlockExportHeader const*>(mData);
+
+        // The writer may still be filling in the header; treat that the same
+        // as a bad version and let the caller retry.
+        bool valid = std::memcmp(mHeader->magic, FlockExportMagic,
+            sizeof(FlockExportMagic)) == 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        valid = valid && mHeader->version == FlockExportVersion &&
+            mHeader->slotCount > 0 &&
+            mHeader->headerSize + mHeader->slotSize * mHeader->slotCount <= mSize;
+        if (!valid)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void FlockExportReader::close()
+    {
+        if (mData != nullptr)
+        {
+            munmap(const_cast<std::uint8_t*>(mData), mSize);
+        }
+        mData = nullptr;
+        mHeader = nullptr;
+        mSize = 0;
+    }
+
+    bool FlockExportReader::isOpen() const
+    {
+        return mData != nullptr;
+    }
+
+    bool FlockExportReader::isWriterClosed() const
+    {
+        return mHeader == nullptr ||
+            mHeader->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    std::uint64_t FlockExportReader::getPublishedCount() const
+    {
+        return (mHeader == nullptr) ? 0 :
+            mHeader->published.load(std::memory_order_acquire);
+    }
+
+    bool FlockExportReader::acquireLatest(FlockFrameView& view) const
+    {
+        if (mHeader == nullptr)
+        {
+            return false;
+        }
+
+        for (int attempt = 0; attempt < AcquireAttempts; ++attempt)
+        {
+            std::uint64_t published =
+                mHeader->published.load(std::memory_order_acquire);
+            if (published == 0)
+            {
+                return false;
+            }
+
+            std::uint64_t index = published - 1;
+            FlockExportSlot const* slot =
+                reinterpret_cast<FlockExportSlot const*>(mData +
+                mHeader->headerSize +
+                mHeader->slotSize * (index % mHeader->slotCount));
+
+            std::uint64_t sequence =
+                slot->sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * index + 2)
+            {
+                // The writer has already moved on to this slot again.
+                continue;
+            }
+
+            view.boids = reinterpret_cast<FlockExportBoid const*>(slot + 1);
+            view.boidCount = slot->boidCount;
+            view.frame = slot->frame;
+            view.sequence = sequence;
+            view.slot = slot;
+            if (view.boidCount <= mHeader->boidCapacity && isValid(view))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool FlockExportReader::isValid(FlockFrameView const& view) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return view.slot->sequence.load(std::memory_order_relaxed) ==
+            view.sequence;
+    }
+}
@@ -0,0 +1,111 @@
+#include "FlockMetrics.hpp"
+
+namespace bns
+{
+    FlockAnalytics::FlockAnalytics() :
+        mLinkDistance(0.0f),
+        mNearestSum(0.0),
+        mNearestCount(0),
+        mCollisions(0)
+    { }
+
+    void FlockAnalytics::begin(std::size_t boidCount, float linkDistance)
+    {
+        // Only boids that were linked last time moved off their own root, so
+        // a flock of the same size can skip the full reset.
+        if (mParent.size() == boidCount)
+        {
+            for (auto const& link : mLinks)
+            {
+                mParent[link.second] = link.second;
+            }
+        }
+        else
+        {
+            mParent.resize(boidCount);
+            for (std::size_t i = 0; i < boidCount; ++i)
+            {
+                mParent[i] = static_cast<std::uint32_t>(i);
+            }
+            // Every link joins two trees, so there are fewer links than
+            // boids and a denser flock never has to grow the list.
+            mLinks.reserve(boidCount);
+        }
+        mLinks.clear();
+
+        mLinkDistance = linkDistance;
+        mNearestSum = 0.0;
+        mNearestCount = 0;
+        mCollisions = 0;
+    }
+
+    void FlockAnalytics::merge(FlockAnalytics const& other)
+    {
+        for (auto const& link : other.mLinks)
+        {
+            unite(link.first, link.second);
+        }
+        mNearestSum += other.mNearestSum;
+        mNearestCount += other.mNearestCount;
+        mCollisions += other.mCollisions;
+    }
+
+    FlockMetrics FlockAnalytics::finish(std::vector<Boid> const& boids)
+    {
+        FlockMetrics metrics{ 0.0f, 0.0f, mCollisions, 0 };
+
+        atlas::math::Vector heading(0.0f);
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            heading += boids[i].mForward;
+        }
+        for (std::size_t i = 0; i < mParent.size(); ++i)
+        {
+            if (mParent[i] == i)
+            {
+                metrics.clusters++;
+            }
+        }
+
+        if (!boids.empty())
+        {
+            metrics.polarisation = glm::length(heading) / boids.size();
+        }
+        if (mNearestCount > 0)
+        {
+            metrics.meanNearestDistance =
+                static_cast<float>(mNearestSum / mNearestCount);
+        }
+        return metrics;
+    }
+
+    std::uint32_t FlockAnalytics::find(std::uint32_t index)
+    {
+        // Path halving keeps the trees flat without a second pass.
+        while (mParent[index] != index)
+        {
+            mParent[index] = mParent[mParent[index]];
+            index = mParent[index];
+        }
+        return index;
+    }
+
+    void FlockAnalytics::unite(std::uint32_t a, std::uint32_t b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a != b)
+        {
+            if (a < b)
+            {
+                mParent[b] = a;
+                mLinks.emplace_back(a, b);
+            }
+            else
+            {
+                mParent[a] = b;
+                mLinks.emplace_back(b, a);
+            }
+        }
+    }
+}
@@ -0,0 +1,177 @@
+#include "FlockPublisher.hpp"
+
+#include <atlas/core/Log.hpp>
+#include <atlas/core/Macros.hpp>
+
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace bns
+{
+    FlockPublisher::FlockPublisher() :
+        mData(nullptr),
+        mSize(0),
+        mHeader(nullptr)
+    { }
+
+    FlockPublisher::~FlockPublisher()
+    {
+        close();
+    }
+
+    bool FlockPublisher::open(std::string const& name,
+        std::size_t boidCapacity, std::uint32_t slotCount)
+    {
+        close();
+
+#ifdef _WIN32
+        UNUSED(name);
+        UNUSED(boidCapacity);
+        UNUSED(slotCount);
+        ERROR_LOG("Shared memory export needs POSIX shared memory");
+        return false;
+#else
+        std::size_t headerSize = alignExport(sizeof(FlockExportHeader));
+        std::size_t slotSize = alignExport(sizeof(FlockExportSlot) +
+            boidCapacity * sizeof(FlockExportBoid));
+        std::size_t size = headerSize + slotSize * slotCount;
+
+        // Start from a fresh object so readers of an old one are not handed
+        // a layout that changes underneath them.
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+        {
+            ERROR_LOG_V("Could not create shared memory %s", name.c_str());
+            return false;
+        }
+
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            ERROR_LOG_V("Could not size shared memory %s", name.c_str());
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            ERROR_LOG_V("Could not map shared memory %s", name.c_str());
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        mName = name;
+        mData = static_cast<std::uint8_t*>(data);
+        mSize = size;
+
+        // ftruncate zero-fills, so only the non-zero fields need writing.
+        mHeader = new (mData) FlockExportHeader;
+        mHeader->version = FlockExportVersion;
+        mHeader->headerSize = static_cast<std::uint32_t>(headerSize);
+        mHeader->slotCount = slotCount;
+        mHeader->boidCapacity = static_cast<std::uint32_t>(boidCapacity);
+        mHeader->slotSize = slotSize;
+        mHeader->published.store(0, std::memory_order_relaxed);
+        mHeader->closed.store(0, std::memory_order_relaxed);
+        for (std::uint32_t i = 0; i < slotCount; ++i)
+        {
+            new (mData + headerSize + slotSize * i) FlockExportSlot;
+            getSlot(i)->sequence.store(0, std::memory_order_relaxed);
+        }
+
+        // A reader that sees the magic must see the rest of the header too,
+        // so it goes in last.
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(mHeader->magic, FlockExportMagic, sizeof(FlockExportMagic));
+        return true;
+#endif
+    }
+
+    void FlockPublisher::close()
+    {
+        if (mData == nullptr)
+        {
+            return;
+        }
+
+        mHeader->closed.store(1, std::memory_order_release);
+#ifndef _WIN32
+        munmap(mData, mSize);
+        shm_unlink(mName.c_str());
+#endif
+
+        mData = nullptr;
+        mHeader = nullptr;
+        mSize = 0;
+    }
+
+    bool FlockPublisher::isOpen() const
+    {
+        return mData != nullptr;
+    }
+
+    void FlockPublisher::publish(std::vector<Boid> const& boids,
+        std::uint64_t frame)
+    {
+        if (mData == nullptr)
+        {
+            return;
+        }
+
+        if (boids.size() > mHeader->boidCapacity)
+        {
+            std::uint32_t slotCount = mHeader->slotCount;
+            std::string name = mName;
+            if (!open(name, boids.size(), slotCount))
+            {
+                return;
+            }
+        }
+
+        std::uint64_t index = mHeader->published.load(std::memory_order_relaxed);
+        FlockExportSlot* slot = getSlot(index % mHeader->slotCount);
+
+        slot->sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot->frame = frame;
+        slot->boidCount = static_cast<std::uint32_t>(boids.size());
+        FlockExportBoid* out = reinterpret_cast<FlockExportBoid*>(slot + 1);
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            Boid const& boid = boids[i];
+            for (int c = 0; c < 3; ++c)
+            {
+                out[i].position[c] = boid.mPosition[c];
+                out[i].forward[c] = boid.mForward[c];
+                out[i].velocity[c] = boid.mVelocity[c];
+            }
+            out[i].species = boid.mSpecies;
+        }
+
+        slot->sequence.store(2 * index + 2, std::memory_order_release);
+        mHeader->published.store(index + 1, std::memory_order_release);
+    }
+
+    std::uint64_t FlockPublisher::getPublishedCount() const
+    {
+        return (mHeader == nullptr) ? 0 :
+            mHeader->published.load(std::memory_order_relaxed);
+    }
+
+    FlockExportSlot* FlockPublisher::getSlot(std::uint64_t index) const
+    {
+        return reinterpret_cast<FlockExportSlot*>(mData +
+            mHeader->headerSize + mHeader->slotSize * index);
+    }
+}
@@ -0,0 +1,1236 @@
+#include "FlockSimulation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <math.h>
+
+namespace bns
+{
+    namespace
+    {
+        constexpr std::uint64_t CheckpointInterval = 60;
+        constexpr std::size_t CheckpointBudget = 64 * 1024 * 1024;
+        constexpr std::size_t FarFieldLeafSize = 8;
+
+        // Length of the original fixed step, which speeds and forces are
+        // still measured against.
+        constexpr float TickSeconds = 1.0f / 60.0f;
+
+        // Estimated work of a boid beyond its neighbour pairs (obstacle
+        // sampling, combining the rules), in units of one pair.
+        constexpr float BoidBaseCost = 4.0f;
+
+        // Re-sweeps of the collision pairs before stuck pairs are frozen,
+        // how far short of contact boids stop, and how close counts as
+        // resting in contact.
+        constexpr int CollisionPasses = 4;
+        // Sweeps stop after this many passes even if something still moved.
+        constexpr int MaxCollisionPasses = 4 * CollisionPasses;
+        constexpr float CollisionSlack = 0.99f;
+        constexpr float ContactTolerance = 1.01f;
+
+        // Spreads the low 10 bits of v so that there are two zero bits
+        // between each of them.
+        std::uint32_t spreadBits(std::uint32_t v)
+        {
+            v &= 0x3ff;
+            v = (v | (v << 16)) & 0x030000ff;
+            v = (v | (v << 8)) & 0x0300f00f;
+            v = (v | (v << 4)) & 0x030c30c3;
+            v = (v | (v << 2)) & 0x09249249;
+            return v;
+        }
+    }
+
+    FlockSimulation::FlockSimulation(FlockParameters const& params) :
+        mParams(params),
+        mRandom(params.seed),
+        mFrame(0),
+        mObstacles(nullptr),
+        mNeighbours(nullptr),
+        mCosViewAngle(0.0f),
+        mIntegratorType(params.integrator),
+        mLoadBalance{ 0, 0, 0.0f, 0.0f, 0.0f, 0.0f },
+        mMetrics{ 0.0f, 0.0f, 0, 0 },
+        mCheckpoints(CheckpointInterval, CheckpointBudget)
+    {
+        mBoids.resize(mParams.numBoids);
+        scatterBoids();
+
+        mCheckpoints.capture(mFrame, mBoids);
+    }
+
+    void FlockSimulation::step()
+    {
+        auto stepStart = std::chrono::steady_clock::now();
+        if (mParams.autoTune)
+        {
+            applyTunedSettings();
+        }
+
+        // Re-sorting on a fixed frame schedule keeps seeks exact: a replayed
+        // frame sums its neighbours in the same order as the first time.
+        if (mParams.reorderInterval > 0 &&
+            mFrame % static_cast<std::uint64_t>(mParams.reorderInterval) == 0)
+        {
+            reorderBoids();
+        }
+
+        if (!mIntegrator || mIntegratorType != mParams.integrator)
+        {
+            mIntegrator = makeIntegrator(mParams.integrator);
+            mIntegratorType = mParams.integrator;
+        }
+
+        // Metrics describe the flock at the start of the step, so only the
+        // first evaluation gathers them.
+        float ticks = mParams.timeStep / TickSeconds;
+        bool analyse = true;
+        mIntegrator->step(mBoids, ticks, mParams.maxSpeed,
+            [this, &analyse](std::vector<atlas::math::Vector>& accelerations)
+        {
+            computeAccelerations(accelerations, analyse);
+            analyse = false;
+        }, mDisplacements);
+
+        if (mParams.continuousCollision)
+        {
+            // Boids stop at their first contact this step and lose the part
+            // of their velocity that drives them into each other.
+            resolveCollisions(ticks);
+            for(std::size_t i = 0; i < mBoids.size(); i++)
+            {
+                mBoids[i].mPosition += mDisplacements[i] * mAdvance[i];
+                mBoids[i].mVelocity += mImpulses[i];
+                mBoids[i].mForward = normalize(mBoids[i].mVelocity);
+            }
+        }
+        else
+        {
+            for(std::size_t i = 0; i < mBoids.size(); i++)
+            {
+                mBoids[i].mPosition += mDisplacements[i];
+                mBoids[i].mForward = normalize(mBoids[i].mVelocity);
+            }
+        }
+
+        mFrame++;
+        mCheckpoints.capture(mFrame, mBoids);
+
+        if (mParams.autoTune && !mBoids.empty())
+        {
+            double milliseconds = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - stepStart).count();
+            mTuner.record(milliseconds,
+                static_cast<float>(mNeighbourList.getPairCount()) /
+                static_cast<float>(mBoids.size()));
+        }
+    }
+
+    void FlockSimulation::applyTunedSettings()
+    {
+        if (!mTuner.isStarted())
+        {
+            unsigned hardware = std::max(std::thread::hardware_concurrency(),
+                1u);
+            int threads = (mParams.threadCount > 0) ? mParams.threadCount :
+                static_cast<int>(hardware);
+            mTuner.start({ mParams.neighbourSkin, threads,
+                mParams.partsPerThread }, getQueryRadius(), hardware);
+        }
+
+        // None of these change the boids: each force is summed by a single
+        // thread, and neighbour lists come out sorted whatever the skin.
+        TunedSettings const& settings = mTuner.getSettings();
+        mParams.neighbourSkin = settings.neighbourSkin;
+        mParams.threadCount = settings.threadCount;
+        mParams.partsPerThread = settings.partsPerThread;
+    }
+
+    float FlockSimulation::timeOfImpact(atlas::math::Vector const& offset,
+        atlas::math::Vector const& motion, float contact) const
+    {
+        // Solve |offset + motion * t| = contact for the first t in [0, 1).
+        float a = dot(motion, motion);
+        float b = 2.0f * dot(offset, motion);
+        float c = dot(offset, offset) - contact * contact;
+        // Spheres that already overlap are left for separation to push
+        // apart; stopping them here would pin them together.
+        if (c <= 0.0f || a <= 0.0f || b >= 0.0f)
+        {
+            return 1.0f;
+        }
+
+        float discriminant = b * b - 4.0f * a * c;
+        if (discriminant < 0.0f)
+        {
+            return 1.0f;
+        }
+        float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+        return (t < 1.0f) ? std::max(t, 0.0f) : 1.0f;
+    }
+
+    void FlockSimulation::resolveCollisions(float ticks)
+    {
+        // Sweeps follow the displacement the integrator settled on, which
+        // for higher-order schemes is not just the new velocity times the
+        // step; ghosts are assumed to keep their velocity.
+        std::size_t count = mBoids.size();
+
+        // The neighbourhood copy was taken at the integrator's last
+        // evaluation, which for Verlet and RK4 is a trial state rather than
+        // where the boids start, so it is rebuilt from the boids as they
+        // now stand.
+        std::vector<Boid> const* sweep = &mBoids;
+        if (!mGhosts.empty())
+        {
+            mNeighbourhood.assign(mBoids.begin(), mBoids.end());
+            mNeighbourhood.insert(mNeighbourhood.end(), mGhosts.begin(),
+                mGhosts.end());
+            sweep = &mNeighbourhood;
+        }
+        std::vector<Boid> const& everyone = *sweep;
+        auto velocityOf = [&](std::uint32_t index)
+        {
+            return (index < count) ? mBoids[index].mVelocity :
+                mGhosts[index - count].mVelocity;
+        };
+        auto motionOf = [&](std::uint32_t index)
+        {
+            return (index < count) ? mDisplacements[index] :
+                mGhosts[index - count].mVelocity * ticks;
+        };
+
+        // Broadphase: two spheres can only meet this step if they start
+        // within the sum of their radii and their motions.
+        float radius = 0.0f;
+        float motion = 0.0f;
+        for (std::size_t i = 0; i < everyone.size(); i++)
+        {
+            radius = std::max(radius, everyone[i].mRadius);
+            motion = std::max(motion, mag(motionOf(
+                static_cast<std::uint32_t>(i))));
+        }
+        float reach = 2.0f * (radius + motion);
+
+        mCollisionPairs.clear();
+        if (reach > 0.0f)
+        {
+            mCollisionGrid.build(everyone, reach);
+            for (std::uint32_t i = 0; i < count; i++)
+            {
+                mCollisionGrid.forEachNear(everyone[i].mPosition,
+                    [&](std::uint32_t j)
+                {
+                    // Each pair once; ghosts are only seen from this side.
+                    if (j > i && mag(everyone[j].mPosition -
+                        everyone[i].mPosition) <= reach)
+                    {
+                        mCollisionPairs.push_back({ i, j });
+                    }
+                });
+            }
+        }
+
+        // Pairs already in contact lose their closing speed up front, so
+        // they slide along each other instead of pressing further in.
+        for (auto const& pair : mCollisionPairs)
+        {
+            Boid const& a = everyone[pair.first];
+            Boid const& b = everyone[pair.second];
+            atlas::math::Vector offset = b.mPosition - a.mPosition;
+            float distance = mag(offset);
+            if (distance <= 0.0f ||
+                distance >= (a.mRadius + b.mRadius) * ContactTolerance)
+            {
+                continue;
+            }
+
+            atlas::math::Vector normal = offset / distance;
+            float closing = dot(velocityOf(pair.first) -
+                velocityOf(pair.second), normal);
+            if (closing > 0.0f)
+            {
+                mBoids[pair.first].mVelocity -= normal * (0.5f * closing);
+                if (pair.second < count)
+                {
+                    mBoids[pair.second].mVelocity += normal * (0.5f * closing);
+                }
+            }
+            float closingMotion = dot(motionOf(pair.first) -
+                motionOf(pair.second), normal);
+            if (closingMotion > 0.0f)
+            {
+                mDisplacements[pair.first] -= normal * (0.5f * closingMotion);
+                if (pair.second < count)
+                {
+                    mDisplacements[pair.second] +=
+                        normal * (0.5f * closingMotion);
+                }
+            }
+        }
+
+        // Every boid gets the fraction of its motion it can make before its
+        // first contact. Holding one boid back can put it in another's way,
+        // so the pairs are swept again until nothing changes; ghosts always
+        // make their full motion, as their owner will move them.
+        mAdvance.assign(count, 1.0f);
+        mImpulses.assign(count, atlas::math::Vector(0.0f));
+        auto advanceOf = [&](std::uint32_t index)
+        {
+            return (index < count) ? mAdvance[index] : 1.0f;
+        };
+
+        // Scales a boid's advance by t; true if that held it back further.
+        auto holdBack = [&](std::uint32_t index, float t)
+        {
+            if (index >= count || mAdvance[index] * t >= mAdvance[index])
+            {
+                return false;
+            }
+            mAdvance[index] *= t;
+            return true;
+        };
+
+        for (int pass = 0; pass < MaxCollisionPasses; ++pass)
+        {
+            bool changed = false;
+            for (auto const& pair : mCollisionPairs)
+            {
+                // Nothing left to hold back: pair.first is always owned,
+                // and a ghost partner keeps its full motion regardless.
+                if (advanceOf(pair.first) <= 0.0f &&
+                    (pair.second >= count || advanceOf(pair.second) <= 0.0f))
+                {
+                    continue;
+                }
+
+                Boid const& a = everyone[pair.first];
+                Boid const& b = everyone[pair.second];
+                atlas::math::Vector offset = b.mPosition - a.mPosition;
+                atlas::math::Vector motion =
+                    motionOf(pair.second) * advanceOf(pair.second) -
+                    motionOf(pair.first) * advanceOf(pair.first);
+                float t = timeOfImpact(offset, motion, a.mRadius + b.mRadius);
+                if (t >= 1.0f)
+                {
+                    continue;
+                }
+
+                // Give up on pairs that keep colliding and hold them still.
+                // Only a hit that holds an owned boid back further counts
+                // as a change, so frozen boids cannot keep the sweep going.
+                t = (pass >= CollisionPasses) ? 0.0f : t * CollisionSlack;
+                bool heldFirst = holdBack(pair.first, t);
+                bool heldSecond = holdBack(pair.second, t);
+                changed = changed || heldFirst || heldSecond;
+
+                if (pass == 0)
+                {
+                    // Equal masses, perfectly inelastic along the normal.
+                    atlas::math::Vector normal = normalize(offset + motion * t);
+                    float closing = dot(velocityOf(pair.first) -
+                        velocityOf(pair.second), normal);
+                    if (closing > 0.0f)
+                    {
+                        mImpulses[pair.first] -= normal * (0.5f * closing);
+                        if (pair.second < count)
+                        {
+                            mImpulses[pair.second] += normal * (0.5f * closing);
+                        }
+                    }
+                }
+            }
+
+            if (!changed)
+            {
+                break;
+            }
+        }
+    }
+
+    void FlockSimulation::reorderBoids()
+    {
+        if (mBoids.empty())
+        {
+            return;
+        }
+
+        atlas::math::Vector lower = mBoids[0].mPosition;
+        atlas::math::Vector upper = mBoids[0].mPosition;
+        for (std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            lower = glm::min(lower, mBoids[i].mPosition);
+            upper = glm::max(upper, mBoids[i].mPosition);
+        }
+        atlas::math::Vector extent = upper - lower;
+        float scale = 1023.0f / std::max(std::max(extent.x, extent.y),
+            std::max(extent.z, 1e-6f));
+
+        // Sorting by Morton code (interleaved quantised coordinates) puts
+        // boids that are close in space mostly close in memory, so the
+        // neighbour loops touch a few cache lines instead of the whole flock.
+        mOrder.resize(mBoids.size());
+        for (std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            atlas::math::Vector cell = (mBoids[i].mPosition - lower) * scale;
+            std::uint32_t x = static_cast<std::uint32_t>(cell.x);
+            std::uint32_t y = static_cast<std::uint32_t>(cell.y);
+            std::uint32_t z = static_cast<std::uint32_t>(cell.z);
+            std::uint32_t code = spreadBits(x) | (spreadBits(y) << 1) |
+                (spreadBits(z) << 2);
+            mOrder[i] = { code, static_cast<std::uint32_t>(i) };
+        }
+        std::sort(mOrder.begin(), mOrder.end());
+
+        mReordered.resize(mBoids.size());
+        for (std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            mReordered[i] = mBoids[mOrder[i].second];
+        }
+        mBoids.swap(mReordered);
+        updateSlots();
+
+        // The lists hold slots, which now belong to other boids.
+        mNeighbourList.invalidate();
+    }
+
+    void FlockSimulation::updateSlots()
+    {
+        std::uint32_t count = 0;
+        for (std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            count = std::max(count, mBoids[i].mId + 1);
+        }
+
+        mSlots.assign(count, NoBoidSlot);
+        for (std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            mSlots[mBoids[i].mId] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    void FlockSimulation::prepareNeighbours()
+    {
+        mNeighbours = &mBoids;
+        if (!mGhosts.empty())
+        {
+            mNeighbourhood.assign(mBoids.begin(), mBoids.end());
+            mNeighbourhood.insert(mNeighbourhood.end(), mGhosts.begin(),
+                mGhosts.end());
+            mNeighbours = &mNeighbourhood;
+        }
+
+        // Ghosts are replaced wholesale every step, so lists that include
+        // them can never be reused.
+        if (!mGhosts.empty() || mNeighbourList.isStale(mBoids,
+            getQueryRadius(), mParams.neighbourSkin))
+        {
+            mNeighbourList.build(*mNeighbours, mBoids.size(), mGrid,
+                getQueryRadius(), mParams.neighbourSkin);
+        }
+
+        mCosViewAngle = cos(mParams.viewAngle);
+        if (mParams.farField)
+        {
+            buildFarField();
+        }
+    }
+
+    void FlockSimulation::seek(std::uint64_t frame)
+    {
+        // Stepping forward from the current frame is never slower than
+        // going back to a checkpoint first.
+        Checkpoint const* checkpoint = mCheckpoints.findNearest(frame);
+        if (checkpoint != nullptr && (frame < mFrame ||
+            checkpoint->frame > mFrame))
+        {
+            // Put every boid back in the slot it had at the checkpoint, so
+            // the neighbours are summed in the same order as before.
+            mReordered.resize(mBoids.size());
+            for (std::size_t i = 0; i < mBoids.size(); i++)
+            {
+                CompactBoid const& saved = checkpoint->boids[i];
+                mReordered[i] = mBoids[mSlots[saved.id]];
+                mReordered[i].mPosition = saved.position;
+                mReordered[i].mVelocity = saved.velocity;
+                mReordered[i].mForward = normalize(saved.velocity);
+            }
+            mBoids.swap(mReordered);
+            updateSlots();
+            mNeighbourList.invalidate();
+            mFrame = checkpoint->frame;
+        }
+
+        while (mFrame < frame)
+        {
+            step();
+        }
+    }
+
+    std::vector<Boid> const& FlockSimulation::getBoids() const
+    {
+        return mBoids;
+    }
+
+    std::vector<std::uint32_t> const& FlockSimulation::getSlots() const
+    {
+        return mSlots;
+    }
+
+    std::uint64_t FlockSimulation::getFrame() const
+    {
+        return mFrame;
+    }
+
+    FlockParameters const& FlockSimulation::getParameters() const
+    {
+        return mParams;
+    }
+
+    CheckpointStore const& FlockSimulation::getCheckpoints() const
+    {
+        return mCheckpoints;
+    }
+
+    FlockMetrics const& FlockSimulation::getMetrics() const
+    {
+        return mMetrics;
+    }
+
+    NeighbourList const& FlockSimulation::getNeighbourList() const
+    {
+        return mNeighbourList;
+    }
+
+    LoadBalanceStats const& FlockSimulation::getLoadBalance() const
+    {
+        return mLoadBalance;
+    }
+
+    TunerStatus FlockSimulation::getTunerStatus() const
+    {
+        return mTuner.getStatus();
+    }
+
+    void FlockSimulation::computeAccelerations(
+        std::vector<atlas::math::Vector>& accelerations, bool analyse)
+    {
+        // Every boid sees the flock as it was at the start of the stage, so
+        // forces are computed for all of them before any of them moves.
+        prepareNeighbours();
+
+        mForces.resize(mBoids.size());
+        float linkDistance = std::min(mParams.viewRadius, getQueryRadius());
+        if (analyse)
+        {
+            mAnalytics.begin(mBoids.size(), linkDistance);
+        }
+
+        unsigned threads = (mParams.threadCount > 0) ?
+            static_cast<unsigned>(mParams.threadCount) :
+            std::max(std::thread::hardware_concurrency(), 1u);
+        if (threads > 1 && mBoids.size() > threads)
+        {
+            if (!mPool || mPool->getThreadCount() != threads)
+            {
+                mPool.reset(new ThreadPool(threads));
+            }
+            computeForcesInParallel(linkDistance, analyse);
+        }
+        else
+        {
+            for(std::size_t i = 0; i < mBoids.size(); i++)
+            {
+                computeForces(i, analyse ? &mAnalytics : nullptr);
+            }
+        }
+        if (analyse)
+        {
+            mMetrics = mAnalytics.finish(mBoids);
+        }
+
+        for(std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            accelerations[i] = clampLength(mForces[i], mParams.maxForce) /
+                mParams.mass;
+        }
+    }
+
+    void FlockSimulation::computeForces(std::size_t index,
+        FlockAnalytics* analytics)
+    {
+        mForces[index] = computeNeighbourForces(index, analytics) +
+            computeObstacleAvoidance(mBoids[index]) * mParams.obstacleWeight;
+    }
+
+    void FlockSimulation::computeForcesInParallel(float linkDistance,
+        bool analyse)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Each boid costs about one unit per neighbour pair, and the cached
+        // lists already hold those counts, so parts are cut to equal summed
+        // cost rather than equal boid counts. Forces do not depend on which
+        // part a boid lands in, so the result matches a serial step.
+        mCosts.resize(mBoids.size());
+        for (std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            mCosts[i] = BoidBaseCost +
+                static_cast<float>(mNeighbourList.getNeighbourCount(i));
+        }
+
+        // More parts than threads lets the pool even out what the cost
+        // estimate got wrong, at the price of more scheduling.
+        std::size_t threads = mPool->getThreadCount();
+        std::size_t parts = threads * static_cast<std::size_t>(
+            std::max(mParams.partsPerThread, 1));
+        mPartitioner.partition(mBoids, mCosts, parts);
+
+        mThreadAnalytics.resize(threads);
+        if (analyse)
+        {
+            for (auto& analytics : mThreadAnalytics)
+            {
+                analytics.begin(mBoids.size(), linkDistance);
+            }
+        }
+        mThreadMilliseconds.assign(threads, 0.0);
+
+        std::vector<std::uint32_t> const& indices = mPartitioner.getIndices();
+        mPool->run(parts, [&](std::size_t part, unsigned thread)
+        {
+            auto start = Clock::now();
+            FlockAnalytics* analytics =
+                analyse ? &mThreadAnalytics[thread] : nullptr;
+            std::size_t end = (part + 1 < parts) ?
+                mPartitioner.getPartBegin(part + 1) : indices.size();
+            for (std::size_t k = mPartitioner.getPartBegin(part); k < end; k++)
+            {
+                computeForces(indices[k], analytics);
+            }
+            mThreadMilliseconds[thread] += std::chrono::duration<double,
+                std::milli>(Clock::now() - start).count();
+        });
+
+        double total = 0.0;
+        double largest = 0.0;
+        for (std::size_t thread = 0; thread < threads; thread++)
+        {
+            if (analyse)
+            {
+                mAnalytics.merge(mThreadAnalytics[thread]);
+            }
+            total += mThreadMilliseconds[thread];
+            largest = std::max(largest, mThreadMilliseconds[thread]);
+        }
+
+        double mean = total / threads;
+        mLoadBalance.threads = threads;
+        mLoadBalance.parts = parts;
+        mLoadBalance.predictedImbalance =
+            mPartitioner.getPredictedImbalance();
+        mLoadBalance.measuredImbalance = (mean > 0.0) ?
+            static_cast<float>(largest / mean) : 1.0f;
+        mLoadBalance.maxThreadMilliseconds = static_cast<float>(largest);
+        mLoadBalance.meanThreadMilliseconds = static_cast<float>(mean);
+    }
+
+    atlas::math::Vector FlockSimulation::computeNeighbourForces(
+        std::size_t index, FlockAnalytics* analytics)
+    {
+        // Separation, alignment, cohesion, fleeing and avoidance all gather
+        // over the same neighbours, so they share one neighbour list.
+        NeighbourSums sums;
+        gatherNear(index, sums, analytics);
+        if (mParams.farField)
+        {
+            gatherFar(index, sums);
+        }
+        return combineForces(mBoids[index], sums);
+    }
+
+    bool FlockSimulation::considerNeighbour(Boid const& self, Boid const& other,
+        atlas::math::Vector const& offset, float distance,
+        NeighbourSums& sums) const
+    {
+        // Equivalent to angle(forward, offset) <= viewAngle without the acos;
+        // a NaN forward still fails the test.
+        if (distance > mParams.viewRadius ||
+            !(dot(self.mForward, offset) >=
+                mCosViewAngle * mag(self.mForward) * distance))
+        {
+            return false;
+        }
+
+        if (distance <= mParams.viewRadius * 0.5f)
+        {
+            float weight = 1.0 / distance*distance;
+            sums.separation += offset * weight;
+        }
+
+        float interaction = mParams.getInteraction(self.mSpecies,
+            other.mSpecies);
+        if (interaction > 0)
+        {
+            sums.alignment += other.mVelocity * interaction;
+            sums.position += other.mPosition * interaction;
+            sums.weight += interaction;
+        }
+        else if (interaction < 0)
+        {
+            sums.flee += offset * (-interaction / distance);
+        }
+        return true;
+    }
+
+    void FlockSimulation::considerAvoidance(Boid const& self, Boid const& other,
+        float distance, NeighbourSums& sums) const
+    {
+        atlas::math::Vector ahead = self.mPosition + self.mForward;
+        atlas::math::Vector halfAhead = self.mPosition + self.mForward * 0.5f;
+
+        float aheadDistance = mag(other.mPosition - ahead);
+        float halfDistance = mag(other.mPosition - halfAhead);
+        if (distance <= other.mRadius || aheadDistance <= other.mRadius ||
+            halfDistance <= other.mRadius)
+        {
+            sums.avoidance += normalize(ahead - other.mPosition);
+        }
+    }
+
+    void FlockSimulation::gatherNear(std::size_t index, NeighbourSums& sums,
+        FlockAnalytics* analytics)
+    {
+        Boid const& self = mBoids[index];
+        float queryRadius = getQueryRadius();
+        float exactRadius = mParams.farField ? mParams.nearRadius :
+            std::numeric_limits<float>::max();
+        float nearest = -1.0f;
+
+        mNeighbourList.forEachNeighbour(index, [&](std::uint32_t otherIndex)
+        {
+            Boid const& other = (*mNeighbours)[otherIndex];
+
+            atlas::math::Vector offset = self.mPosition - other.mPosition;
+            float distance = mag(offset);
+            if (distance <= 0)
+            {
+                return;
+            }
+
+            if (analytics != nullptr)
+            {
+                if (distance <= queryRadius &&
+                    (nearest < 0 || distance < nearest))
+                {
+                    nearest = distance;
+                }
+                if (otherIndex > index)
+                {
+                    analytics->addPair(static_cast<std::uint32_t>(index),
+                        otherIndex, distance, self.mRadius + other.mRadius);
+                }
+            }
+
+            considerAvoidance(self, other, distance, sums);
+
+            // Beyond the exact radius the far field takes over.
+            if (distance <= exactRadius)
+            {
+                considerNeighbour(self, other, offset, distance, sums);
+            }
+        });
+
+        if (analytics != nullptr)
+        {
+            analytics->addNearest(nearest);
+        }
+    }
+
+    void FlockSimulation::gatherFar(std::size_t index,
+        NeighbourSums& sums) const
+    {
+        Boid const& self = mBoids[index];
+        std::vector<std::uint32_t> const& members = mOctree.getIndices();
+        std::size_t species = static_cast<std::size_t>(mParams.numSpecies);
+
+        mOctree.traverse([&](std::uint32_t nodeIndex, OctreeNode const& node)
+        {
+            // Distance from the boid to the closest point of the node.
+            atlas::math::Vector outside = glm::max(
+                glm::abs(self.mPosition - node.center) -
+                atlas::math::Vector(node.halfSize), atlas::math::Vector(0.0f));
+            float closest = mag(outside);
+            if (node.begin == node.end || closest > mParams.viewRadius)
+            {
+                return false;
+            }
+
+            if (node.firstChild == 0)
+            {
+                for (std::uint32_t k = node.begin; k < node.end; ++k)
+                {
+                    std::uint32_t otherIndex = members[k];
+                    Boid const& other = (*mNeighbours)[otherIndex];
+                    atlas::math::Vector offset = self.mPosition -
+                        other.mPosition;
+                    float distance = mag(offset);
+                    if (otherIndex != index && distance > mParams.nearRadius)
+                    {
+                        considerNeighbour(self, other, offset, distance, sums);
+                    }
+                }
+                return false;
+            }
+
+            // The rule sums are linear in the neighbours, so a node that lies
+            // wholly inside the view, and wholly inside or outside the
+            // separation radius, contributes exactly its totals. A node that
+            // straddles the edge of the view is opened unless it subtends
+            // less than the opening angle, when it counts as wholly in or out
+            // by its centre of mass. Separation sums offsets that mostly
+            // cancel, so its edge is always resolved boid by boid.
+            atlas::math::Vector toNode = self.mPosition - node.center;
+            float farthest = mag(glm::abs(toNode) +
+                atlas::math::Vector(node.halfSize));
+            float centre = mag(toNode);
+            float bound = node.halfSize * 1.7320508f;
+            if (closest <= mParams.nearRadius || centre <= bound)
+            {
+                return true;
+            }
+
+            float facing = glm::clamp(dot(self.mForward, toNode) /
+                (mag(self.mForward) * centre), -1.0f, 1.0f);
+            float bearing = acos(facing);
+            float spread = asin(bound / centre);
+            if (bearing - spread > mParams.viewAngle)
+            {
+                return false;
+            }
+
+            float separationRadius = mParams.viewRadius * 0.5f;
+            bool separating = farthest <= separationRadius;
+            if (closest <= separationRadius && !separating)
+            {
+                return true;
+            }
+
+            FarFieldAggregate const* aggregates =
+                &mAggregates[nodeIndex * species];
+            bool distant = 2.0f * node.halfSize <
+                mParams.farFieldAngle * centre;
+            if (farthest > mParams.viewRadius ||
+                !(bearing + spread <= mParams.viewAngle))
+            {
+                if (!distant)
+                {
+                    return true;
+                }
+
+                float count = 0.0f;
+                atlas::math::Vector positionSum(0.0f);
+                for (std::size_t s = 0; s < species; ++s)
+                {
+                    count += aggregates[s].count;
+                    positionSum += aggregates[s].positionSum;
+                }
+
+                // A NaN forward fails here, as it does for single boids.
+                atlas::math::Vector offset = self.mPosition -
+                    positionSum / count;
+                float distance = mag(offset);
+                if (distance > mParams.viewRadius ||
+                    !(dot(self.mForward, offset) >=
+                        mCosViewAngle * mag(self.mForward) * distance))
+                {
+                    return false;
+                }
+            }
+            else if (!distant)
+            {
+                // Fleeing weighs neighbours by distance, so it needs the
+                // opening angle even inside the view.
+                for (std::size_t s = 0; s < species; ++s)
+                {
+                    if (aggregates[s].count > 0.0f && mParams.getInteraction(
+                        self.mSpecies, static_cast<int>(s)) < 0)
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            // With separation weighted 1 per neighbour, the offsets of a node
+            // sum to its count times the offset to its centre of mass.
+            if (separating)
+            {
+                for (std::size_t s = 0; s < species; ++s)
+                {
+                    sums.separation += self.mPosition * aggregates[s].count -
+                        aggregates[s].positionSum;
+                }
+            }
+
+            for (std::size_t s = 0; s < species; ++s)
+            {
+                FarFieldAggregate const& aggregate = aggregates[s];
+                float interaction = mParams.getInteraction(self.mSpecies,
+                    static_cast<int>(s));
+                if (aggregate.count == 0.0f)
+                {
+                    continue;
+                }
+                if (interaction > 0)
+                {
+                    sums.alignment += aggregate.velocitySum * interaction;
+                    sums.position += aggregate.positionSum * interaction;
+                    sums.weight += aggregate.count * interaction;
+                }
+                else if (interaction < 0)
+                {
+                    atlas::math::Vector away = self.mPosition -
+                        aggregate.positionSum / aggregate.count;
+                    float awayDistance = mag(away);
+                    if (awayDistance > 0)
+                    {
+                        sums.flee += away *
+                            (-interaction * aggregate.count / awayDistance);
+                    }
+                }
+            }
+            return false;
+        });
+    }
+
+    void FlockSimulation::gatherExact(std::size_t index,
+        NeighbourSums& sums) const
+    {
+        Boid const& self = mBoids[index];
+        for (std::size_t i = 0; i < mNeighbours->size(); i++)
+        {
+            Boid const& other = (*mNeighbours)[i];
+            atlas::math::Vector offset = self.mPosition - other.mPosition;
+            float distance = mag(offset);
+            if (distance > 0)
+            {
+                considerAvoidance(self, other, distance, sums);
+                considerNeighbour(self, other, offset, distance, sums);
+            }
+        }
+    }
+
+    atlas::math::Vector FlockSimulation::combineForces(Boid const& self,
+        NeighbourSums const& sums) const
+    {
+        atlas::math::Vector alignment = {0,0,0};
+        atlas::math::Vector cohesion = {0,0,0};
+        if (sums.weight > 0)
+        {
+            alignment = sums.alignment / sums.weight - self.mVelocity;
+            cohesion = sums.position / sums.weight - self.mPosition;
+        }
+
+        return sums.separation*mParams.separationWeight +
+            alignment*mParams.alignmentWeight +
+            cohesion*mParams.cohesionWeight +
+            sums.flee*mParams.fleeWeight +
+            sums.avoidance*mParams.avoidanceWeight;
+    }
+
+    void FlockSimulation::buildFarField()
+    {
+        mPositions.resize(mNeighbours->size());
+        for (std::size_t i = 0; i < mNeighbours->size(); i++)
+        {
+            mPositions[i] = (*mNeighbours)[i].mPosition;
+        }
+        mOctree.build(mPositions, FarFieldLeafSize);
+
+        // Children always follow their parents, so walking backwards fills
+        // every node after all of its children.
+        std::vector<OctreeNode> const& nodes = mOctree.getNodes();
+        std::vector<std::uint32_t> const& members = mOctree.getIndices();
+        std::size_t species = static_cast<std::size_t>(mParams.numSpecies);
+        mAggregates.assign(nodes.size() * species,
+            FarFieldAggregate{ 0.0f, atlas::math::Vector(0.0f),
+                atlas::math::Vector(0.0f) });
+
+        for (std::size_t n = nodes.size(); n-- > 0;)
+        {
+            FarFieldAggregate* aggregates = &mAggregates[n * species];
+            if (nodes[n].firstChild == 0)
+            {
+                for (std::uint32_t k = nodes[n].begin; k < nodes[n].end; ++k)
+                {
+                    Boid const& boid = (*mNeighbours)[members[k]];
+                    FarFieldAggregate& aggregate = aggregates[boid.mSpecies];
+                    aggregate.count += 1.0f;
+                    aggregate.positionSum += boid.mPosition;
+                    aggregate.velocitySum += boid.mVelocity;
+                }
+                continue;
+            }
+
+            for (std::uint32_t c = 0; c < 8; ++c)
+            {
+                FarFieldAggregate const* child =
+                    &mAggregates[(nodes[n].firstChild + c) * species];
+                for (std::size_t s = 0; s < species; ++s)
+                {
+                    aggregates[s].count += child[s].count;
+                    aggregates[s].positionSum += child[s].positionSum;
+                    aggregates[s].velocitySum += child[s].velocitySum;
+                }
+            }
+        }
+    }
+
+    FarFieldError FlockSimulation::measureFarFieldError(std::size_t sampleCount)
+    {
+        FarFieldError error{ 0.0f, 0.0f, 0 };
+        if (mBoids.empty() || sampleCount == 0)
+        {
+            return error;
+        }
+
+        prepareNeighbours();
+
+        // Individual forces can nearly cancel, so errors are taken relative
+        // to the mean force over the samples rather than boid by boid.
+        double total = 0.0;
+        double reference = 0.0;
+        float largest = 0.0f;
+        std::size_t stride = std::max<std::size_t>(mBoids.size() / sampleCount,
+            1);
+        for (std::size_t i = 0; i < mBoids.size(); i += stride)
+        {
+            NeighbourSums approximate;
+            gatherNear(i, approximate, nullptr);
+            if (mParams.farField)
+            {
+                gatherFar(i, approximate);
+            }
+
+            NeighbourSums exact;
+            gatherExact(i, exact);
+
+            atlas::math::Vector exactForce = combineForces(mBoids[i], exact);
+            float difference = mag(combineForces(mBoids[i], approximate) -
+                exactForce);
+            total += difference;
+            reference += mag(exactForce);
+            largest = std::max(largest, difference);
+            error.samples++;
+        }
+
+        if (reference > 0.0)
+        {
+            double mean = reference / error.samples;
+            error.meanRelative = static_cast<float>(total / reference);
+            error.maxRelative = static_cast<float>(largest / mean);
+        }
+        return error;
+    }
+
+    float FlockSimulation::getQueryRadius() const
+    {
+        // Avoidance looks one unit ahead for boids within their radius of
+        // that point, which can reach past the view radius. In far-field mode
+        // only the near neighbours are listed.
+        float reach = 1.0f + mParams.boidRadius;
+        float rules = mParams.viewRadius;
+        if (mParams.farField && mParams.nearRadius < rules)
+        {
+            rules = mParams.nearRadius;
+        }
+        return (rules > reach) ? rules : reach;
+    }
+
+    atlas::math::Vector FlockSimulation::computeObstacleAvoidance(Boid &self)
+    {
+        if (mObstacles == nullptr)
+        {
+            return {0,0,0};
+        }
+
+        // Steer by whichever is closer to an obstacle: where the boid is, or
+        // where it will be if it keeps its heading.
+        float const far = std::numeric_limits<float>::max();
+        atlas::math::Vector gradient;
+        float distance = mObstacles->sample(self.mPosition, gradient, far);
+
+        atlas::math::Vector aheadGradient;
+        atlas::math::Vector ahead = self.mPosition +
+            self.mForward * mParams.obstacleMargin;
+        float aheadDistance = mObstacles->sample(ahead, aheadGradient, far);
+        if (aheadDistance < distance)
+        {
+            distance = aheadDistance;
+            gradient = aheadGradient;
+        }
+
+        distance -= self.mRadius;
+        float length = mag(gradient);
+        if (distance >= mParams.obstacleMargin || length == 0.0f)
+        {
+            return {0,0,0};
+        }
+
+        // Grows past 1 once the boid is actually inside the obstacle.
+        float strength = (mParams.obstacleMargin - distance) /
+            mParams.obstacleMargin;
+        return gradient * (strength / length);
+    }
+
+    void FlockSimulation::setObstacles(SignedDistanceField const* obstacles)
+    {
+        mObstacles = obstacles;
+
+        // Anything simulated past this point assumed the old obstacles.
+        mCheckpoints.discardAfter(mFrame);
+    }
+
+    void FlockSimulation::setSpecies(int count)
+    {
+        mParams.setSpecies(count);
+        for (std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            mBoids[i].mSpecies = static_cast<int>(mBoids[i].mId %
+                static_cast<std::uint32_t>(mParams.numSpecies));
+        }
+
+        // Checkpoints only hold positions and velocities, so any taken ahead
+        // of now were simulated with the old species.
+        mCheckpoints.discardAfter(mFrame);
+    }
+
+    void FlockSimulation::setFarField(bool enabled)
+    {
+        mParams.farField = enabled;
+
+        // The far field approximates the forces, so frames simulated ahead
+        // of now would no longer be reproduced.
+        mCheckpoints.discardAfter(mFrame);
+    }
+
+    void FlockSimulation::setContinuousCollision(bool enabled)
+    {
+        mParams.continuousCollision = enabled;
+        mCheckpoints.discardAfter(mFrame);
+    }
+
+    void FlockSimulation::setThreadCount(int count)
+    {
+        // Only changes how the work is spread, not the result.
+        mParams.threadCount = count;
+    }
+
+    void FlockSimulation::setIntegrator(IntegratorType type)
+    {
+        if (type != mParams.integrator)
+        {
+            mParams.integrator = type;
+            mCheckpoints.discardAfter(mFrame);
+        }
+    }
+
+    void FlockSimulation::setTimeStep(float seconds)
+    {
+        if (seconds > 0.0f && seconds != mParams.timeStep)
+        {
+            mParams.timeStep = seconds;
+            mCheckpoints.discardAfter(mFrame);
+        }
+    }
+
+    void FlockSimulation::setAutoTune(bool enabled)
+    {
+        mParams.autoTune = enabled;
+        mTuner = StepTuner();
+    }
+
+    void FlockSimulation::setBoids(std::vector<Boid> const& boids)
+    {
+        mBoids = boids;
+        updateSlots();
+        mNeighbourList.invalidate();
+        mCheckpoints.clear();
+        mCheckpoints.capture(mFrame, mBoids);
+    }
+
+    void FlockSimulation::setGhosts(std::vector<Boid> const& ghosts)
+    {
+        mGhosts = ghosts;
+        mNeighbourList.invalidate();
+    }
+
+    void FlockSimulation::reset()
+    {
+        scatterBoids();
+        mNeighbourList.invalidate();
+
+        mFrame = 0;
+        mCheckpoints.clear();
+        mCheckpoints.capture(mFrame, mBoids);
+    }
+
+    void FlockSimulation::scatterBoids()
+    {
+        for (std::size_t i = 0; i < mBoids.size(); i++)
+        {
+            atlas::math::Vector rp = normalize(random2DVector(1.0f));
+
+            float rr = randomFloat(mParams.flockRadius);
+            rp.x *= rr;
+            rp.z *= rr;
+
+            atlas::math::Vector rv = random2DVector(1.0f);
+
+            mBoids[i] = Boid(rp, rv * 0.001f, mParams.boidRadius,
+                static_cast<int>(i) % mParams.numSpecies,
+                static_cast<std::uint32_t>(i));
+        }
+        updateSlots();
+    }
+
+    float FlockSimulation::randomFloat(float max)
+    {
+        // A per-simulation engine keeps runs reproducible from their seed and
+        // lets independent simulations scatter boids on different threads.
+        return std::uniform_real_distribution<float>(0.0f, max)(mRandom);
+    }
+
+    atlas::math::Vector FlockSimulation::random2DVector(float max)
+    {
+        float rx = randomFloat(max);
+        float rz = randomFloat(max);
+        atlas::math::Vector rv = {2*rx-1,0,2*rz-1};
+        return rv;
+    }
+
+    atlas::math::Vector FlockSimulation::random3DVector(float max)
+    {
+        float rx = randomFloat(max);
+        float ry = randomFloat(max);
+        float rz = randomFloat(max);
+        atlas::math::Vector rv = {2*rx-1,2*ry-1,2*rz-1};
+        return rv;
+    }
+
+    float FlockSimulation::dot(atlas::math::Vector v1,
+        atlas::math::Vector v2) const
+    {
+        return v1.x*v2.x + v1.y*v2.y + v1.z*v2.z;
+    }
+
+    float FlockSimulation::mag(atlas::math::Vector v) const
+    {
+        return sqrt(v.x*v.x + v.y*v.y + v.z*v.z);
+    }
+
+
+}
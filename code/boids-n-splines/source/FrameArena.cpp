@@ -0,0 +1,133 @@
+#include "FrameArena.hpp"
+
+#include <atlas/core/Macros.hpp>
+
+#include <algorithm>
+
+namespace bns
+{
+    namespace
+    {
+        constexpr std::size_t BlockAlignment = alignof(std::max_align_t);
+    }
+
+    std::size_t FrameArena::alignOffset(Block const& block, std::size_t offset,
+        std::size_t alignment)
+    {
+        std::uintptr_t address =
+            reinterpret_cast<std::uintptr_t>(block.data) + offset;
+        std::uintptr_t aligned = (address + alignment - 1) &
+            ~static_cast<std::uintptr_t>(alignment - 1);
+        return offset + static_cast<std::size_t>(aligned - address);
+    }
+
+    FrameArena::FrameArena(std::size_t initialCapacity,
+        std::pmr::memory_resource* upstream) :
+        mUpstream(upstream),
+        mOffset(0),
+        mUsed(0),
+        mPeak(0),
+        mUpstreamAllocations(0)
+    {
+        // Room for the overflow blocks of a few bad frames, so tracking them
+        // does not allocate either.
+        mBlocks.reserve(16);
+        addBlock(std::max<std::size_t>(initialCapacity, BlockAlignment));
+    }
+
+    FrameArena::~FrameArena()
+    {
+        releaseBlocks();
+    }
+
+    void FrameArena::reset()
+    {
+        mPeak = std::max(mPeak, mUsed);
+
+        if (mBlocks.size() > 1)
+        {
+            std::size_t capacity = getCapacity();
+            releaseBlocks();
+            addBlock(capacity);
+        }
+
+        mOffset = 0;
+        mUsed = 0;
+    }
+
+    std::size_t FrameArena::getUsedBytes() const
+    {
+        return mUsed;
+    }
+
+    std::size_t FrameArena::getPeakBytes() const
+    {
+        return std::max(mPeak, mUsed);
+    }
+
+    std::size_t FrameArena::getCapacity() const
+    {
+        std::size_t capacity = 0;
+        for (Block const& block : mBlocks)
+        {
+            capacity += block.size;
+        }
+        return capacity;
+    }
+
+    std::uint64_t FrameArena::getUpstreamAllocations() const
+    {
+        return mUpstreamAllocations;
+    }
+
+    void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        Block const* block = &mBlocks.back();
+        std::size_t start = alignOffset(*block, mOffset, alignment);
+        if (start + bytes > block->size)
+        {
+            addBlock(std::max(block->size * 2, bytes + alignment));
+            block = &mBlocks.back();
+            start = alignOffset(*block, 0, alignment);
+        }
+
+        mUsed += bytes + (start - mOffset);
+        mOffset = start + bytes;
+        return block->data + start;
+    }
+
+    void FrameArena::do_deallocate(void* pointer, std::size_t bytes,
+        std::size_t alignment)
+    {
+        // Everything is released together by reset().
+        UNUSED(pointer);
+        UNUSED(bytes);
+        UNUSED(alignment);
+    }
+
+    bool FrameArena::do_is_equal(std::pmr::memory_resource const& other) const
+        noexcept
+    {
+        return this == &other;
+    }
+
+    void FrameArena::addBlock(std::size_t size)
+    {
+        Block block;
+        block.data = static_cast<std::byte*>(
+            mUpstream->allocate(size, BlockAlignment));
+        block.size = size;
+        mBlocks.push_back(block);
+        mOffset = 0;
+        mUpstreamAllocations++;
+    }
+
+    void FrameArena::releaseBlocks()
+    {
+        for (Block const& block : mBlocks)
+        {
+            mUpstream->deallocate(block.data, block.size, BlockAlignment);
+        }
+        mBlocks.clear();
+    }
+}
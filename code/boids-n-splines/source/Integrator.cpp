@@ -0,0 +1,174 @@
+#include "Integrator.hpp"
+
+namespace bns
+{
+    namespace
+    {
+        void setStage(Boid& boid, atlas::math::Point const& position,
+            atlas::math::Vector const& velocity)
+        {
+            boid.mPosition = position;
+            boid.mVelocity = velocity;
+            boid.mForward = normalize(velocity);
+        }
+
+        void saveState(std::vector<Boid> const& boids,
+            std::vector<atlas::math::Point>& positions,
+            std::vector<atlas::math::Vector>& velocities)
+        {
+            positions.resize(boids.size());
+            velocities.resize(boids.size());
+            for (std::size_t i = 0; i < boids.size(); ++i)
+            {
+                positions[i] = boids[i].mPosition;
+                velocities[i] = boids[i].mVelocity;
+            }
+        }
+    }
+
+    std::unique_ptr<Integrator> makeIntegrator(IntegratorType type)
+    {
+        switch (type)
+        {
+        case IntegratorType::VelocityVerlet:
+            return std::unique_ptr<Integrator>(new VelocityVerlet());
+        case IntegratorType::RungeKutta4:
+            return std::unique_ptr<Integrator>(new RungeKutta4());
+        case IntegratorType::SemiImplicitEuler:
+            break;
+        }
+        return std::unique_ptr<Integrator>(new SemiImplicitEuler());
+    }
+
+    char const* getIntegratorName(IntegratorType type)
+    {
+        switch (type)
+        {
+        case IntegratorType::VelocityVerlet:
+            return "Velocity Verlet";
+        case IntegratorType::RungeKutta4:
+            return "RK4";
+        case IntegratorType::SemiImplicitEuler:
+            break;
+        }
+        return "Semi-implicit Euler";
+    }
+
+    atlas::math::Vector clampLength(atlas::math::Vector const& v,
+        float maxLength)
+    {
+        if (maxLength > 0.0f)
+        {
+            float length = glm::length(v);
+            if (length > maxLength)
+            {
+                return v * (maxLength / length);
+            }
+        }
+        return v;
+    }
+
+    void SemiImplicitEuler::step(std::vector<Boid>& boids, float ticks,
+        float maxSpeed, Evaluate const& evaluate,
+        std::vector<atlas::math::Vector>& displacements)
+    {
+        mAccelerations.resize(boids.size());
+        evaluate(mAccelerations);
+
+        displacements.resize(boids.size());
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            boids[i].mVelocity = clampLength(
+                boids[i].mVelocity + mAccelerations[i] * ticks, maxSpeed);
+            displacements[i] = boids[i].mVelocity * ticks;
+        }
+    }
+
+    int SemiImplicitEuler::getStageCount() const
+    {
+        return 1;
+    }
+
+    void VelocityVerlet::step(std::vector<Boid>& boids, float ticks,
+        float maxSpeed, Evaluate const& evaluate,
+        std::vector<atlas::math::Vector>& displacements)
+    {
+        saveState(boids, mPositions, mVelocities);
+        mStart.resize(boids.size());
+        mEnd.resize(boids.size());
+        displacements.resize(boids.size());
+
+        evaluate(mStart);
+        float half = 0.5f * ticks;
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            displacements[i] = (mVelocities[i] + mStart[i] * half) * ticks;
+            setStage(boids[i], mPositions[i] + displacements[i], clampLength(
+                mVelocities[i] + mStart[i] * ticks, maxSpeed));
+        }
+
+        evaluate(mEnd);
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            boids[i].mPosition = mPositions[i];
+            boids[i].mVelocity = clampLength(
+                mVelocities[i] + (mStart[i] + mEnd[i]) * half, maxSpeed);
+        }
+    }
+
+    int VelocityVerlet::getStageCount() const
+    {
+        return 2;
+    }
+
+    void RungeKutta4::step(std::vector<Boid>& boids, float ticks,
+        float maxSpeed, Evaluate const& evaluate,
+        std::vector<atlas::math::Vector>& displacements)
+    {
+        saveState(boids, mPositions, mVelocities);
+        mAccelerations.resize(boids.size());
+        mVelocitySum.assign(mVelocities.begin(), mVelocities.end());
+        mAccelerationSum.resize(boids.size());
+
+        evaluate(mAccelerations);
+        mAccelerationSum.assign(mAccelerations.begin(), mAccelerations.end());
+
+        // Stages two and three sit at mid-step and count double; stage four
+        // sits at the end. Each moves by the velocity of the stage before.
+        float const offsets[] = { 0.5f * ticks, 0.5f * ticks, ticks };
+        float const weights[] = { 2.0f, 2.0f, 1.0f };
+        for (int stage = 0; stage < 3; ++stage)
+        {
+            float offset = offsets[stage];
+            for (std::size_t i = 0; i < boids.size(); ++i)
+            {
+                atlas::math::Vector velocity = clampLength(
+                    mVelocities[i] + mAccelerations[i] * offset, maxSpeed);
+                setStage(boids[i],
+                    mPositions[i] + boids[i].mVelocity * offset, velocity);
+                mVelocitySum[i] += velocity * weights[stage];
+            }
+
+            evaluate(mAccelerations);
+            for (std::size_t i = 0; i < boids.size(); ++i)
+            {
+                mAccelerationSum[i] += mAccelerations[i] * weights[stage];
+            }
+        }
+
+        float sixth = ticks / 6.0f;
+        displacements.resize(boids.size());
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            displacements[i] = mVelocitySum[i] * sixth;
+            boids[i].mPosition = mPositions[i];
+            boids[i].mVelocity = clampLength(
+                mVelocities[i] + mAccelerationSum[i] * sixth, maxSpeed);
+        }
+    }
+
+    int RungeKutta4::getStageCount() const
+    {
+        return 4;
+    }
+}
@@ -0,0 +1,195 @@
+#include "MipChain.hpp"
+
+#include <atlas/core/STB.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace bns
+{
+    namespace
+    {
+        constexpr int Channels = 4;
+
+        // FNV-1a, enough to tell cache files apart.
+        std::uint64_t hashBytes(void const* data, std::size_t size,
+            std::uint64_t hash = 1469598103934665603ull)
+        {
+            auto bytes = static_cast<std::uint8_t const*>(data);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+            return hash;
+        }
+    }
+
+    bool decodeMipChain(std::string const& path, MipChain& chain)
+    {
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height,
+            &channels, Channels);
+        if (data == nullptr)
+        {
+            return false;
+        }
+
+        std::size_t bytes = static_cast<std::size_t>(width) * height *
+            Channels;
+        chain.levels.assign(1, MipChain::Level{ width, height, 0 });
+        chain.pixels.assign(data, data + bytes);
+        stbi_image_free(data);
+
+        buildMipLevels(chain);
+        return true;
+    }
+
+    void buildMipLevels(MipChain& chain)
+    {
+        chain.levels.resize(1);
+        MipChain::Level level = chain.levels[0];
+        std::size_t total = level.offset + static_cast<std::size_t>(
+            level.width) * level.height * Channels;
+        while (level.width > 1 || level.height > 1)
+        {
+            MipChain::Level next{ std::max(level.width / 2, 1),
+                std::max(level.height / 2, 1), total };
+            total += static_cast<std::size_t>(next.width) * next.height *
+                Channels;
+            chain.levels.push_back(next);
+            level = next;
+        }
+        chain.pixels.resize(total);
+
+        // Each texel of a level averages the 2x2 block above it. An odd last
+        // row or column is left out, and a side that is already one texel
+        // wide is sampled twice.
+        for (std::size_t l = 1; l < chain.levels.size(); ++l)
+        {
+            MipChain::Level const& src = chain.levels[l - 1];
+            MipChain::Level const& dst = chain.levels[l];
+            std::uint8_t const* in = chain.pixels.data() + src.offset;
+            std::uint8_t* out = chain.pixels.data() + dst.offset;
+            for (int y = 0; y < dst.height; ++y)
+            {
+                int y0 = std::min(2 * y, src.height - 1);
+                int y1 = std::min(2 * y + 1, src.height - 1);
+                for (int x = 0; x < dst.width; ++x)
+                {
+                    int x0 = std::min(2 * x, src.width - 1);
+                    int x1 = std::min(2 * x + 1, src.width - 1);
+                    for (int c = 0; c < Channels; ++c)
+                    {
+                        int sum = in[(y0 * src.width + x0) * Channels + c] +
+                            in[(y0 * src.width + x1) * Channels + c] +
+                            in[(y1 * src.width + x0) * Channels + c] +
+                            in[(y1 * src.width + x1) * Channels + c];
+                        out[(y * dst.width + x) * Channels + c] =
+                            static_cast<std::uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+    }
+
+    std::string getMipCachePath(std::string const& directory,
+        std::string const& path)
+    {
+        namespace fs = std::filesystem;
+
+        std::error_code error;
+        std::uint64_t size = fs::file_size(path, error);
+        if (error)
+        {
+            size = 0;
+        }
+        auto modified = fs::last_write_time(path, error);
+        std::int64_t ticks = error ? 0 :
+            static_cast<std::int64_t>(modified.time_since_epoch().count());
+
+        std::uint64_t hash = hashBytes(path.data(), path.size());
+        hash = hashBytes(&size, sizeof(size), hash);
+        hash = hashBytes(&ticks, sizeof(ticks), hash);
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bnsmip",
+            static_cast<unsigned long long>(hash));
+        return (fs::path(directory) / name).string();
+    }
+
+    bool readMipCache(std::string const& cachePath, MipChain& chain)
+    {
+        std::ifstream file(cachePath, std::ios::binary);
+        MipCacheHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, MipCacheMagic, sizeof(header.magic)) !=
+                0 || header.version != MipCacheVersion ||
+            header.levelCount == 0 || header.levelCount > 32)
+        {
+            return false;
+        }
+
+        chain.levels.clear();
+        std::size_t offset = 0;
+        for (std::uint32_t l = 0; l < header.levelCount; ++l)
+        {
+            std::int32_t size[2];
+            if (!file.read(reinterpret_cast<char*>(size), sizeof(size)) ||
+                size[0] < 1 || size[1] < 1)
+            {
+                return false;
+            }
+            chain.levels.push_back({ size[0], size[1], offset });
+            offset += static_cast<std::size_t>(size[0]) * size[1] * Channels;
+        }
+        if (offset != header.pixelBytes)
+        {
+            return false;
+        }
+
+        chain.pixels.resize(offset);
+        return static_cast<bool>(file.read(
+            reinterpret_cast<char*>(chain.pixels.data()),
+            static_cast<std::streamsize>(offset)));
+    }
+
+    bool writeMipCache(std::string const& cachePath, MipChain const& chain)
+    {
+        namespace fs = std::filesystem;
+
+        std::error_code error;
+        fs::create_directories(fs::path(cachePath).parent_path(), error);
+
+        std::string partial = cachePath + ".part";
+        {
+            std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+            MipCacheHeader header;
+            std::memcpy(header.magic, MipCacheMagic, sizeof(header.magic));
+            header.version = MipCacheVersion;
+            header.levelCount = static_cast<std::uint32_t>(
+                chain.levels.size());
+            header.pixelBytes = chain.pixels.size();
+            file.write(reinterpret_cast<char const*>(&header),
+                sizeof(header));
+            for (MipChain::Level const& level : chain.levels)
+            {
+                std::int32_t size[2] = { level.width, level.height };
+                file.write(reinterpret_cast<char const*>(size), sizeof(size));
+            }
+            file.write(reinterpret_cast<char const*>(chain.pixels.data()),
+                static_cast<std::streamsize>(chain.pixels.size()));
+            if (!file)
+            {
+                return false;
+            }
+        }
+
+        fs::rename(partial, cachePath, error);
+        return !error;
+    }
+}
@@ -0,0 +1,93 @@
+#include "NeighbourList.hpp"
+
+#include <algorithm>
+
+namespace bns
+{
+    NeighbourList::NeighbourList() :
+        mRadius(0.0f),
+        mSkin(0.0f),
+        mValid(false),
+        mBuildCount(0)
+    { }
+
+    bool NeighbourList::isStale(std::vector<Boid> const& boids, float radius,
+        float skin) const
+    {
+        if (!mValid || boids.size() != mBuiltPositions.size() ||
+            radius != mRadius || skin != mSkin)
+        {
+            return true;
+        }
+
+        // A pair can have closed by at most the sum of the two largest
+        // displacements, which is never more pessimistic than twice the
+        // largest one.
+        float largest = 0.0f;
+        float second = 0.0f;
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            float moved = glm::length(boids[i].mPosition - mBuiltPositions[i]);
+            if (moved > largest)
+            {
+                second = largest;
+                largest = moved;
+            }
+            else if (moved > second)
+            {
+                second = moved;
+            }
+        }
+        return largest + second > skin;
+    }
+
+    void NeighbourList::build(std::vector<Boid> const& boids, std::size_t count,
+        SpatialGrid& grid, float radius, float skin)
+    {
+        float reach = radius + skin;
+        float reachSquared = reach * reach;
+        grid.build(boids, reach);
+
+        mOffsets.resize(count + 1);
+        mIndices.clear();
+        mBuiltPositions.resize(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            atlas::math::Point const& position = boids[i].mPosition;
+            mOffsets[i] = static_cast<std::uint32_t>(mIndices.size());
+            mBuiltPositions[i] = position;
+
+            grid.forEachNear(position, [&](std::uint32_t other)
+            {
+                atlas::math::Vector offset = boids[other].mPosition - position;
+                if (other != i && glm::dot(offset, offset) <= reachSquared)
+                {
+                    mIndices.push_back(other);
+                }
+            });
+            std::sort(mIndices.begin() + mOffsets[i], mIndices.end());
+        }
+        mOffsets[count] = static_cast<std::uint32_t>(mIndices.size());
+
+        mRadius = radius;
+        mSkin = skin;
+        mValid = true;
+        mBuildCount++;
+    }
+
+    void NeighbourList::invalidate()
+    {
+        mValid = false;
+    }
+
+    std::size_t NeighbourList::getPairCount() const
+    {
+        return mIndices.size();
+    }
+
+    std::uint64_t NeighbourList::getBuildCount() const
+    {
+        return mBuildCount;
+    }
+}
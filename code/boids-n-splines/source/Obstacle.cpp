@@ -0,0 +1,141 @@
+#include "Obstacle.hpp"
+#include "Paths.hpp"
+#include "LayoutLocations.glsl"
+
+#include <atlas/utils/Mesh.hpp>
+
+namespace bns
+{
+    namespace
+    {
+        constexpr float FieldCellSize = 0.2f;
+        constexpr float FieldPadding = 1.5f;
+    }
+
+    Obstacle::Obstacle(std::string const& meshFile,
+        atlas::math::Matrix4 const& model) :
+        mVertexBuffer(GL_ARRAY_BUFFER),
+        mIndexBuffer(GL_ELEMENT_ARRAY_BUFFER)
+    {
+        using atlas::utils::Mesh;
+        namespace gl = atlas::gl;
+        namespace math = atlas::math;
+
+        mModel = model;
+
+        Mesh mesh;
+        std::string path{ DataDirectory };
+        path = path + meshFile;
+        Mesh::fromFile(path, mesh);
+
+        mIndexCount = static_cast<GLsizei>(mesh.indices().size());
+
+        std::vector<float> data;
+        std::vector<math::Point> worldVertices;
+        for (std::size_t i = 0; i < mesh.vertices().size(); ++i)
+        {
+            data.push_back(mesh.vertices()[i].x);
+            data.push_back(mesh.vertices()[i].y);
+            data.push_back(mesh.vertices()[i].z);
+
+            data.push_back(mesh.normals()[i].x);
+            data.push_back(mesh.normals()[i].y);
+            data.push_back(mesh.normals()[i].z);
+
+            data.push_back(mesh.texCoords()[i].x);
+            data.push_back(mesh.texCoords()[i].y);
+
+            math::Vector4 world = mModel * math::Vector4(mesh.vertices()[i], 1.0f);
+            worldVertices.push_back(math::Point(world.x, world.y, world.z));
+        }
+
+        std::vector<std::uint32_t> indices(mesh.indices().begin(),
+            mesh.indices().end());
+        mField.bake(worldVertices, indices, FieldCellSize, FieldPadding);
+
+        mVao.bindVertexArray();
+        mVertexBuffer.bindBuffer();
+        mVertexBuffer.bufferData(gl::size<float>(data.size()), data.data(),
+            GL_STATIC_DRAW);
+        mVertexBuffer.vertexAttribPointer(VERTICES_LAYOUT_LOCATION, 3, GL_FLOAT,
+            GL_FALSE, gl::stride<float>(8), gl::bufferOffset<float>(0));
+        mVertexBuffer.vertexAttribPointer(NORMALS_LAYOUT_LOCATION, 3, GL_FLOAT,
+            GL_FALSE, gl::stride<float>(8), gl::bufferOffset<float>(3));
+        mVertexBuffer.vertexAttribPointer(TEXTURES_LAYOUT_LOCATION, 2, GL_FLOAT,
+            GL_FALSE, gl::stride<float>(8), gl::bufferOffset<float>(6));
+
+        mVao.enableVertexAttribArray(VERTICES_LAYOUT_LOCATION);
+        mVao.enableVertexAttribArray(NORMALS_LAYOUT_LOCATION);
+        mVao.enableVertexAttribArray(TEXTURES_LAYOUT_LOCATION);
+
+        mIndexBuffer.bindBuffer();
+        mIndexBuffer.bufferData(gl::size<GLuint>(mesh.indices().size()),
+            mesh.indices().data(), GL_STATIC_DRAW);
+
+        mIndexBuffer.unBindBuffer();
+        mVertexBuffer.unBindBuffer();
+        mVao.unBindVertexArray();
+
+        std::vector<gl::ShaderUnit> shaders
+        {
+            {std::string(ShaderDirectory) + "Ball.vs.glsl", GL_VERTEX_SHADER},
+            {std::string(ShaderDirectory) + "Ball.fs.glsl", GL_FRAGMENT_SHADER}
+        };
+
+        mShaders.emplace_back(shaders);
+        mShaders[0].setShaderIncludeDir(ShaderDirectory);
+        mShaders[0].compileShaders();
+        mShaders[0].linkShaders();
+
+        auto var = mShaders[0].getUniformVariable("model");
+        mUniforms.insert(UniformKey("model", var));
+        var = mShaders[0].getUniformVariable("projection");
+        mUniforms.insert(UniformKey("projection", var));
+        var = mShaders[0].getUniformVariable("view");
+        mUniforms.insert(UniformKey("view", var));
+        var = mShaders[0].getUniformVariable("normalMatrix");
+        mUniforms.insert(UniformKey("normalMatrix", var));
+        var = mShaders[0].getUniformVariable("materialColour");
+        mUniforms.insert(UniformKey("materialColour", var));
+
+        mShaders[0].disableShaders();
+    }
+
+    void Obstacle::renderGeometry(atlas::math::Matrix4 const& projection,
+        atlas::math::Matrix4 const& view)
+    {
+        namespace math = atlas::math;
+
+        mShaders[0].hotReloadShaders();
+        if (!mShaders[0].shaderProgramValid())
+        {
+            return;
+        }
+
+        mShaders[0].enableShaders();
+
+        mVao.bindVertexArray();
+        mIndexBuffer.bindBuffer();
+
+        const math::Vector grey{ 0.4f, 0.4f, 0.45f };
+        glUniformMatrix4fv(mUniforms["projection"], 1, GL_FALSE,
+            &projection[0][0]);
+        glUniformMatrix4fv(mUniforms["view"], 1, GL_FALSE, &view[0][0]);
+        glUniformMatrix4fv(mUniforms["model"], 1, GL_FALSE, &mModel[0][0]);
+        math::Matrix3 normalMatrix =
+            glm::transpose(glm::inverse(math::Matrix3(view * mModel)));
+        glUniformMatrix3fv(mUniforms["normalMatrix"], 1, GL_FALSE,
+            &normalMatrix[0][0]);
+        glUniform3fv(mUniforms["materialColour"], 1, &grey[0]);
+        glDrawElements(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, 0);
+
+        mIndexBuffer.unBindBuffer();
+        mVao.unBindVertexArray();
+        mShaders[0].disableShaders();
+    }
+
+    SignedDistanceField const& Obstacle::getField() const
+    {
+        return mField;
+    }
+}
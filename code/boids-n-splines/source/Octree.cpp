@@ -0,0 +1,119 @@
+#include "Octree.hpp"
+
+#include <algorithm>
+
+namespace bns
+{
+    Octree::Octree()
+    { }
+
+    void Octree::build(std::vector<atlas::math::Point> const& points,
+        std::size_t leafSize)
+    {
+        mNodes.clear();
+        mIndices.resize(points.size());
+        mScratch.resize(points.size());
+        if (points.empty())
+        {
+            return;
+        }
+
+        atlas::math::Point lower = points[0];
+        atlas::math::Point upper = points[0];
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            lower = glm::min(lower, points[i]);
+            upper = glm::max(upper, points[i]);
+            mIndices[i] = static_cast<std::uint32_t>(i);
+        }
+
+        atlas::math::Vector extent = upper - lower;
+        float halfSize = 0.5f * std::max(extent.x, std::max(extent.y,
+            extent.z));
+
+        OctreeNode root;
+        root.center = 0.5f * (lower + upper);
+        root.halfSize = std::max(halfSize, 1e-6f);
+        root.firstChild = 0;
+        root.begin = 0;
+        root.end = static_cast<std::uint32_t>(points.size());
+        mNodes.push_back(root);
+
+        split(0, 0, points, std::max<std::size_t>(leafSize, 1));
+    }
+
+    std::vector<OctreeNode> const& Octree::getNodes() const
+    {
+        return mNodes;
+    }
+
+    std::vector<std::uint32_t> const& Octree::getIndices() const
+    {
+        return mIndices;
+    }
+
+    void Octree::split(std::uint32_t nodeIndex, int depth,
+        std::vector<atlas::math::Point> const& points, std::size_t leafSize)
+    {
+        OctreeNode node = mNodes[nodeIndex];
+        if (node.end - node.begin <= leafSize || depth >= MaxDepth)
+        {
+            return;
+        }
+
+        // Counting sort of the node's points into octants; bit 0 is x, bit 1
+        // is y and bit 2 is z.
+        std::uint32_t counts[8] = { 0 };
+        for (std::uint32_t k = node.begin; k < node.end; ++k)
+        {
+            atlas::math::Point const& p = points[mIndices[k]];
+            int octant = (p.x >= node.center.x ? 1 : 0) |
+                (p.y >= node.center.y ? 2 : 0) |
+                (p.z >= node.center.z ? 4 : 0);
+            counts[octant]++;
+        }
+
+        std::uint32_t starts[9];
+        starts[0] = node.begin;
+        for (int c = 0; c < 8; ++c)
+        {
+            starts[c + 1] = starts[c] + counts[c];
+        }
+
+        std::uint32_t cursor[8];
+        std::copy(starts, starts + 8, cursor);
+        for (std::uint32_t k = node.begin; k < node.end; ++k)
+        {
+            atlas::math::Point const& p = points[mIndices[k]];
+            int octant = (p.x >= node.center.x ? 1 : 0) |
+                (p.y >= node.center.y ? 2 : 0) |
+                (p.z >= node.center.z ? 4 : 0);
+            mScratch[cursor[octant]++] = mIndices[k];
+        }
+        std::copy(mScratch.begin() + node.begin, mScratch.begin() + node.end,
+            mIndices.begin() + node.begin);
+
+        std::uint32_t firstChild = static_cast<std::uint32_t>(mNodes.size());
+        mNodes[nodeIndex].firstChild = firstChild;
+
+        float quarter = 0.5f * node.halfSize;
+        for (int c = 0; c < 8; ++c)
+        {
+            OctreeNode child;
+            child.center = node.center + atlas::math::Vector(
+                (c & 1) ? quarter : -quarter,
+                (c & 2) ? quarter : -quarter,
+                (c & 4) ? quarter : -quarter);
+            child.halfSize = quarter;
+            child.firstChild = 0;
+            child.begin = starts[c];
+            child.end = starts[c + 1];
+            mNodes.push_back(child);
+        }
+
+        for (std::uint32_t c = 0; c < 8; ++c)
+        {
+            split(firstChild + c, depth + 1, points, leafSize);
+        }
+    }
+}
@@ -0,0 +1,322 @@
+#include "OrbitalSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+
+namespace bns
+{
+    namespace
+    {
+        // Bodies per task of the acceleration pass.
+        constexpr std::size_t BodiesPerTask = 1024;
+    }
+
+    OrbitalSystem::OrbitalSystem(OrbitalParameters const& params) :
+        mParams(params),
+        mAccelerationsValid(false)
+    { }
+
+    void OrbitalSystem::clear()
+    {
+        for (auto* component : { &mX, &mY, &mZ, &mVx, &mVy, &mVz, &mAx, &mAy,
+            &mAz, &mMass, &mRadius })
+        {
+            component->clear();
+        }
+        mAccelerationsValid = false;
+    }
+
+    void OrbitalSystem::addBody(atlas::math::Point const& position,
+        atlas::math::Vector const& velocity, float mass, float radius)
+    {
+        mX.push_back(position.x);
+        mY.push_back(position.y);
+        mZ.push_back(position.z);
+        mVx.push_back(velocity.x);
+        mVy.push_back(velocity.y);
+        mVz.push_back(velocity.z);
+        mAx.push_back(0.0f);
+        mAy.push_back(0.0f);
+        mAz.push_back(0.0f);
+        mMass.push_back(mass);
+        mRadius.push_back(radius);
+        mAccelerationsValid = false;
+    }
+
+    void OrbitalSystem::scatterDisc(std::size_t count, float innerRadius,
+        float outerRadius, float totalMass, std::uint32_t seed)
+    {
+        clear();
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        float mass = (count > 0) ? totalMass / count : 0.0f;
+        float thickness = 0.02f * outerRadius;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // Uniform over the ring's area, so density does not pile up at
+            // the inner edge.
+            float inner2 = innerRadius * innerRadius;
+            float r = std::sqrt(inner2 + unit(random) *
+                (outerRadius * outerRadius - inner2));
+            float theta = unit(random) * 6.2831853f;
+            float height = (unit(random) - 0.5f) * thickness;
+
+            // Circular speed about the central mass alone; with mutual
+            // gravity on, the disc settles from there.
+            float speed = std::sqrt(mParams.gravity * mParams.centralMass / r);
+            atlas::math::Point position(r * std::cos(theta), height,
+                r * std::sin(theta));
+            atlas::math::Vector velocity(-speed * std::sin(theta), 0.0f,
+                speed * std::cos(theta));
+            float radius = 0.05f + 0.1f * unit(random);
+            addBody(position, velocity, mass, radius);
+        }
+    }
+
+    void OrbitalSystem::step(float dt)
+    {
+        if (!mAccelerationsValid)
+        {
+            computeAccelerations();
+        }
+
+        std::size_t count = mX.size();
+        float half = 0.5f * dt;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            mVx[i] += mAx[i] * half;
+            mVy[i] += mAy[i] * half;
+            mVz[i] += mAz[i] * half;
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            mX[i] += mVx[i] * dt;
+            mY[i] += mVy[i] * dt;
+            mZ[i] += mVz[i] * dt;
+        }
+
+        computeAccelerations();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            mVx[i] += mAx[i] * half;
+            mVy[i] += mAy[i] * half;
+            mVz[i] += mAz[i] * half;
+        }
+    }
+
+    void OrbitalSystem::setMutualGravity(bool enabled)
+    {
+        mParams.mutualGravity = enabled;
+        mAccelerationsValid = false;
+    }
+
+    OrbitalParameters const& OrbitalSystem::getParameters() const
+    {
+        return mParams;
+    }
+
+    std::size_t OrbitalSystem::getBodyCount() const
+    {
+        return mX.size();
+    }
+
+    std::vector<float> const& OrbitalSystem::getX() const
+    {
+        return mX;
+    }
+
+    std::vector<float> const& OrbitalSystem::getY() const
+    {
+        return mY;
+    }
+
+    std::vector<float> const& OrbitalSystem::getZ() const
+    {
+        return mZ;
+    }
+
+    std::vector<float> const& OrbitalSystem::getRadii() const
+    {
+        return mRadius;
+    }
+
+    double OrbitalSystem::computeEnergy() const
+    {
+        double GM = static_cast<double>(mParams.gravity) *
+            mParams.centralMass;
+        double eps2 = static_cast<double>(mParams.softening) *
+            mParams.softening;
+        double energy = 0.0;
+        for (std::size_t i = 0; i < mX.size(); ++i)
+        {
+            double v2 = static_cast<double>(mVx[i]) * mVx[i] +
+                static_cast<double>(mVy[i]) * mVy[i] +
+                static_cast<double>(mVz[i]) * mVz[i];
+            double r2 = static_cast<double>(mX[i]) * mX[i] +
+                static_cast<double>(mY[i]) * mY[i] +
+                static_cast<double>(mZ[i]) * mZ[i];
+            energy += mMass[i] * (0.5 * v2 - GM / std::sqrt(r2 + eps2));
+
+            if (!mParams.mutualGravity)
+            {
+                continue;
+            }
+            for (std::size_t j = i + 1; j < mX.size(); ++j)
+            {
+                double dx = mX[j] - mX[i];
+                double dy = mY[j] - mY[i];
+                double dz = mZ[j] - mZ[i];
+                energy -= mParams.gravity * mMass[i] * mMass[j] /
+                    std::sqrt(dx * dx + dy * dy + dz * dz + eps2);
+            }
+        }
+        return energy;
+    }
+
+    void OrbitalSystem::computeAccelerations()
+    {
+        std::size_t count = mX.size();
+        if (mParams.mutualGravity)
+        {
+            buildTree();
+        }
+
+        float GM = mParams.gravity * mParams.centralMass;
+        float eps2 = mParams.softening * mParams.softening;
+        auto computeRange = [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                atlas::math::Point position(mX[i], mY[i], mZ[i]);
+                float r2 = glm::dot(position, position) + eps2;
+                atlas::math::Vector acceleration =
+                    position * (-GM / (r2 * std::sqrt(r2)));
+                if (mParams.mutualGravity)
+                {
+                    accumulateMutual(i, acceleration);
+                }
+                mAx[i] = acceleration.x;
+                mAy[i] = acceleration.y;
+                mAz[i] = acceleration.z;
+            }
+        };
+
+        unsigned threads = (mParams.threadCount > 0) ?
+            static_cast<unsigned>(mParams.threadCount) :
+            std::max(std::thread::hardware_concurrency(), 1u);
+        std::size_t tasks = (count + BodiesPerTask - 1) / BodiesPerTask;
+        if (threads > 1 && tasks > 1)
+        {
+            if (!mPool || mPool->getThreadCount() != threads)
+            {
+                mPool.reset(new ThreadPool(threads));
+            }
+            // Each task writes only its own bodies, so the result does not
+            // depend on which thread runs it.
+            mPool->run(tasks, [&](std::size_t task, unsigned)
+            {
+                computeRange(task * BodiesPerTask,
+                    std::min(count, (task + 1) * BodiesPerTask));
+            });
+        }
+        else
+        {
+            computeRange(0, count);
+        }
+        mAccelerationsValid = true;
+    }
+
+    void OrbitalSystem::buildTree()
+    {
+        mPoints.resize(mX.size());
+        for (std::size_t i = 0; i < mX.size(); ++i)
+        {
+            mPoints[i] = atlas::math::Point(mX[i], mY[i], mZ[i]);
+        }
+        mTree.build(mPoints, mParams.leafSize);
+
+        // Children always follow their parents, so walking backwards fills
+        // every node after all of its children.
+        std::vector<OctreeNode> const& nodes = mTree.getNodes();
+        std::vector<std::uint32_t> const& members = mTree.getIndices();
+        mNodeMasses.assign(nodes.size(),
+            NodeMass{ 0.0f, atlas::math::Point(0.0f) });
+        for (std::size_t n = nodes.size(); n-- > 0;)
+        {
+            NodeMass& node = mNodeMasses[n];
+            atlas::math::Vector weighted(0.0f);
+            if (nodes[n].firstChild == 0)
+            {
+                for (std::uint32_t k = nodes[n].begin; k < nodes[n].end; ++k)
+                {
+                    node.mass += mMass[members[k]];
+                    weighted += mPoints[members[k]] * mMass[members[k]];
+                }
+            }
+            else
+            {
+                for (std::uint32_t c = 0; c < 8; ++c)
+                {
+                    NodeMass const& child =
+                        mNodeMasses[nodes[n].firstChild + c];
+                    node.mass += child.mass;
+                    weighted += child.centre * child.mass;
+                }
+            }
+            node.centre = (node.mass > 0.0f) ?
+                weighted * (1.0f / node.mass) :
+                nodes[n].center;
+        }
+    }
+
+    void OrbitalSystem::accumulateMutual(std::size_t index,
+        atlas::math::Vector& sum) const
+    {
+        atlas::math::Point const& self = mPoints[index];
+        std::vector<std::uint32_t> const& members = mTree.getIndices();
+        float eps2 = mParams.softening * mParams.softening;
+        float G = mParams.gravity;
+
+        mTree.traverse([&](std::uint32_t nodeIndex, OctreeNode const& node)
+        {
+            NodeMass const& aggregate = mNodeMasses[nodeIndex];
+            if (aggregate.mass <= 0.0f)
+            {
+                return false;
+            }
+
+            if (node.firstChild == 0)
+            {
+                for (std::uint32_t k = node.begin; k < node.end; ++k)
+                {
+                    std::uint32_t other = members[k];
+                    if (other == index)
+                    {
+                        continue;
+                    }
+                    atlas::math::Vector offset = mPoints[other] - self;
+                    float r2 = glm::dot(offset, offset) + eps2;
+                    sum += offset * (G * mMass[other] / (r2 * std::sqrt(r2)));
+                }
+                return false;
+            }
+
+            // Far enough away that the node looks like one body: its width
+            // subtends less than the opening angle.
+            atlas::math::Vector offset = aggregate.centre - self;
+            float distance2 = glm::dot(offset, offset);
+            float width = 2.0f * node.halfSize;
+            float angle = mParams.openingAngle;
+            if (width * width < angle * angle * distance2)
+            {
+                float r2 = distance2 + eps2;
+                sum += offset * (G * aggregate.mass / (r2 * std::sqrt(r2)));
+                return false;
+            }
+            return true;
+        });
+    }
+}
@@ -0,0 +1,406 @@
+#include "ParameterSweep.hpp"
+#include "FlockSimulation.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+namespace bns
+{
+    namespace
+    {
+        // A sweepable parameter: how a spec value sets it and how it is
+        // written to the results. The results have one column per entry, in
+        // this order.
+        struct SweepParameter
+        {
+            char const* name;
+            std::function<void(FlockParameters&, double)> set;
+            std::function<void(std::ostream&, FlockParameters const&)> write;
+        };
+
+        template <typename T>
+        SweepParameter field(char const* name, T FlockParameters::* member)
+        {
+            return
+            {
+                name,
+                [member](FlockParameters& p, double v)
+                {
+                    p.*member = static_cast<T>(v);
+                },
+                [member](std::ostream& out, FlockParameters const& p)
+                {
+                    out << p.*member;
+                }
+            };
+        }
+
+        std::vector<SweepParameter> const& getParameters()
+        {
+            static std::vector<SweepParameter> const parameters
+            {
+                field("separationWeight", &FlockParameters::separationWeight),
+                field("alignmentWeight", &FlockParameters::alignmentWeight),
+                field("cohesionWeight", &FlockParameters::cohesionWeight),
+                field("avoidanceWeight", &FlockParameters::avoidanceWeight),
+                field("mass", &FlockParameters::mass),
+                {
+                    "integrator",
+                    [](FlockParameters& p, double v)
+                    {
+                        p.integrator = IntegratorType(int(v));
+                    },
+                    [](std::ostream& out, FlockParameters const& p)
+                    {
+                        out << int(p.integrator);
+                    }
+                },
+                field("timeStep", &FlockParameters::timeStep),
+                field("maxSpeed", &FlockParameters::maxSpeed),
+                field("maxForce", &FlockParameters::maxForce),
+                field("flockRadius", &FlockParameters::flockRadius),
+                field("viewRadius", &FlockParameters::viewRadius),
+                field("viewAngle", &FlockParameters::viewAngle),
+                field("boidRadius", &FlockParameters::boidRadius),
+                field("numBoids", &FlockParameters::numBoids),
+                field("neighbourSkin", &FlockParameters::neighbourSkin),
+                field("farField", &FlockParameters::farField),
+                field("nearRadius", &FlockParameters::nearRadius),
+                field("farFieldAngle", &FlockParameters::farFieldAngle),
+                field("reorderInterval", &FlockParameters::reorderInterval),
+                field("continuousCollision",
+                    &FlockParameters::continuousCollision),
+                field("threadCount", &FlockParameters::threadCount),
+                field("partsPerThread", &FlockParameters::partsPerThread),
+                field("autoTune", &FlockParameters::autoTune),
+                field("fleeWeight", &FlockParameters::fleeWeight),
+                {
+                    "numSpecies",
+                    [](FlockParameters& p, double v)
+                    {
+                        p.setSpecies(int(v));
+                    },
+                    [](std::ostream& out, FlockParameters const& p)
+                    {
+                        out << p.numSpecies;
+                    }
+                },
+                field("seed", &FlockParameters::seed)
+            };
+            return parameters;
+        }
+
+        SweepParameter const* findParameter(std::string const& name)
+        {
+            for (auto const& parameter : getParameters())
+            {
+                if (name == parameter.name)
+                {
+                    return &parameter;
+                }
+            }
+            return nullptr;
+        }
+
+        std::string trim(std::string const& str)
+        {
+            auto first = str.find_first_not_of(" \t\r");
+            if (first == std::string::npos)
+            {
+                return {};
+            }
+            auto last = str.find_last_not_of(" \t\r");
+            return str.substr(first, last - first + 1);
+        }
+
+        bool parseValues(std::string const& text, std::vector<double>& values)
+        {
+            std::istringstream stream(text);
+            if (text.find(':') != std::string::npos)
+            {
+                double start, stop, step;
+                char colon1, colon2;
+                if (!(stream >> start >> colon1 >> stop >> colon2 >> step) ||
+                    step <= 0.0)
+                {
+                    return false;
+                }
+
+                // Nudge the end so that ranges like 0.5:2.0:0.5 include 2.0.
+                for (double v = start; v <= stop + step * 1e-6; v += step)
+                {
+                    values.push_back(v);
+                }
+                return !values.empty();
+            }
+
+            std::string item;
+            while (std::getline(stream, item, ','))
+            {
+                std::istringstream itemStream(item);
+                double v;
+                if (!(itemStream >> v))
+                {
+                    return false;
+                }
+                values.push_back(v);
+            }
+            return !values.empty();
+        }
+    }
+
+    ParameterSweep::ParameterSweep() :
+        mSteps(600),
+        mSampleEvery(10)
+    { }
+
+    bool ParameterSweep::loadSpecification(std::string const& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            ERROR_LOG_V("Could not open sweep specification %s", path.c_str());
+            return false;
+        }
+
+        mRuns.assign(1, FlockParameters());
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty())
+            {
+                continue;
+            }
+
+            auto equals = line.find('=');
+            std::vector<double> values;
+            if (equals == std::string::npos ||
+                !parseValues(line.substr(equals + 1), values))
+            {
+                ERROR_LOG_V("%s:%d: expected `name = values`", path.c_str(),
+                    lineNumber);
+                return false;
+            }
+
+            std::string name = trim(line.substr(0, equals));
+            if (name == "steps")
+            {
+                mSteps = std::max(1, int(values[0]));
+                continue;
+            }
+            if (name == "sampleEvery")
+            {
+                mSampleEvery = std::max(1, int(values[0]));
+                continue;
+            }
+
+            SweepParameter const* parameter = findParameter(name);
+            if (parameter == nullptr)
+            {
+                ERROR_LOG_V("%s:%d: unknown parameter %s", path.c_str(),
+                    lineNumber, name.c_str());
+                return false;
+            }
+
+            // A flock needs at least one boid; anything less would be sized
+            // as a huge unsigned count.
+            if (name == "numBoids" && std::any_of(values.begin(),
+                values.end(), [](double v) { return int(v) < 1; }))
+            {
+                ERROR_LOG_V("%s:%d: numBoids must be at least 1",
+                    path.c_str(), lineNumber);
+                return false;
+            }
+
+            // Integrators are picked by their IntegratorType index; anything
+            // else would cast to a type the simulation does not know.
+            int const integratorCount = int(IntegratorType::RungeKutta4) + 1;
+            if (name == "integrator" && std::any_of(values.begin(),
+                values.end(), [integratorCount](double v)
+            {
+                return v != std::floor(v) || v < 0.0 || v >= integratorCount;
+            }))
+            {
+                ERROR_LOG_V("%s:%d: integrator must be a whole number from 0 "
+                    "to %d", path.c_str(), lineNumber, integratorCount - 1);
+                return false;
+            }
+
+            // Cartesian product with everything listed so far.
+            std::vector<FlockParameters> runs;
+            runs.reserve(mRuns.size() * values.size());
+            for (auto const& run : mRuns)
+            {
+                for (double v : values)
+                {
+                    FlockParameters params = run;
+                    parameter->set(params, v);
+                    runs.push_back(params);
+                }
+            }
+            mRuns = std::move(runs);
+        }
+
+        return true;
+    }
+
+    void ParameterSweep::run(unsigned threadCount)
+    {
+        mResults.assign(mRuns.size(), SweepResult());
+
+        // Runs are independent, so workers just pull the next index.
+        std::atomic<std::size_t> next(0);
+        auto worker = [this, &next]()
+        {
+            for (;;)
+            {
+                std::size_t index = next++;
+                if (index >= mRuns.size())
+                {
+                    return;
+                }
+                mResults[index] = runOne(mRuns[index]);
+            }
+        };
+
+        threadCount = std::max(1u, std::min<unsigned>(threadCount,
+            static_cast<unsigned>(mRuns.size())));
+        std::vector<std::thread> workers;
+        for (unsigned i = 1; i < threadCount; ++i)
+        {
+            workers.emplace_back(worker);
+        }
+        worker();
+
+        for (auto& thread : workers)
+        {
+            thread.join();
+        }
+    }
+
+    bool ParameterSweep::writeResults(std::string const& path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            ERROR_LOG_V("Could not write sweep results to %s", path.c_str());
+            return false;
+        }
+
+        file << "run";
+        for (auto const& parameter : getParameters())
+        {
+            file << ',' << parameter.name;
+        }
+        file << ",polarisation,meanNearestDistance,collisions,clusters,"
+            "meanStepMs,maxStepMs,tunerLocked,tunedThreadCount,"
+            "tunedPartsPerThread,tunedNeighbourSkin\n";
+
+        for (std::size_t i = 0; i < mResults.size(); ++i)
+        {
+            auto const& r = mResults[i];
+            auto const& p = r.params;
+            file << i;
+            for (auto const& parameter : getParameters())
+            {
+                file << ',';
+                parameter.write(file, p);
+            }
+            file << ',' << r.metrics.polarisation << ','
+                << r.metrics.meanNearestDistance << ',' << r.metrics.collisions
+                << ',' << r.metrics.clusters << ',' << r.meanStepMilliseconds
+                << ',' << r.maxStepMilliseconds;
+
+            // The tuned settings are left blank for runs without the tuner.
+            if (p.autoTune)
+            {
+                auto const& tuned = r.tuner.settings;
+                file << ',' << r.tuner.locked << ',' << tuned.threadCount
+                    << ',' << tuned.partsPerThread << ','
+                    << tuned.neighbourSkin << '\n';
+            }
+            else
+            {
+                file << ",,,,\n";
+            }
+        }
+
+        return true;
+    }
+
+    std::size_t ParameterSweep::getRunCount() const
+    {
+        return mRuns.size();
+    }
+
+    SweepResult ParameterSweep::runOne(FlockParameters const& params) const
+    {
+        using Clock = std::chrono::steady_clock;
+
+        SweepResult result;
+        result.params = params;
+        result.maxStepMilliseconds = 0.0;
+        result.tuner = TunerStatus();
+
+        FlockSimulation simulation(params);
+        double totalMilliseconds = 0.0;
+        double polarisation = 0.0;
+        double nearest = 0.0;
+        double collisions = 0.0;
+        double clusters = 0.0;
+        int samples = 0;
+
+        for (int step = 1; step <= mSteps; ++step)
+        {
+            auto start = Clock::now();
+            simulation.step();
+            double ms = std::chrono::duration<double, std::milli>(
+                Clock::now() - start).count();
+            totalMilliseconds += ms;
+            result.maxStepMilliseconds = std::max(result.maxStepMilliseconds,
+                ms);
+
+            // Only sample once the flock has had time to settle.
+            if (step > mSteps / 2 && step % mSampleEvery == 0)
+            {
+                FlockMetrics const& metrics = simulation.getMetrics();
+                polarisation += metrics.polarisation;
+                nearest += metrics.meanNearestDistance;
+                collisions += metrics.collisions;
+                clusters += metrics.clusters;
+                samples++;
+            }
+        }
+
+        if (samples == 0)
+        {
+            result.metrics = simulation.getMetrics();
+        }
+        else
+        {
+            result.metrics.polarisation = float(polarisation / samples);
+            result.metrics.meanNearestDistance = float(nearest / samples);
+            result.metrics.collisions = int(collisions / samples + 0.5);
+            result.metrics.clusters = int(clusters / samples + 0.5);
+        }
+        result.meanStepMilliseconds = totalMilliseconds / mSteps;
+        if (params.autoTune)
+        {
+            result.tuner = simulation.getTunerStatus();
+        }
+        return result;
+    }
+}
@@ -0,0 +1,241 @@
+#include "PlanetField.hpp"
+#include "Paths.hpp"
+#include "LayoutLocations.glsl"
+
+#include <atlas/utils/Mesh.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace bns
+{
+    namespace
+    {
+        constexpr int DefaultBodyCount = 10000;
+        constexpr std::uint32_t DiscSeed = 5;
+        // The disc rings the stage around the flock.
+        constexpr float DiscInnerRadius = 6.0f;
+        constexpr float DiscOuterRadius = 18.0f;
+        constexpr float DiscMass = 10.0f;
+
+        // Bodies shade from warm near the centre to cool at the rim.
+        const atlas::math::Vector InnerColour = { 0.95f, 0.7f, 0.35f };
+        const atlas::math::Vector OuterColour = { 0.45f, 0.6f, 0.95f };
+
+        OrbitalParameters makeParameters()
+        {
+            OrbitalParameters params;
+            params.threadCount = 0;
+            return params;
+        }
+    }
+
+    PlanetField::PlanetField(std::pmr::memory_resource* frameMemory) :
+        mVertexBuffer(GL_ARRAY_BUFFER),
+        mIndexBuffer(GL_ELEMENT_ARRAY_BUFFER),
+        mInstanceBuffer(GL_ARRAY_BUFFER),
+        mIndexCount(0),
+        mInstanceCount(0),
+        mTexture(0),
+        mFrameMemory(frameMemory),
+        mBodyCount(DefaultBodyCount),
+        mSystem(makeParameters())
+    {
+        using atlas::utils::Mesh;
+        namespace gl = atlas::gl;
+
+        Mesh sphere;
+        std::string path{ DataDirectory };
+        path = path + "sphere.obj";
+        Mesh::fromFile(path, sphere);
+
+        mIndexCount = static_cast<GLsizei>(sphere.indices().size());
+
+        std::pmr::vector<float> data(mFrameMemory);
+        data.reserve(sphere.vertices().size() * 8);
+        for (std::size_t i = 0; i < sphere.vertices().size(); ++i)
+        {
+            data.push_back(sphere.vertices()[i].x);
+            data.push_back(sphere.vertices()[i].y);
+            data.push_back(sphere.vertices()[i].z);
+
+            data.push_back(sphere.normals()[i].x);
+            data.push_back(sphere.normals()[i].y);
+            data.push_back(sphere.normals()[i].z);
+
+            data.push_back(sphere.texCoords()[i].x);
+            data.push_back(sphere.texCoords()[i].y);
+        }
+
+        mVao.bindVertexArray();
+        mVertexBuffer.bindBuffer();
+        mVertexBuffer.bufferData(gl::size<float>(data.size()), data.data(),
+            GL_STATIC_DRAW);
+        mVertexBuffer.vertexAttribPointer(VERTICES_LAYOUT_LOCATION, 3, GL_FLOAT,
+            GL_FALSE, gl::stride<float>(8), gl::bufferOffset<float>(0));
+        mVertexBuffer.vertexAttribPointer(NORMALS_LAYOUT_LOCATION, 3, GL_FLOAT,
+            GL_FALSE, gl::stride<float>(8), gl::bufferOffset<float>(3));
+        mVertexBuffer.vertexAttribPointer(TEXTURES_LAYOUT_LOCATION, 2, GL_FLOAT,
+            GL_FALSE, gl::stride<float>(8), gl::bufferOffset<float>(6));
+        mVao.enableVertexAttribArray(VERTICES_LAYOUT_LOCATION);
+        mVao.enableVertexAttribArray(NORMALS_LAYOUT_LOCATION);
+        mVao.enableVertexAttribArray(TEXTURES_LAYOUT_LOCATION);
+
+        mInstanceBuffer.bindBuffer();
+        mInstanceBuffer.bufferData(0, nullptr, GL_STREAM_DRAW);
+        mInstanceBuffer.vertexAttribPointer(INSTANCE_SPHERE_LAYOUT_LOCATION,
+            4, GL_FLOAT, GL_FALSE,
+            static_cast<GLsizei>(sizeof(PlanetInstance)),
+            gl::bufferOffset<float>(0));
+        mInstanceBuffer.vertexAttribPointer(INSTANCE_COLOUR_LAYOUT_LOCATION, 3,
+            GL_FLOAT, GL_FALSE, static_cast<GLsizei>(sizeof(PlanetInstance)),
+            gl::bufferOffset<float>(4));
+        mVao.enableVertexAttribArray(INSTANCE_SPHERE_LAYOUT_LOCATION);
+        glVertexAttribDivisor(INSTANCE_SPHERE_LAYOUT_LOCATION, 1);
+        mVao.enableVertexAttribArray(INSTANCE_COLOUR_LAYOUT_LOCATION);
+        glVertexAttribDivisor(INSTANCE_COLOUR_LAYOUT_LOCATION, 1);
+
+        mIndexBuffer.bindBuffer();
+        mIndexBuffer.bufferData(gl::size<GLuint>(sphere.indices().size()),
+            sphere.indices().data(), GL_STATIC_DRAW);
+
+        mIndexBuffer.unBindBuffer();
+        mInstanceBuffer.unBindBuffer();
+        mVertexBuffer.unBindBuffer();
+        mVao.unBindVertexArray();
+
+        std::vector<gl::ShaderUnit> shaders
+        {
+            {std::string(ShaderDirectory) + "Planet.vs.glsl",
+                GL_VERTEX_SHADER},
+            {std::string(ShaderDirectory) + "Planet.fs.glsl",
+                GL_FRAGMENT_SHADER}
+        };
+
+        mShaders.emplace_back(shaders);
+        mShaders[0].setShaderIncludeDir(ShaderDirectory);
+        mShaders[0].compileShaders();
+        mShaders[0].linkShaders();
+
+        const char* names[] = { "projection", "view", "surface", "textured" };
+        for (const char* name : names)
+        {
+            auto var = mShaders[0].getUniformVariable(name);
+            mUniforms.insert(UniformKey(name, var));
+        }
+
+        mShaders[0].disableShaders();
+
+        resetGeometry();
+    }
+
+    void PlanetField::updateGeometry(atlas::core::Time<> const& t)
+    {
+        mSystem.step(static_cast<float>(t.deltaTime));
+    }
+
+    void PlanetField::renderGeometry(atlas::math::Matrix4 const& projection,
+        atlas::math::Matrix4 const& view)
+    {
+        prepareFrame();
+        renderView(projection, view);
+    }
+
+    void PlanetField::prepareFrame()
+    {
+        namespace gl = atlas::gl;
+        namespace math = atlas::math;
+
+        mShaders[0].hotReloadShaders();
+        std::size_t count = mSystem.getBodyCount();
+        mInstanceCount = static_cast<GLsizei>(count);
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Gathered from the separate component arrays into one interleaved
+        // stream, the only layout the draw needs.
+        std::vector<float> const& x = mSystem.getX();
+        std::vector<float> const& y = mSystem.getY();
+        std::vector<float> const& z = mSystem.getZ();
+        std::vector<float> const& radii = mSystem.getRadii();
+        std::pmr::vector<PlanetInstance> instances(count, mFrameMemory);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float distance = std::sqrt(x[i] * x[i] + z[i] * z[i]);
+            float t = std::min(std::max((distance - DiscInnerRadius) /
+                (DiscOuterRadius - DiscInnerRadius), 0.0f), 1.0f);
+            instances[i].sphere = math::Vector4(x[i], y[i], z[i], radii[i]);
+            instances[i].colour = glm::mix(InnerColour, OuterColour, t);
+        }
+
+        mInstanceBuffer.bindBuffer();
+        mInstanceBuffer.bufferData(gl::size<PlanetInstance>(count),
+            instances.data(), GL_STREAM_DRAW);
+        mInstanceBuffer.unBindBuffer();
+    }
+
+    void PlanetField::renderView(atlas::math::Matrix4 const& projection,
+        atlas::math::Matrix4 const& view)
+    {
+        if (!mShaders[0].shaderProgramValid() || mInstanceCount == 0)
+        {
+            return;
+        }
+
+        mShaders[0].enableShaders();
+
+        mVao.bindVertexArray();
+        mIndexBuffer.bindBuffer();
+
+        glUniformMatrix4fv(mUniforms["projection"], 1, GL_FALSE,
+            &projection[0][0]);
+        glUniformMatrix4fv(mUniforms["view"], 1, GL_FALSE, &view[0][0]);
+        glUniform1i(mUniforms["textured"], mTexture != 0);
+        if (mTexture != 0)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, mTexture);
+            glUniform1i(mUniforms["surface"], 0);
+        }
+
+        glDrawElementsInstanced(GL_TRIANGLES, mIndexCount, GL_UNSIGNED_INT, 0,
+            mInstanceCount);
+
+        if (mTexture != 0)
+        {
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        mIndexBuffer.unBindBuffer();
+        mVao.unBindVertexArray();
+        mShaders[0].disableShaders();
+    }
+
+    void PlanetField::resetGeometry()
+    {
+        mSystem.scatterDisc(static_cast<std::size_t>(mBodyCount),
+            DiscInnerRadius, DiscOuterRadius, DiscMass, DiscSeed);
+    }
+
+    int PlanetField::getBodyCount() const
+    {
+        return mBodyCount;
+    }
+
+    void PlanetField::setBodyCount(int count)
+    {
+        mBodyCount = std::max(count, 0);
+        resetGeometry();
+    }
+
+    void PlanetField::setTexture(GLuint texture)
+    {
+        mTexture = texture;
+    }
+
+    OrbitalSystem& PlanetField::getSystem()
+    {
+        return mSystem;
+    }
+}
@@ -0,0 +1,224 @@
+#include "SignedDistanceField.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace bns
+{
+    namespace
+    {
+        using atlas::math::Point;
+        using atlas::math::Vector;
+
+        // Closest point on triangle abc to p (Ericson, Real-Time Collision
+        // Detection, 5.1.5).
+        Point closestOnTriangle(Point const& p, Point const& a, Point const& b,
+            Point const& c)
+        {
+            Vector ab = b - a;
+            Vector ac = c - a;
+            Vector ap = p - a;
+            float d1 = glm::dot(ab, ap);
+            float d2 = glm::dot(ac, ap);
+            if (d1 <= 0.0f && d2 <= 0.0f)
+            {
+                return a;
+            }
+
+            Vector bp = p - b;
+            float d3 = glm::dot(ab, bp);
+            float d4 = glm::dot(ac, bp);
+            if (d3 >= 0.0f && d4 <= d3)
+            {
+                return b;
+            }
+
+            float vc = d1 * d4 - d3 * d2;
+            if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            {
+                return a + ab * (d1 / (d1 - d3));
+            }
+
+            Vector cp = p - c;
+            float d5 = glm::dot(ab, cp);
+            float d6 = glm::dot(ac, cp);
+            if (d6 >= 0.0f && d5 <= d6)
+            {
+                return c;
+            }
+
+            float vb = d5 * d2 - d1 * d6;
+            if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            {
+                return a + ac * (d2 / (d2 - d6));
+            }
+
+            float va = d3 * d6 - d5 * d4;
+            if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            {
+                return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+            }
+
+            float denom = 1.0f / (va + vb + vc);
+            return a + ab * (vb * denom) + ac * (vc * denom);
+        }
+
+        // Solid angle of triangle abc seen from p (Van Oosterom & Strackee).
+        // Summed over a closed mesh this is 4 pi inside and 0 outside, which
+        // gives a sign that does not depend on which triangle is closest.
+        float solidAngle(Point const& p, Point const& a, Point const& b,
+            Point const& c)
+        {
+            Vector ra = a - p;
+            Vector rb = b - p;
+            Vector rc = c - p;
+            float la = glm::length(ra);
+            float lb = glm::length(rb);
+            float lc = glm::length(rc);
+
+            float numerator = glm::dot(ra, glm::cross(rb, rc));
+            float denominator = la * lb * lc + glm::dot(ra, rb) * lc +
+                glm::dot(rb, rc) * la + glm::dot(rc, ra) * lb;
+            return 2.0f * std::atan2(numerator, denominator);
+        }
+    }
+
+    SignedDistanceField::SignedDistanceField() :
+        mOrigin(0.0f),
+        mCellSize(1.0f),
+        mSize{ 0, 0, 0 }
+    { }
+
+    void SignedDistanceField::bake(std::vector<Point> const& vertices,
+        std::vector<std::uint32_t> const& indices, float cellSize,
+        float padding)
+    {
+        mDistances.clear();
+        if (vertices.empty() || indices.size() < 3 || cellSize <= 0.0f)
+        {
+            mSize[0] = mSize[1] = mSize[2] = 0;
+            return;
+        }
+
+        Point lo(std::numeric_limits<float>::max());
+        Point hi(std::numeric_limits<float>::lowest());
+        for (auto const& v : vertices)
+        {
+            lo = glm::min(lo, v);
+            hi = glm::max(hi, v);
+        }
+
+        mOrigin = lo - Vector(padding);
+        mCellSize = cellSize;
+        for (int c = 0; c < 3; ++c)
+        {
+            mSize[c] = static_cast<int>(std::ceil(
+                (hi[c] - lo[c] + 2.0f * padding) / cellSize)) + 1;
+        }
+
+        mDistances.resize(static_cast<std::size_t>(mSize[0]) * mSize[1] *
+            mSize[2]);
+
+        float const fourPi = 4.0f * 3.14159265f;
+        std::size_t const triangles = indices.size() / 3;
+
+        for (int z = 0; z < mSize[2]; ++z)
+        {
+            for (int y = 0; y < mSize[1]; ++y)
+            {
+                for (int x = 0; x < mSize[0]; ++x)
+                {
+                    Point p = mOrigin + Vector(float(x), float(y), float(z)) *
+                        cellSize;
+
+                    float nearest = std::numeric_limits<float>::max();
+                    float winding = 0.0f;
+                    for (std::size_t t = 0; t < triangles; ++t)
+                    {
+                        Point const& a = vertices[indices[3 * t]];
+                        Point const& b = vertices[indices[3 * t + 1]];
+                        Point const& c = vertices[indices[3 * t + 2]];
+
+                        Vector d = p - closestOnTriangle(p, a, b, c);
+                        nearest = std::min(nearest, glm::dot(d, d));
+                        winding += solidAngle(p, a, b, c);
+                    }
+
+                    float distance = std::sqrt(nearest);
+                    bool inside = std::abs(winding) > 0.5f * fourPi;
+                    mDistances[(static_cast<std::size_t>(z) * mSize[1] + y) *
+                        mSize[0] + x] = inside ? -distance : distance;
+                }
+            }
+        }
+    }
+
+    bool SignedDistanceField::isEmpty() const
+    {
+        return mDistances.empty();
+    }
+
+    float SignedDistanceField::sample(Point const& point, Vector& gradient,
+        float far) const
+    {
+        gradient = Vector(0.0f);
+        if (mDistances.empty())
+        {
+            return far;
+        }
+
+        Vector local = (point - mOrigin) / mCellSize;
+        int cell[3];
+        float t[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            float f = std::floor(local[c]);
+            if (f < 0.0f || f >= mSize[c] - 1)
+            {
+                return far;
+            }
+            cell[c] = static_cast<int>(f);
+            t[c] = local[c] - f;
+        }
+
+        int x = cell[0];
+        int y = cell[1];
+        int z = cell[2];
+        float c000 = at(x, y, z);
+        float c100 = at(x + 1, y, z);
+        float c010 = at(x, y + 1, z);
+        float c110 = at(x + 1, y + 1, z);
+        float c001 = at(x, y, z + 1);
+        float c101 = at(x + 1, y, z + 1);
+        float c011 = at(x, y + 1, z + 1);
+        float c111 = at(x + 1, y + 1, z + 1);
+
+        float tx = t[0];
+        float ty = t[1];
+        float tz = t[2];
+
+        float c00 = glm::mix(c000, c100, tx);
+        float c10 = glm::mix(c010, c110, tx);
+        float c01 = glm::mix(c001, c101, tx);
+        float c11 = glm::mix(c011, c111, tx);
+        float c0 = glm::mix(c00, c10, ty);
+        float c1 = glm::mix(c01, c11, ty);
+
+        // Analytic derivative of the trilinear interpolant.
+        float dx = glm::mix(
+            glm::mix(c100 - c000, c110 - c010, ty),
+            glm::mix(c101 - c001, c111 - c011, ty), tz);
+        float dy = glm::mix(c10 - c00, c11 - c01, tz);
+        float dz = c1 - c0;
+        gradient = Vector(dx, dy, dz) / mCellSize;
+
+        return glm::mix(c0, c1, tz);
+    }
+
+    float SignedDistanceField::at(int x, int y, int z) const
+    {
+        return mDistances[(static_cast<std::size_t>(z) * mSize[1] + y) *
+            mSize[0] + x];
+    }
+}
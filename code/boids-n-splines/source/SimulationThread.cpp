@@ -0,0 +1,302 @@
+#include "SimulationThread.hpp"
+
+#include <chrono>
+
+namespace bns
+{
+    namespace
+    {
+        // Room for the two steps that may be pending plus a burst of
+        // settings changes.
+        constexpr std::size_t CommandCapacity = 32;
+    }
+
+    SimCommand SimCommand::step(float seconds)
+    {
+        return { SimCommandType::Step, 0, nullptr, 0, false, seconds };
+    }
+
+    SimCommand SimCommand::reset()
+    {
+        return { SimCommandType::Reset, 0, nullptr, 0, false, 0.0f };
+    }
+
+    SimCommand SimCommand::seek(std::uint64_t frame)
+    {
+        return { SimCommandType::Seek, frame, nullptr, 0, false, 0.0f };
+    }
+
+    SimCommand SimCommand::setObstacles(SignedDistanceField const* obstacles)
+    {
+        return { SimCommandType::SetObstacles, 0, obstacles, 0, false, 0.0f };
+    }
+
+    SimCommand SimCommand::setSpecies(int count)
+    {
+        return { SimCommandType::SetSpecies, 0, nullptr, count, false, 0.0f };
+    }
+
+    SimCommand SimCommand::setFarField(bool enabled)
+    {
+        return { SimCommandType::SetFarField, 0, nullptr, 0, enabled, 0.0f };
+    }
+
+    SimCommand SimCommand::setCollisions(bool enabled)
+    {
+        return { SimCommandType::SetCollisions, 0, nullptr, 0, enabled,
+            0.0f };
+    }
+
+    SimCommand SimCommand::setThreads(int count)
+    {
+        return { SimCommandType::SetThreads, 0, nullptr, count, false, 0.0f };
+    }
+
+    SimCommand SimCommand::setAutoTune(bool enabled)
+    {
+        return { SimCommandType::SetAutoTune, 0, nullptr, 0, enabled, 0.0f };
+    }
+
+    SimCommand SimCommand::setIntegrator(IntegratorType integrator)
+    {
+        return { SimCommandType::SetIntegrator, 0, nullptr,
+            static_cast<int>(integrator), false, 0.0f };
+    }
+
+    void executeCommand(FlockSimulation& simulation, SimCommand const& command)
+    {
+        switch (command.type)
+        {
+        case SimCommandType::Step:
+            simulation.setTimeStep(command.seconds);
+            simulation.step();
+            break;
+
+        case SimCommandType::Reset:
+            simulation.reset();
+            break;
+
+        case SimCommandType::Seek:
+            simulation.seek(command.frame);
+            break;
+
+        case SimCommandType::SetObstacles:
+            simulation.setObstacles(command.obstacles);
+            break;
+
+        case SimCommandType::SetSpecies:
+            simulation.setSpecies(command.count);
+            break;
+
+        case SimCommandType::SetFarField:
+            simulation.setFarField(command.enabled);
+            break;
+
+        case SimCommandType::SetCollisions:
+            simulation.setContinuousCollision(command.enabled);
+            break;
+
+        case SimCommandType::SetThreads:
+            simulation.setThreadCount(command.count);
+            break;
+
+        case SimCommandType::SetAutoTune:
+            simulation.setAutoTune(command.enabled);
+            break;
+
+        case SimCommandType::SetIntegrator:
+            simulation.setIntegrator(
+                static_cast<IntegratorType>(command.count));
+            break;
+        }
+    }
+
+    SimulationThread::SimulationThread(FlockSimulation& simulation) :
+        mSimulation(simulation),
+        mCommands(CommandCapacity),
+        mCommandHead(0),
+        mCommandCount(0),
+        mPendingSteps(0),
+        mStopRequested(false),
+        mRunning(false)
+    { }
+
+    SimulationThread::~SimulationThread()
+    {
+        stop();
+    }
+
+    void SimulationThread::start()
+    {
+        if (mRunning)
+        {
+            return;
+        }
+
+        mStopRequested = false;
+        mPendingSteps = 0;
+        mCommandHead = 0;
+        mCommandCount = 0;
+
+        // Publish the current state up front so the render thread has
+        // something to draw before the first step completes.
+        publishSnapshot();
+        mSnapshots.update();
+
+        mRunning = true;
+        mThread = std::thread(&SimulationThread::run, this);
+    }
+
+    void SimulationThread::stop()
+    {
+        if (!mRunning)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopRequested = true;
+        }
+        mCondition.notify_one();
+        mThread.join();
+        mRunning = false;
+
+        // Settings changes (and seeks) posted just before the stop must
+        // still reach the simulation; only the pending steps are dropped.
+        while (mCommandCount > 0)
+        {
+            SimCommand command = popCommand();
+            if (command.type != SimCommandType::Step)
+            {
+                executeCommand(mSimulation, command);
+            }
+        }
+        mPendingSteps = 0;
+        updateQueueDepth();
+    }
+
+    bool SimulationThread::isRunning() const
+    {
+        return mRunning;
+    }
+
+    void SimulationThread::post(SimCommand const& command)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (command.type == SimCommandType::Step)
+            {
+                // If the simulation falls behind, drop steps rather than let
+                // the queue (and the latency between sim and render) grow.
+                if (mPendingSteps >= 2)
+                {
+                    if (mInstruments.droppedSteps != nullptr)
+                    {
+                        mInstruments.droppedSteps->add();
+                    }
+                    return;
+                }
+                mPendingSteps++;
+            }
+            pushCommand(command);
+            updateQueueDepth();
+        }
+        mCondition.notify_one();
+    }
+
+    void SimulationThread::setInstruments(
+        SimulationInstruments const& instruments)
+    {
+        mInstruments = instruments;
+    }
+
+    FlockSnapshot const& SimulationThread::acquireSnapshot()
+    {
+        mSnapshots.update();
+        return mSnapshots.getReadBuffer();
+    }
+
+    void SimulationThread::run()
+    {
+        for (;;)
+        {
+            SimCommand command;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]()
+                {
+                    return mStopRequested || mCommandCount > 0;
+                });
+
+                if (mStopRequested)
+                {
+                    return;
+                }
+
+                command = popCommand();
+                if (command.type == SimCommandType::Step)
+                {
+                    mPendingSteps--;
+                }
+                updateQueueDepth();
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            executeCommand(mSimulation, command);
+            if (command.type == SimCommandType::Step &&
+                mInstruments.stepSeconds != nullptr)
+            {
+                mInstruments.stepSeconds->observe(
+                    std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count());
+            }
+            publishSnapshot();
+        }
+    }
+
+    void SimulationThread::publishSnapshot()
+    {
+        FlockSnapshot& snapshot = mSnapshots.getWriteBuffer();
+        snapshot.boids = mSimulation.getBoids();
+        snapshot.slots = mSimulation.getSlots();
+        snapshot.frame = mSimulation.getFrame();
+        snapshot.metrics = mSimulation.getMetrics();
+        snapshot.loadBalance = mSimulation.getLoadBalance();
+        snapshot.tuner = mSimulation.getTunerStatus();
+        mSnapshots.publish();
+    }
+
+    void SimulationThread::updateQueueDepth()
+    {
+        if (mInstruments.queueDepth != nullptr)
+        {
+            mInstruments.queueDepth->set(static_cast<double>(mCommandCount));
+        }
+    }
+
+    void SimulationThread::pushCommand(SimCommand const& command)
+    {
+        if (mCommandCount == mCommands.size())
+        {
+            // Unroll into twice the room, oldest first.
+            std::vector<SimCommand> grown(mCommands.size() * 2);
+            for (std::size_t i = 0; i < mCommandCount; ++i)
+            {
+                grown[i] = mCommands[(mCommandHead + i) % mCommands.size()];
+            }
+            mCommands.swap(grown);
+            mCommandHead = 0;
+        }
+        mCommands[(mCommandHead + mCommandCount) % mCommands.size()] = command;
+        mCommandCount++;
+    }
+
+    SimCommand SimulationThread::popCommand()
+    {
+        SimCommand command = mCommands[mCommandHead];
+        mCommandHead = (mCommandHead + 1) % mCommands.size();
+        mCommandCount--;
+        return command;
+    }
+}
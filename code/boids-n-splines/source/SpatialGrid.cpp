@@ -0,0 +1,75 @@
+#include "SpatialGrid.hpp"
+
+#include <cmath>
+
+namespace bns
+{
+    SpatialGrid::SpatialGrid() :
+        mCellSize(1.0f),
+        mInverseCellSize(1.0f),
+        mBucketMask(0)
+    { }
+
+    void SpatialGrid::build(std::vector<Boid> const& boids, float cellSize)
+    {
+        mCellSize = cellSize;
+        mInverseCellSize = 1.0f / cellSize;
+
+        // Twice as many buckets as boids (rounded up to a power of two) keeps
+        // collisions between occupied cells rare.
+        std::size_t buckets = 64;
+        while (buckets < boids.size() * 2)
+        {
+            buckets *= 2;
+        }
+        mBucketMask = buckets - 1;
+
+        mBucketStart.assign(buckets + 1, 0);
+        mBucketOf.resize(boids.size());
+        mIndices.resize(boids.size());
+
+        for (std::size_t i = 0; i < boids.size(); ++i)
+        {
+            int x, y, z;
+            getCell(boids[i].mPosition, x, y, z);
+            std::size_t bucket = hashCell(x, y, z);
+            mBucketOf[i] = static_cast<std::uint32_t>(bucket);
+            mBucketStart[bucket]++;
+        }
+
+        // Running totals leave each entry at the end of its bucket; filling
+        // back to front then walks it down to the start, and keeps each
+        // bucket in ascending boid order.
+        for (std::size_t b = 1; b <= buckets; ++b)
+        {
+            mBucketStart[b] += mBucketStart[b - 1];
+        }
+
+        for (std::size_t i = boids.size(); i-- > 0;)
+        {
+            mIndices[--mBucketStart[mBucketOf[i]]] =
+                static_cast<std::uint32_t>(i);
+        }
+    }
+
+    float SpatialGrid::getCellSize() const
+    {
+        return mCellSize;
+    }
+
+    void SpatialGrid::getCell(atlas::math::Point const& point, int& x, int& y,
+        int& z) const
+    {
+        x = static_cast<int>(std::floor(point.x * mInverseCellSize));
+        y = static_cast<int>(std::floor(point.y * mInverseCellSize));
+        z = static_cast<int>(std::floor(point.z * mInverseCellSize));
+    }
+
+    std::size_t SpatialGrid::hashCell(int x, int y, int z) const
+    {
+        std::uint32_t h = static_cast<std::uint32_t>(x) * 73856093u ^
+            static_cast<std::uint32_t>(y) * 19349663u ^
+            static_cast<std::uint32_t>(z) * 83492791u;
+        return h & mBucketMask;
+    }
+}
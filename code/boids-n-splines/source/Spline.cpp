@@ -9,53 +9,95 @@
 #include <atlas/utils/GUI.hpp>
 #include <atlas/core/Macros.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace bns
 {
-    Spline::Spline(int totalFrames) :
+    namespace
+    {
+        // Uniform spans the curve is cut into before refining, so an S bend
+        // whose midpoint happens to sit on the chord is still caught.
+        constexpr int TessellationSegments = 8;
+        constexpr GLsizei SlotCapacity =
+            (TessellationSegments << MaxTessellationDepth) + 1;
+        // Largest distance (in pixels) between the curve and its polyline.
+        constexpr float PixelTolerance = 0.5f;
+
+        // A tessellation is reused while the eye stays within this fraction
+        // of its distance to the curve, the view direction turns by less
+        // than about 2.5 degrees, and the projection and viewport are
+        // unchanged. Within that the screen error stays close to
+        // PixelTolerance.
+        constexpr float RefreshDistance = 0.05f;
+        constexpr float RefreshCosine = 0.999f;
+        constexpr float ProjectionEpsilon = 1e-5f;
+
+        bool sameProjection(atlas::math::Matrix4 const& a,
+            atlas::math::Matrix4 const& b)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                for (int j = 0; j < 4; ++j)
+                {
+                    if (std::abs(a[i][j] - b[i][j]) > ProjectionEpsilon *
+                        std::max(std::abs(a[i][j]), 1.0f))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    Spline::Spline(int totalFrames, std::pmr::memory_resource* frameMemory) :
+        mCurve({
+            { -30, 0, 0 },
+            { 0, 4, -30 },
+            { 30, 8, 0 },
+            { 0, 12, 30 }
+        }, 500),
         mControlBuffer(GL_ARRAY_BUFFER),
         mSplineBuffer(GL_ARRAY_BUFFER),
-        mResolution(500),
         mTotalFrames(totalFrames),
         mCurrentFrame(0),
         mShowSplinePoints(false),
         mShowControlPoints(true),
         mShowCage(false),
         mShowSpline(true),
-        mIsInterpolationDone(false)
+        mIsInterpolationDone(false),
+        mSlots(),
+        mCurveCentre(0.0f),
+        mDrawCount(0),
+        mRefineCount(0),
+        mAdaptive(true)
     {
-        namespace math = atlas::math;
         namespace gl = atlas::gl;
         using atlas::math::Point;
 
-        mBasisMatrix = math::Matrix4(
-            1.0f, 0.0f, 0.0f, 0.0f,
-            -3.0f, 3.0f, 0.0f, 0.0f,
-            3.0f, -6.0f, 3.0f, 0.0f,
-            -1.0f, 3.0f, -3.0f, 1.0f);
-
-        mControlPoints = std::vector<Point>
-        {
-            { -30, 0, 0 },
-            { 0, 4, -30 },
-            { 30, 8, 0 },
-            { 0, 12, 30 }
-        };
-
-        std::vector<Point> splinePoints;
+        int resolution = mCurve.getResolution();
+        std::pmr::vector<Point> splinePoints(frameMemory);
+        splinePoints.reserve(resolution);
 
-        float scale = 1.0f / mResolution;
-        for (int res = 0; res < mResolution; ++res)
+        float scale = 1.0f / resolution;
+        for (int res = 0; res < resolution; ++res)
         {
-            auto pt = evaluateSpline(scale * res);
+            auto pt = mCurve.evaluateSpline(scale * res);
             splinePoints.push_back(pt);
         }
 
-        generateArcLengthTable();
+        auto const& controlPoints = mCurve.getControlPoints();
+        for (auto const& point : controlPoints)
+        {
+            mCurveCentre += point;
+        }
+        mCurveCentre *= 1.0f / controlPoints.size();
 
         mControlVao.bindVertexArray();
         mControlBuffer.bindBuffer();
-        mControlBuffer.bufferData(gl::size<Point>(mControlPoints.size()),
-            mControlPoints.data(), GL_STATIC_DRAW);
+        mControlBuffer.bufferData(gl::size<Point>(controlPoints.size()),
+            controlPoints.data(), GL_STATIC_DRAW);
         mControlBuffer.vertexAttribPointer(VERTICES_LAYOUT_LOCATION, 3, GL_FLOAT,
             GL_FALSE, 0, gl::bufferOffset<float>(0));
         mControlVao.enableVertexAttribArray(VERTICES_LAYOUT_LOCATION);
@@ -65,8 +107,12 @@ namespace bns
 
         mSplineVao.bindVertexArray();
         mSplineBuffer.bindBuffer();
-        mSplineBuffer.bufferData(gl::size<Point>(splinePoints.size()),
-            splinePoints.data(), GL_STATIC_DRAW);
+        // The uniform samples come first, then one range per tessellation
+        // slot.
+        mSplineBuffer.bufferData(gl::size<Point>(splinePoints.size() +
+            TessellationSlotCount * SlotCapacity), nullptr, GL_DYNAMIC_DRAW);
+        mSplineBuffer.bufferSubData(0, gl::size<Point>(splinePoints.size()),
+            splinePoints.data());
         mSplineBuffer.vertexAttribPointer(VERTICES_LAYOUT_LOCATION, 3, GL_FLOAT,
             GL_FALSE, 0, gl::bufferOffset<float>(0));
         mSplineVao.enableVertexAttribArray(VERTICES_LAYOUT_LOCATION);
@@ -136,17 +182,28 @@ namespace bns
         if (mShowControlPoints)
         {
             glPointSize(5.0f);
-            glDrawArrays(GL_POINTS, 0, GLsizei(mControlPoints.size()));
+            glDrawArrays(GL_POINTS, 0,
+                GLsizei(mCurve.getControlPoints().size()));
             glPointSize(1.0f);
         }
 
         if (mShowCage)
         {
-            glDrawArrays(GL_LINE_STRIP, 0, GLsizei(mControlPoints.size()));
+            glDrawArrays(GL_LINE_STRIP, 0,
+                GLsizei(mCurve.getControlPoints().size()));
         }
 
         mControlVao.unBindVertexArray();
 
+        GLint first = 0;
+        GLsizei count = mCurve.getResolution();
+        if (mAdaptive && (mShowSpline || mShowSplinePoints))
+        {
+            TessellationSlot const& slot = tessellateForView(projection, view);
+            first = getSlotFirst(slot);
+            count = slot.count;
+        }
+
         mSplineVao.bindVertexArray();
 
         // Now draw the splines.
@@ -154,12 +211,12 @@ namespace bns
 
         if (mShowSpline)
         {
-            glDrawArrays(GL_LINE_STRIP, 0, mResolution);
+            glDrawArrays(GL_LINE_STRIP, first, count);
         }
         if (mShowSplinePoints)
         {
             glPointSize(8.0f);
-            glDrawArrays(GL_POINTS, 0, mResolution);
+            glDrawArrays(GL_POINTS, first, count);
             glPointSize(1.0f);
         }
 
@@ -176,6 +233,23 @@ namespace bns
         ImGui::Checkbox("Show Cage", &mShowCage);
         ImGui::Checkbox("Show Spline", &mShowSpline);
         ImGui::Checkbox("Show Spline Points", &mShowSplinePoints);
+        ImGui::Checkbox("Adaptive Tessellation", &mAdaptive);
+        if (mAdaptive)
+        {
+            for (std::size_t i = 0; i < TessellationSlotCount; ++i)
+            {
+                if (mSlots[i].count > 0)
+                {
+                    ImGui::Text("View %d: %d vertices", int(i),
+                        int(mSlots[i].count));
+                }
+            }
+            ImGui::Text("Tessellations: %d", mRefineCount);
+        }
+        else
+        {
+            ImGui::Text("Uniform: %d vertices", mCurve.getResolution());
+        }
         ImGui::End();
     }
 
@@ -186,6 +260,23 @@ namespace bns
         mSplinePosition = interpolateOnSpline();
     }
 
+    void Spline::setFrame(int frame)
+    {
+        mCurrentFrame = std::max(0, std::min(frame, mTotalFrames - 1));
+        mIsInterpolationDone = false;
+        mSplinePosition = interpolateOnSpline();
+    }
+
+    void Spline::setAdaptive(bool enabled)
+    {
+        mAdaptive = enabled;
+    }
+
+    bool Spline::getAdaptive() const
+    {
+        return mAdaptive;
+    }
+
     atlas::math::Point Spline::getPosition() const
     {
         return mSplinePosition;
@@ -198,94 +289,96 @@ namespace bns
 
     atlas::math::Point Spline::interpolateOnSpline() const
     {
-        float totalDistance = mTable[mTable.size() - 1];
+        float totalDistance = mCurve.getLength();
         float step = totalDistance / mTotalFrames;
         float currDistance = step * mCurrentFrame;
 
-        int index = tableLookUp(currDistance);
-        float t = (1.0f / mResolution) * (index % mResolution);
-        return evaluateSpline(t);
+        int resolution = mCurve.getResolution();
+        int index = mCurve.tableLookUp(currDistance);
+        float t = (1.0f / resolution) * (index % resolution);
+        return mCurve.evaluateSpline(t);
     }
 
-    atlas::math::Point Spline::evaluateSpline(float t) const
-    {
-
-        using atlas::math::Vector4;
-        using atlas::math::Point;
-
-        Vector4 tVec = Vector4(1.0, t, t*t, t*t*t);
-
-        //find x-, y-,  & z-coords for control points
-        Vector4 x = {mControlPoints[0].x, mControlPoints[1].x, mControlPoints[2].x, mControlPoints[3].x};
-        Vector4 y = {mControlPoints[0].y, mControlPoints[1].y, mControlPoints[2].y, mControlPoints[3].y};
-        Vector4 z = {mControlPoints[0].z, mControlPoints[1].z, mControlPoints[2].z, mControlPoints[3].z};
-
-        //evaluate first half of point eqn: point(t) = [x,y,z]*B
-        auto xt = x * mBasisMatrix;
-        auto yt = y * mBasisMatrix;
-        auto zt = z * mBasisMatrix;
-
-        //evaluate result * tVec
-        float xcr = tVec[0]*xt[0] + tVec[1]*xt[1] + tVec[2]*xt[2] + tVec[3]*xt[3];
-        float ycr = tVec[0]*yt[0] + tVec[1]*yt[1] + tVec[2]*yt[2] + tVec[3]*yt[3];
-        float zcr = tVec[0]*zt[0] + tVec[1]*zt[1] + tVec[2]*zt[2] + tVec[3]*zt[3];
-
-        return Point(xcr,ycr,zcr);
-    }
-
-    void Spline::generateArcLengthTable()
+    Spline::TessellationSlot const& Spline::tessellateForView(
+        atlas::math::Matrix4 const& projection,
+        atlas::math::Matrix4 const& view)
     {
-        using atlas::math::Point;
-
-        if (!mTable.empty())
-        {
-            mTable.clear();
-        }
-
-        float scale = 1.0f/mResolution;
+        namespace math = atlas::math;
 
-        mTable.push_back(0.0f);
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        float width = static_cast<float>(viewport[2]);
+        float height = static_cast<float>(viewport[3]);
 
-        for (int i = 1; i < mResolution + 1; ++i)
+        // The camera in the curve's own space. Views here are rigid, so the
+        // inverse rotation is the transpose.
+        math::Matrix4 modelView = view * mModel;
+        math::Point eye(0.0f);
+        for (int i = 0; i < 3; ++i)
         {
-            //find points on spline at [i-1] and [i]
-            Point p0 = evaluateSpline((i-1)*scale);
-            Point p1 = evaluateSpline(i*scale);
-
-            //push next distance (between p0 & p1) into mTable
-            mTable.push_back(mTable[i-1] + glm::distance(p0, p1));
+            eye[i] = -(modelView[i][0] * modelView[3][0] +
+                modelView[i][1] * modelView[3][1] +
+                modelView[i][2] * modelView[3][2]);
         }
-}
+        math::Vector look(-modelView[0][2], -modelView[1][2],
+            -modelView[2][2]);
 
-    int Spline::tableLookUp(float distance) const
-    {
-        float epsilon = chooseEpsilon();
-        for (std::size_t i = 0; i < mTable.size(); ++i)
+        ++mDrawCount;
+        TessellationSlot* reuse = nullptr;
+        for (auto& slot : mSlots)
         {
-            if (glm::abs(mTable[i] - distance) < epsilon)
+            if (slot.count == 0 || slot.viewportWidth != width ||
+                slot.viewportHeight != height ||
+                !sameProjection(slot.projection, projection))
+            {
+                continue;
+            }
+            float tolerance = RefreshDistance *
+                glm::length(slot.eye - mCurveCentre);
+            if (glm::length(eye - slot.eye) <= tolerance &&
+                glm::dot(look, slot.look) >= RefreshCosine)
             {
-                return static_cast<int>(i);
+                reuse = &slot;
+                break;
             }
         }
-
-        return -1;
-    }
-
-    float Spline::chooseEpsilon() const
-    {
-        float epsilon = 0.0f;
-        float diff;
-
-        for (std::size_t i = 0; i < mTable.size() - 1; ++i)
+        if (reuse != nullptr)
         {
-            diff = glm::abs(mTable[i] - mTable[i + 1]);
-                if (diff > epsilon)
-                {
-                    epsilon = diff;
-                }
+            reuse->lastUsed = mDrawCount;
+            return *reuse;
         }
 
-        return epsilon;
+        // Otherwise replace the slot that has gone unused the longest.
+        TessellationSlot& slot = *std::min_element(mSlots.begin(),
+            mSlots.end(), [](TessellationSlot const& a,
+                TessellationSlot const& b)
+        {
+            return a.lastUsed < b.lastUsed;
+        });
+
+        mCurve.tessellate(projection * modelView, width, height,
+            PixelTolerance, TessellationSegments, mTessellation);
+        slot.projection = projection;
+        slot.eye = eye;
+        slot.look = look;
+        slot.viewportWidth = width;
+        slot.viewportHeight = height;
+        slot.count = std::min(static_cast<GLsizei>(mTessellation.size()),
+            SlotCapacity);
+        slot.lastUsed = mDrawCount;
+        ++mRefineCount;
+
+        namespace gl = atlas::gl;
+        mSplineBuffer.bindBuffer();
+        mSplineBuffer.bufferSubData(gl::size<math::Point>(getSlotFirst(slot)),
+            gl::size<math::Point>(slot.count), mTessellation.data());
+        mSplineBuffer.unBindBuffer();
+        return slot;
     }
 
+    GLint Spline::getSlotFirst(TessellationSlot const& slot) const
+    {
+        auto index = static_cast<GLint>(&slot - mSlots.data());
+        return mCurve.getResolution() + index * SlotCapacity;
+    }
 }
@@ -0,0 +1,224 @@
+#include "SplineCurve.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bns
+{
+    namespace
+    {
+        // A span turning by more than this is split while it covers more
+        // than MinFacetPixels on screen, so bends stay round even where the
+        // chord error is small.
+        constexpr float MaxTurnRadians = 0.1f;
+        constexpr float MinFacetPixels = 2.0f;
+        // Clip w below this counts as behind the camera.
+        constexpr float MinClipW = 1e-4f;
+
+        float distanceToSegment(float px, float py, float ax, float ay,
+            float bx, float by)
+        {
+            float dx = bx - ax;
+            float dy = by - ay;
+            float length2 = dx * dx + dy * dy;
+            float t = (length2 > 0.0f) ?
+                std::min(std::max(((px - ax) * dx + (py - ay) * dy) /
+                    length2, 0.0f), 1.0f) : 0.0f;
+            float ex = ax + dx * t - px;
+            float ey = ay + dy * t - py;
+            return std::sqrt(ex * ex + ey * ey);
+        }
+    }
+
+    SplineCurve::SplineCurve(
+        std::vector<atlas::math::Point> const& controlPoints,
+        int resolution) :
+        mBasisMatrix(
+            1.0f, 0.0f, 0.0f, 0.0f,
+            -3.0f, 3.0f, 0.0f, 0.0f,
+            3.0f, -6.0f, 3.0f, 0.0f,
+            -1.0f, 3.0f, -3.0f, 1.0f),
+        mControlPoints(controlPoints),
+        mResolution(resolution)
+    {
+        generateArcLengthTable();
+    }
+
+    atlas::math::Point SplineCurve::evaluateSpline(float t) const
+    {
+
+        using atlas::math::Vector4;
+        using atlas::math::Point;
+
+        Vector4 tVec = Vector4(1.0, t, t*t, t*t*t);
+
+        //find x-, y-,  & z-coords for control points
+        Vector4 x = {mControlPoints[0].x, mControlPoints[1].x, mControlPoints[2].x, mControlPoints[3].x};
+        Vector4 y = {mControlPoints[0].y, mControlPoints[1].y, mControlPoints[2].y, mControlPoints[3].y};
+        Vector4 z = {mControlPoints[0].z, mControlPoints[1].z, mControlPoints[2].z, mControlPoints[3].z};
+
+        //evaluate first half of point eqn: point(t) = [x,y,z]*B
+        auto xt = x * mBasisMatrix;
+        auto yt = y * mBasisMatrix;
+        auto zt = z * mBasisMatrix;
+
+        //evaluate result * tVec
+        float xcr = tVec[0]*xt[0] + tVec[1]*xt[1] + tVec[2]*xt[2] + tVec[3]*xt[3];
+        float ycr = tVec[0]*yt[0] + tVec[1]*yt[1] + tVec[2]*yt[2] + tVec[3]*yt[3];
+        float zcr = tVec[0]*zt[0] + tVec[1]*zt[1] + tVec[2]*zt[2] + tVec[3]*zt[3];
+
+        return Point(xcr,ycr,zcr);
+    }
+
+    void SplineCurve::generateArcLengthTable()
+    {
+        using atlas::math::Point;
+
+        if (!mTable.empty())
+        {
+            mTable.clear();
+        }
+
+        float scale = 1.0f/mResolution;
+
+        mTable.push_back(0.0f);
+
+        for (int i = 1; i < mResolution + 1; ++i)
+        {
+            //find points on spline at [i-1] and [i]
+            Point p0 = evaluateSpline((i-1)*scale);
+            Point p1 = evaluateSpline(i*scale);
+
+            //push next distance (between p0 & p1) into mTable
+            mTable.push_back(mTable[i-1] + glm::distance(p0, p1));
+        }
+}
+
+    int SplineCurve::tableLookUp(float distance) const
+    {
+        float epsilon = chooseEpsilon();
+        for (std::size_t i = 0; i < mTable.size(); ++i)
+        {
+            if (glm::abs(mTable[i] - distance) < epsilon)
+            {
+                return static_cast<int>(i);
+            }
+        }
+
+        return -1;
+    }
+
+    void SplineCurve::tessellate(atlas::math::Matrix4 const& clip,
+        float viewportWidth, float viewportHeight, float pixelTolerance,
+        int segments, std::vector<atlas::math::Point>& points) const
+    {
+        float halfWidth = 0.5f * viewportWidth;
+        float halfHeight = 0.5f * viewportHeight;
+        auto project = [&](float t)
+        {
+            ScreenPoint p;
+            p.world = evaluateSpline(t);
+            atlas::math::Vector4 c = clip * atlas::math::Vector4(p.world, 1.0f);
+            p.visible = c.w > MinClipW;
+            p.x = p.visible ? c.x / c.w * halfWidth : 0.0f;
+            p.y = p.visible ? c.y / c.w * halfHeight : 0.0f;
+            return p;
+        };
+
+        segments = std::max(segments, 1);
+        points.clear();
+        ScreenPoint start = project(0.0f);
+        points.push_back(start.world);
+        for (int i = 0; i < segments; ++i)
+        {
+            float t0 = static_cast<float>(i) / segments;
+            float t1 = static_cast<float>(i + 1) / segments;
+            ScreenPoint end = project(t1);
+            refine(t0, start, t1, end, 0, clip, halfWidth, halfHeight,
+                pixelTolerance, points);
+            start = end;
+        }
+    }
+
+    void SplineCurve::refine(float t0, ScreenPoint const& p0, float t1,
+        ScreenPoint const& p1, int depth, atlas::math::Matrix4 const& clip,
+        float halfWidth, float halfHeight, float pixelTolerance,
+        std::vector<atlas::math::Point>& points) const
+    {
+        float tm = 0.5f * (t0 + t1);
+        ScreenPoint pm;
+        pm.world = evaluateSpline(tm);
+        atlas::math::Vector4 c = clip * atlas::math::Vector4(pm.world, 1.0f);
+        pm.visible = c.w > MinClipW;
+        pm.x = pm.visible ? c.x / c.w * halfWidth : 0.0f;
+        pm.y = pm.visible ? c.y / c.w * halfHeight : 0.0f;
+
+        bool split = false;
+        if (depth < MaxTessellationDepth)
+        {
+            atlas::math::Vector a = pm.world - p0.world;
+            atlas::math::Vector b = p1.world - pm.world;
+            float lengths = glm::length(a) * glm::length(b);
+            float turn = (lengths > 0.0f) ? std::acos(std::min(std::max(
+                glm::dot(a, b) / lengths, -1.0f), 1.0f)) : 0.0f;
+
+            if (p0.visible && pm.visible && p1.visible)
+            {
+                float chord = std::hypot(p1.x - p0.x, p1.y - p0.y);
+                split = distanceToSegment(pm.x, pm.y, p0.x, p0.y, p1.x,
+                    p1.y) > pixelTolerance ||
+                    (turn > MaxTurnRadians && chord > MinFacetPixels);
+            }
+            else
+            {
+                split = turn > MaxTurnRadians;
+            }
+        }
+
+        if (split)
+        {
+            refine(t0, p0, tm, pm, depth + 1, clip, halfWidth, halfHeight,
+                pixelTolerance, points);
+            refine(tm, pm, t1, p1, depth + 1, clip, halfWidth, halfHeight,
+                pixelTolerance, points);
+        }
+        else
+        {
+            points.push_back(p1.world);
+        }
+    }
+
+    float SplineCurve::getLength() const
+    {
+        return mTable[mTable.size() - 1];
+    }
+
+    int SplineCurve::getResolution() const
+    {
+        return mResolution;
+    }
+
+    std::vector<atlas::math::Point> const&
+        SplineCurve::getControlPoints() const
+    {
+        return mControlPoints;
+    }
+
+    float SplineCurve::chooseEpsilon() const
+    {
+        float epsilon = 0.0f;
+        float diff;
+
+        for (std::size_t i = 0; i < mTable.size() - 1; ++i)
+        {
+            diff = glm::abs(mTable[i] - mTable[i + 1]);
+                if (diff > epsilon)
+                {
+                    epsilon = diff;
+                }
+        }
+
+        return epsilon;
+    }
+
+}
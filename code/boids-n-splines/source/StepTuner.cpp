@@ -0,0 +1,223 @@
+#include "StepTuner.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace bns
+{
+    namespace
+    {
+        // Steps timed per candidate. The first one pays for the switch
+        // (new threads, a neighbour list rebuild) and is not scored; the
+        // rest are long enough to average over the list rebuilds a skin
+        // causes.
+        constexpr std::size_t SamplesPerCandidate = 16;
+
+        constexpr float SkinFractions[] = { 0.1f, 0.2f, 0.3f, 0.5f, 0.8f };
+        constexpr int PartCounts[] = { 1, 2, 4, 8 };
+
+        // Steps averaged into the density the settings were locked in
+        // with, how quickly the running density follows the flock, and how
+        // far it may drift either way before the search restarts.
+        constexpr std::size_t DensitySamples = 16;
+        constexpr float DensitySmoothing = 0.05f;
+        constexpr float DensityDrift = 1.5f;
+    }
+
+    StepTuner::StepTuner() :
+        mKnob(Knob::Done),
+        mCandidate(0),
+        mSamples(0),
+        mTotal(0.0),
+        mBestTotal(0.0),
+        mBestCandidate(0),
+        mBest{ 0.0f, 1, 1 },
+        mSettings{ 0.0f, 1, 1 },
+        mQueryRadius(0.0f),
+        mHardwareThreads(1),
+        mMilliseconds(0.0f),
+        mRetunes(0),
+        mDensity(0.0f),
+        mLockedDensity(0.0f),
+        mLockedSamples(0)
+    { }
+
+    void StepTuner::start(TunedSettings const& initial, float queryRadius,
+        unsigned hardwareThreads)
+    {
+        mBest = initial;
+        mSettings = initial;
+        mQueryRadius = queryRadius;
+        mHardwareThreads = std::max(hardwareThreads, 1u);
+        mMilliseconds = 0.0f;
+        mRetunes = 0;
+        beginKnob(Knob::Threads);
+    }
+
+    bool StepTuner::isStarted() const
+    {
+        return mQueryRadius > 0.0f;
+    }
+
+    bool StepTuner::isLocked() const
+    {
+        return mKnob == Knob::Done;
+    }
+
+    TunedSettings const& StepTuner::getSettings() const
+    {
+        return mSettings;
+    }
+
+    TunerStatus StepTuner::getStatus() const
+    {
+        return { isLocked(), mSettings, mCandidate, mCandidates.size(),
+            mMilliseconds, mRetunes };
+    }
+
+    void StepTuner::record(double milliseconds, float density)
+    {
+        if (mKnob == Knob::Done)
+        {
+            if (mLockedSamples < DensitySamples)
+            {
+                mLockedSamples++;
+                mLockedDensity += (density - mLockedDensity) / mLockedSamples;
+                mDensity = mLockedDensity;
+                return;
+            }
+
+            mDensity += (density - mDensity) * DensitySmoothing;
+            float ratio = (mLockedDensity > 0.0f) ?
+                mDensity / mLockedDensity : 1.0f;
+            if (ratio > DensityDrift || ratio < 1.0f / DensityDrift)
+            {
+                INFO_LOG_V("Neighbour density went from %.1f to %.1f, "
+                    "re-tuning", mLockedDensity, mDensity);
+                mRetunes++;
+                beginKnob(Knob::Threads);
+            }
+            return;
+        }
+
+        if (mSamples++ > 0)
+        {
+            mTotal += milliseconds;
+        }
+        if (mSamples < SamplesPerCandidate)
+        {
+            return;
+        }
+
+        if (mTotal < mBestTotal)
+        {
+            mBestTotal = mTotal;
+            mBestCandidate = mCandidate;
+        }
+        if (++mCandidate < mCandidates.size())
+        {
+            applyCandidate();
+            return;
+        }
+
+        // Settle this knob on its fastest candidate and go on to the next.
+        mCandidate = mBestCandidate;
+        applyCandidate();
+        mBest = mSettings;
+        mMilliseconds = static_cast<float>(
+            mBestTotal / (SamplesPerCandidate - 1));
+        beginKnob(static_cast<Knob>(static_cast<int>(mKnob) + 1));
+    }
+
+    void StepTuner::beginKnob(Knob knob)
+    {
+        mKnob = knob;
+        mCandidates.clear();
+        switch (knob)
+        {
+        case Knob::Threads:
+            for (unsigned count = 1; count < mHardwareThreads; count *= 2)
+            {
+                mCandidates.push_back(static_cast<float>(count));
+            }
+            mCandidates.push_back(static_cast<float>(mHardwareThreads));
+            break;
+
+        case Knob::Parts:
+            // Parts only matter once the work is split at all.
+            if (mBest.threadCount > 1)
+            {
+                mCandidates.assign(std::begin(PartCounts),
+                    std::end(PartCounts));
+            }
+            break;
+
+        case Knob::Skin:
+            for (float fraction : SkinFractions)
+            {
+                mCandidates.push_back(fraction * mQueryRadius);
+            }
+            break;
+
+        case Knob::Done:
+            lock();
+            return;
+        }
+
+        // A knob with nothing to choose from costs no steps.
+        if (mCandidates.size() <= 1)
+        {
+            mCandidate = 0;
+            if (!mCandidates.empty())
+            {
+                applyCandidate();
+                mBest = mSettings;
+            }
+            beginKnob(static_cast<Knob>(static_cast<int>(knob) + 1));
+            return;
+        }
+
+        mCandidate = 0;
+        mBestCandidate = 0;
+        mBestTotal = std::numeric_limits<double>::max();
+        applyCandidate();
+    }
+
+    void StepTuner::applyCandidate()
+    {
+        mSettings = mBest;
+        float value = mCandidates[mCandidate];
+        switch (mKnob)
+        {
+        case Knob::Threads:
+            mSettings.threadCount = static_cast<int>(value);
+            break;
+        case Knob::Parts:
+            mSettings.partsPerThread = static_cast<int>(value);
+            break;
+        case Knob::Skin:
+            mSettings.neighbourSkin = value;
+            break;
+        case Knob::Done:
+            break;
+        }
+        mSamples = 0;
+        mTotal = 0.0;
+    }
+
+    void StepTuner::lock()
+    {
+        mSettings = mBest;
+        mCandidates.clear();
+        mCandidate = 0;
+        mLockedDensity = 0.0f;
+        mLockedSamples = 0;
+
+        // Enough to pin the same settings by hand on a later run.
+        INFO_LOG_V("Auto-tune locked in neighbourSkin=%g threadCount=%d "
+            "partsPerThread=%d (%.3f ms/step)", mSettings.neighbourSkin,
+            mSettings.threadCount, mSettings.partsPerThread, mMilliseconds);
+    }
+}
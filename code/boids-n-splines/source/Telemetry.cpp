@@ -0,0 +1,181 @@
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace bns
+{
+    namespace
+    {
+        void appendValue(std::string& out, double value)
+        {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.9g", value);
+            out += text;
+        }
+
+        void appendValue(std::string& out, std::uint64_t value)
+        {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%" PRIu64, value);
+            out += text;
+        }
+    }
+
+    Metric::Metric(std::string const& name, std::string const& help) :
+        mName(name),
+        mHelp(help)
+    { }
+
+    void Metric::writeHeader(std::string& out, char const* type) const
+    {
+        out += "# HELP " + mName + " " + mHelp + "\n";
+        out += "# TYPE " + mName + " " + type + "\n";
+    }
+
+    Counter::Counter(std::string const& name, std::string const& help) :
+        Metric(name, help),
+        mValue(0)
+    { }
+
+    std::uint64_t Counter::get() const
+    {
+        return mValue.load(std::memory_order_relaxed);
+    }
+
+    void Counter::write(std::string& out) const
+    {
+        writeHeader(out, "counter");
+        out += mName + " ";
+        appendValue(out, get());
+        out += "\n";
+    }
+
+    Gauge::Gauge(std::string const& name, std::string const& help) :
+        Metric(name, help),
+        mValue(0.0)
+    { }
+
+    double Gauge::get() const
+    {
+        return mValue.load(std::memory_order_relaxed);
+    }
+
+    void Gauge::write(std::string& out) const
+    {
+        writeHeader(out, "gauge");
+        out += mName + " ";
+        appendValue(out, get());
+        out += "\n";
+    }
+
+    Histogram::Histogram(std::string const& name, std::string const& help,
+        std::vector<double> const& bounds) :
+        Metric(name, help),
+        mBounds(bounds),
+        mCounts(new std::atomic<std::uint64_t>[bounds.size() + 1]),
+        mSum(0.0)
+    {
+        std::sort(mBounds.begin(), mBounds.end());
+        for (std::size_t i = 0; i <= mBounds.size(); ++i)
+        {
+            mCounts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Histogram::observe(double value)
+    {
+        std::size_t bucket = static_cast<std::size_t>(std::lower_bound(
+            mBounds.begin(), mBounds.end(), value) - mBounds.begin());
+        mCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+
+        // No fetch_add for doubles before C++20.
+        double sum = mSum.load(std::memory_order_relaxed);
+        while (!mSum.compare_exchange_weak(sum, sum + value,
+            std::memory_order_relaxed))
+        { }
+    }
+
+    void Histogram::write(std::string& out) const
+    {
+        writeHeader(out, "histogram");
+
+        // Buckets are cumulative; the total is taken from the same reads so
+        // a scrape is consistent even while observations come in.
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i <= mBounds.size(); ++i)
+        {
+            total += mCounts[i].load(std::memory_order_relaxed);
+            out += mName + "_bucket{le=\"";
+            if (i < mBounds.size())
+            {
+                appendValue(out, mBounds[i]);
+            }
+            else
+            {
+                out += "+Inf";
+            }
+            out += "\"} ";
+            appendValue(out, total);
+            out += "\n";
+        }
+
+        out += mName + "_sum ";
+        appendValue(out, mSum.load(std::memory_order_relaxed));
+        out += "\n" + mName + "_count ";
+        appendValue(out, total);
+        out += "\n";
+    }
+
+    std::vector<double> exponentialBuckets(double start, double factor,
+        int count)
+    {
+        std::vector<double> bounds;
+        bounds.reserve(static_cast<std::size_t>(std::max(count, 0)));
+        for (int i = 0; i < count; ++i)
+        {
+            bounds.push_back(start);
+            start *= factor;
+        }
+        return bounds;
+    }
+
+    Counter& MetricsRegistry::addCounter(std::string const& name,
+        std::string const& help)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Counter* counter = new Counter(name, help);
+        mMetrics.emplace_back(counter);
+        return *counter;
+    }
+
+    Gauge& MetricsRegistry::addGauge(std::string const& name,
+        std::string const& help)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Gauge* gauge = new Gauge(name, help);
+        mMetrics.emplace_back(gauge);
+        return *gauge;
+    }
+
+    Histogram& MetricsRegistry::addHistogram(std::string const& name,
+        std::string const& help, std::vector<double> const& bounds)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Histogram* histogram = new Histogram(name, help, bounds);
+        mMetrics.emplace_back(histogram);
+        return *histogram;
+    }
+
+    std::string MetricsRegistry::render() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::string out;
+        for (auto const& metric : mMetrics)
+        {
+            metric->write(out);
+        }
+        return out;
+    }
+}
@@ -0,0 +1,126 @@
+#include "TelemetryServer.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <cstring>
+#include <string>
+
+namespace bns
+{
+    namespace
+    {
+        // How often the serving thread checks for stop(), and how long a
+        // client may take to send its request.
+        constexpr int AcceptTimeoutMilliseconds = 100;
+        constexpr int RequestTimeoutMilliseconds = 1000;
+        constexpr std::size_t MaxRequestSize = 8192;
+
+        std::string makeResponse(char const* status, char const* type,
+            std::string const& body)
+        {
+            std::string response = "HTTP/1.0 ";
+            response += status;
+            response += "\r\nContent-Type: ";
+            response += type;
+            response += "\r\nContent-Length: " + std::to_string(body.size()) +
+                "\r\nConnection: close\r\n\r\n";
+            response += body;
+            return response;
+        }
+    }
+
+    TelemetryServer::TelemetryServer(MetricsRegistry const& registry) :
+        mRegistry(registry),
+        mStopRequested(false),
+        mScrapes(0)
+    { }
+
+    TelemetryServer::~TelemetryServer()
+    {
+        stop();
+    }
+
+    bool TelemetryServer::start(Address const& address)
+    {
+        stop();
+        if (!mListener.listen(address))
+        {
+            return false;
+        }
+
+        INFO_LOG_V("Serving metrics on %s", formatAddress(address).c_str());
+        mStopRequested = false;
+        mThread = std::thread(&TelemetryServer::run, this);
+        return true;
+    }
+
+    void TelemetryServer::stop()
+    {
+        if (!mThread.joinable())
+        {
+            return;
+        }
+
+        mStopRequested = true;
+        mThread.join();
+        mListener.close();
+    }
+
+    bool TelemetryServer::isRunning() const
+    {
+        return mThread.joinable();
+    }
+
+    std::uint64_t TelemetryServer::getScrapeCount() const
+    {
+        return mScrapes;
+    }
+
+    void TelemetryServer::run()
+    {
+        while (!mStopRequested)
+        {
+            Connection connection =
+                mListener.accept(AcceptTimeoutMilliseconds);
+            if (connection.isOpen())
+            {
+                serve(connection);
+            }
+        }
+    }
+
+    void TelemetryServer::serve(Connection& connection)
+    {
+        // Only the request line matters, but read up to the end of the
+        // headers so the client sees its whole request consumed.
+        connection.setReceiveTimeout(RequestTimeoutMilliseconds);
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos &&
+            request.size() < MaxRequestSize)
+        {
+            std::size_t received = connection.receiveSome(buffer,
+                sizeof(buffer));
+            if (received == 0)
+            {
+                break;
+            }
+            request.append(buffer, received);
+        }
+
+        std::string response;
+        if (request.compare(0, 4, "GET ") == 0)
+        {
+            mScrapes++;
+            response = makeResponse("200 OK",
+                "text/plain; version=0.0.4; charset=utf-8",
+                mRegistry.render());
+        }
+        else
+        {
+            response = makeResponse("405 Method Not Allowed", "text/plain",
+                "Only GET is supported.\n");
+        }
+        connection.sendBytes(response.data(), response.size());
+    }
+}
@@ -0,0 +1,223 @@
+#include "TextureCache.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace bns
+{
+    namespace
+    {
+        // Mid grey, so untextured bodies still shade sensibly.
+        constexpr std::uint8_t Placeholder[4] = { 128, 128, 128, 255 };
+    }
+
+    TextureCache::TextureCache(unsigned threadCount,
+        std::string const& cacheDirectory) :
+        mCacheDirectory(cacheDirectory),
+        mPendingCount(0),
+        mUnpackBuffer(0),
+        mCacheHits(0),
+        mStopRequested(false)
+    {
+        glGenBuffers(1, &mUnpackBuffer);
+
+        threadCount = std::max(threadCount, 1u);
+        for (unsigned i = 0; i < threadCount; ++i)
+        {
+            mWorkers.emplace_back(&TextureCache::run, this);
+        }
+    }
+
+    TextureCache::~TextureCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopRequested = true;
+        }
+        mCondition.notify_all();
+        for (std::thread& worker : mWorkers)
+        {
+            worker.join();
+        }
+
+        for (Entry const& entry : mEntries)
+        {
+            glDeleteTextures(1, &entry.texture);
+        }
+        glDeleteBuffers(1, &mUnpackBuffer);
+    }
+
+    GLuint TextureCache::acquire(std::string const& path)
+    {
+        auto it = mByPath.find(path);
+        if (it != mByPath.end())
+        {
+            return mEntries[it->second].texture;
+        }
+
+        Entry entry{ path, 0, State::Pending };
+        glGenTextures(1, &entry.texture);
+        glBindTexture(GL_TEXTURE_2D, entry.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA,
+            GL_UNSIGNED_BYTE, Placeholder);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        std::size_t index = mEntries.size();
+        mEntries.push_back(entry);
+        mByPath.emplace(path, index);
+        mPendingCount++;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mRequests.push_back({ index, path });
+        }
+        mCondition.notify_one();
+        return entry.texture;
+    }
+
+    void TextureCache::update(std::size_t byteBudget)
+    {
+        std::size_t uploaded = 0;
+        while (uploaded < byteBudget)
+        {
+            Decoded decoded;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mDecoded.empty())
+                {
+                    return;
+                }
+                decoded = std::move(mDecoded.front());
+                mDecoded.pop_front();
+            }
+
+            Entry& entry = mEntries[decoded.entry];
+            mPendingCount--;
+            if (!decoded.valid)
+            {
+                ERROR_LOG_V("Could not load texture %s", entry.path.c_str());
+                entry.state = State::Failed;
+                continue;
+            }
+
+            upload(entry, decoded.chain);
+            uploaded += decoded.chain.pixels.size();
+        }
+    }
+
+    bool TextureCache::isReady(std::string const& path) const
+    {
+        auto it = mByPath.find(path);
+        return it != mByPath.end() &&
+            mEntries[it->second].state == State::Ready;
+    }
+
+    std::size_t TextureCache::getTextureCount() const
+    {
+        return mEntries.size();
+    }
+
+    std::size_t TextureCache::getPendingCount() const
+    {
+        return mPendingCount;
+    }
+
+    std::size_t TextureCache::getCacheHits() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mCacheHits;
+    }
+
+    void TextureCache::run()
+    {
+        for (;;)
+        {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]
+                {
+                    return mStopRequested || !mRequests.empty();
+                });
+                if (mStopRequested)
+                {
+                    return;
+                }
+                request = std::move(mRequests.front());
+                mRequests.pop_front();
+            }
+
+            Decoded decoded{ request.entry, false, MipChain() };
+            std::string cachePath;
+            bool hit = false;
+            if (!mCacheDirectory.empty())
+            {
+                cachePath = getMipCachePath(mCacheDirectory, request.path);
+                hit = readMipCache(cachePath, decoded.chain);
+            }
+            decoded.valid = hit ||
+                decodeMipChain(request.path, decoded.chain);
+            if (decoded.valid && !hit && !cachePath.empty() &&
+                !writeMipCache(cachePath, decoded.chain))
+            {
+                ERROR_LOG_V("Could not write texture cache %s",
+                    cachePath.c_str());
+            }
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCacheHits += hit ? 1 : 0;
+            mDecoded.push_back(std::move(decoded));
+        }
+    }
+
+    void TextureCache::upload(Entry& entry, MipChain const& chain)
+    {
+        // Staged in a freshly orphaned unpack buffer: the driver can copy
+        // out of it into the texture asynchronously, without waiting on
+        // draws still reading last upload's storage.
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mUnpackBuffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER,
+            static_cast<GLsizeiptr>(chain.pixels.size()), nullptr,
+            GL_STREAM_DRAW);
+        void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+            static_cast<GLsizeiptr>(chain.pixels.size()),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (staging == nullptr)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            ERROR_LOG_V("Could not map upload buffer for %s",
+                entry.path.c_str());
+            entry.state = State::Failed;
+            return;
+        }
+        std::memcpy(staging, chain.pixels.data(), chain.pixels.size());
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // With an unpack buffer bound, the data pointer is an offset into
+        // it.
+        glBindTexture(GL_TEXTURE_2D, entry.texture);
+        for (std::size_t l = 0; l < chain.levels.size(); ++l)
+        {
+            MipChain::Level const& level = chain.levels[l];
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(l), GL_RGBA8,
+                level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                reinterpret_cast<void const*>(level.offset));
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+            static_cast<GLint>(chain.levels.size()) - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+            GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        entry.state = State::Ready;
+    }
+}
@@ -0,0 +1,114 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace bns
+{
+    ThreadPool::ThreadPool(unsigned threadCount) :
+        mTask(nullptr),
+        mTaskFunction(nullptr),
+        mTaskCount(0),
+        mNextTask(0),
+        mGeneration(0),
+        mBusyWorkers(0),
+        mStopping(false)
+    {
+        threadCount = std::max(threadCount, 1u);
+        for (unsigned i = 1; i < threadCount; ++i)
+        {
+            mThreads.emplace_back(&ThreadPool::work, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mWake.notify_all();
+        for (auto& thread : mThreads)
+        {
+            thread.join();
+        }
+    }
+
+    unsigned ThreadPool::getThreadCount() const
+    {
+        return static_cast<unsigned>(mThreads.size()) + 1;
+    }
+
+    void ThreadPool::dispatch(std::size_t taskCount, void const* task,
+        TaskFunction function)
+    {
+        if (mThreads.empty() || taskCount <= 1)
+        {
+            for (std::size_t i = 0; i < taskCount; ++i)
+            {
+                function(task, i, 0);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTask = task;
+            mTaskFunction = function;
+            mTaskCount = taskCount;
+            mNextTask = 0;
+            mBusyWorkers = static_cast<unsigned>(mThreads.size());
+            mGeneration++;
+        }
+        mWake.notify_all();
+
+        runTasks(0);
+
+        // Workers hold on to the task until they report back, so it has to
+        // outlive all of them, not just the last task index.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [this]() { return mBusyWorkers == 0; });
+        mTask = nullptr;
+        mTaskFunction = nullptr;
+    }
+
+    void ThreadPool::work(unsigned thread)
+    {
+        std::uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWake.wait(lock, [this, seen]()
+                {
+                    return mStopping || mGeneration != seen;
+                });
+                if (mStopping)
+                {
+                    return;
+                }
+                seen = mGeneration;
+            }
+
+            runTasks(thread);
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mBusyWorkers--;
+            }
+            mDone.notify_one();
+        }
+    }
+
+    void ThreadPool::runTasks(unsigned thread)
+    {
+        for (;;)
+        {
+            std::size_t index = mNextTask++;
+            if (index >= mTaskCount)
+            {
+                return;
+            }
+            mTaskFunction(mTask, index, thread);
+        }
+    }
+}
@@ -0,0 +1,239 @@
+#include "TrajectoryCodec.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace bns
+{
+    namespace
+    {
+        std::uint32_t zigzag(std::int32_t value)
+        {
+            return (static_cast<std::uint32_t>(value) << 1) ^
+                static_cast<std::uint32_t>(value >> 31);
+        }
+
+        std::int32_t unzigzag(std::uint32_t value)
+        {
+            return static_cast<std::int32_t>(value >> 1) ^
+                -static_cast<std::int32_t>(value & 1);
+        }
+
+        void writeVarint(std::uint32_t value, std::vector<std::uint8_t>& out)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<std::uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<std::uint8_t>(value));
+        }
+
+        bool readVarint(std::uint8_t const*& cursor, std::uint8_t const* end,
+            std::uint32_t& value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 35; shift += 7)
+            {
+                if (cursor == end)
+                {
+                    return false;
+                }
+
+                std::uint8_t byte = *cursor++;
+                value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    void quantiseBoid(atlas::math::Vector const& position,
+        atlas::math::Vector const& forward, atlas::math::Vector const& boundsMin,
+        atlas::math::Vector const& boundsExtent, std::size_t index,
+        QuantisedFrame& frame)
+    {
+        std::size_t const count = frame.size() / QuantisedComponents;
+        for (int c = 0; c < 3; ++c)
+        {
+            // A NaN gets through the clamps and std::lround of it is
+            // undefined, so non-finite components go to the middle of their
+            // range instead.
+            float t = (boundsExtent[c] > 0.0f) ?
+                (position[c] - boundsMin[c]) / boundsExtent[c] : 0.0f;
+            t = std::isfinite(t) ? std::min(std::max(t, 0.0f), 1.0f) : 0.5f;
+            frame[c * count + index] = static_cast<std::uint16_t>(
+                std::lround(t * 65535.0f));
+
+            float f = std::isfinite(forward[c]) ?
+                std::min(std::max(forward[c], -1.0f), 1.0f) : 0.0f;
+            frame[(c + 3) * count + index] = static_cast<std::uint16_t>(
+                static_cast<std::int16_t>(std::lround(f * 32767.0f)));
+        }
+    }
+
+    void dequantiseFrame(QuantisedFrame const& frame, std::size_t begin,
+        std::size_t end, atlas::math::Vector const& boundsMin,
+        atlas::math::Vector const& boundsExtent, std::vector<Boid>& boids)
+    {
+        std::size_t const count = boids.size();
+        atlas::math::Vector const scale = boundsExtent / 65535.0f;
+        for (int c = 0; c < 3; ++c)
+        {
+            std::uint16_t const* positions = frame.data() + c * count;
+            std::uint16_t const* forwards = frame.data() + (c + 3) * count;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                boids[i].mPosition[c] = boundsMin[c] + scale[c] * positions[i];
+                boids[i].mForward[c] =
+                    static_cast<std::int16_t>(forwards[i]) / 32767.0f;
+            }
+        }
+    }
+
+    void encodeFrame(QuantisedFrame const& previous,
+        QuantisedFrame const& current, std::vector<std::uint8_t>& out)
+    {
+        std::size_t const count = current.size() / QuantisedComponents;
+        std::size_t const tableOffset = out.size();
+        out.resize(out.size() + QuantisedComponents * sizeof(std::uint32_t));
+
+        for (std::size_t c = 0; c < QuantisedComponents; ++c)
+        {
+            std::size_t const planeStart = out.size();
+
+            // A non-zero varint never contains a zero byte, so every zero in
+            // the stream is a zero delta; runs of them collapse to a 0x00
+            // marker followed by the run length minus one.
+            std::uint32_t zeroRun = 0;
+            auto flushZeros = [&zeroRun, &out]()
+            {
+                if (zeroRun > 0)
+                {
+                    out.push_back(0);
+                    writeVarint(zeroRun - 1, out);
+                    zeroRun = 0;
+                }
+            };
+
+            for (std::size_t i = c * count; i < (c + 1) * count; ++i)
+            {
+                std::int32_t delta = static_cast<std::int16_t>(
+                    static_cast<std::uint16_t>(current[i] - previous[i]));
+                if (delta == 0)
+                {
+                    zeroRun++;
+                    continue;
+                }
+
+                flushZeros();
+                writeVarint(zigzag(delta), out);
+            }
+            flushZeros();
+
+            std::uint32_t planeSize =
+                static_cast<std::uint32_t>(out.size() - planeStart);
+            std::memcpy(out.data() + tableOffset + c * sizeof(planeSize),
+                &planeSize, sizeof(planeSize));
+        }
+    }
+
+    bool getFramePlanes(std::uint8_t const* data, std::size_t size,
+        FramePlanes& planes)
+    {
+        std::size_t const tableSize = QuantisedComponents * sizeof(std::uint32_t);
+        if (size < tableSize)
+        {
+            return false;
+        }
+
+        std::size_t offset = tableSize;
+        for (std::size_t c = 0; c < QuantisedComponents; ++c)
+        {
+            std::uint32_t planeSize;
+            std::memcpy(&planeSize, data + c * sizeof(planeSize),
+                sizeof(planeSize));
+            if (offset + planeSize > size)
+            {
+                return false;
+            }
+
+            planes[c].data = data + offset;
+            planes[c].size = planeSize;
+            offset += planeSize;
+        }
+        return true;
+    }
+
+    bool decodePlane(FramePlane const& plane, std::uint16_t* values,
+        std::size_t count)
+    {
+        // Deltas wrap modulo 2^16, which is exact for both the unsigned
+        // position and the signed forward planes.
+        std::uint8_t const* cursor = plane.data;
+        std::uint8_t const* const end = plane.data + plane.size;
+
+        std::size_t i = 0;
+        while (i < count)
+        {
+            if (cursor == end)
+            {
+                return false;
+            }
+
+            // Most deltas fit in a single byte; skip the generic varint loop.
+            std::uint8_t byte = *cursor;
+            if (byte != 0 && byte < 0x80)
+            {
+                cursor++;
+                values[i] = static_cast<std::uint16_t>(values[i] + unzigzag(byte));
+                ++i;
+                continue;
+            }
+
+            std::uint32_t value;
+            if (byte == 0)
+            {
+                cursor++;
+                if (!readVarint(cursor, end, value) || value >= count - i)
+                {
+                    return false;
+                }
+                i += static_cast<std::size_t>(value) + 1;
+                continue;
+            }
+
+            if (!readVarint(cursor, end, value))
+            {
+                return false;
+            }
+            values[i] = static_cast<std::uint16_t>(values[i] + unzigzag(value));
+            ++i;
+        }
+        return true;
+    }
+
+    bool decodeFrame(std::uint8_t const* data, std::size_t size,
+        QuantisedFrame& frame)
+    {
+        FramePlanes planes;
+        if (!getFramePlanes(data, size, planes))
+        {
+            return false;
+        }
+
+        std::size_t const count = frame.size() / QuantisedComponents;
+        for (std::size_t c = 0; c < QuantisedComponents; ++c)
+        {
+            if (!decodePlane(planes[c], frame.data() + c * count, count))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,215 @@
+#include "TrajectoryRecorder.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace bns
+{
+    TrajectoryRecorder::TrajectoryRecorder() :
+        mBoidCount(0),
+        mFramesPerChunk(0),
+        mFramesRecorded(0),
+        mHasWork(false),
+        mStopRequested(false)
+    { }
+
+    TrajectoryRecorder::~TrajectoryRecorder()
+    {
+        close();
+    }
+
+    bool TrajectoryRecorder::open(std::string const& path,
+        std::size_t boidCount, float boidRadius, std::uint32_t framesPerChunk)
+    {
+        close();
+
+        mFile.open(path, std::ios::binary | std::ios::trunc);
+        if (!mFile)
+        {
+            ERROR_LOG_V("Could not open trajectory file %s", path.c_str());
+            return false;
+        }
+
+        TrajectoryFileHeader header;
+        std::memcpy(header.magic, TrajectoryMagic, sizeof(header.magic));
+        header.version = TrajectoryVersion;
+        header.boidCount = static_cast<std::uint32_t>(boidCount);
+        header.framesPerChunk = std::max<std::uint32_t>(framesPerChunk, 1);
+        header.boidRadius = boidRadius;
+        mFile.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+        mBoidCount = boidCount;
+        mFramesPerChunk = header.framesPerChunk;
+        mFramesRecorded = 0;
+
+        mFilling.firstFrame = 0;
+        mFilling.frameCount = 0;
+        mFilling.positions.clear();
+        mFilling.forwards.clear();
+        mFilling.positions.reserve(mBoidCount * mFramesPerChunk);
+        mFilling.forwards.reserve(mBoidCount * mFramesPerChunk);
+
+        mHasWork = false;
+        mStopRequested = false;
+        mWriter = std::thread(&TrajectoryRecorder::writerLoop, this);
+        return true;
+    }
+
+    void TrajectoryRecorder::close()
+    {
+        if (!mFile.is_open())
+        {
+            return;
+        }
+
+        flushChunk();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopRequested = true;
+        }
+        mCondition.notify_all();
+        mWriter.join();
+
+        mFile.close();
+        INFO_LOG_V("Recorded %u frames of %u boids", mFramesRecorded,
+            static_cast<unsigned>(mBoidCount));
+    }
+
+    bool TrajectoryRecorder::isOpen() const
+    {
+        return mFile.is_open();
+    }
+
+    void TrajectoryRecorder::record(std::vector<Boid> const& boids)
+    {
+        if (!mFile.is_open() || boids.size() != mBoidCount)
+        {
+            return;
+        }
+
+        if (mFilling.frameCount == 0)
+        {
+            mFilling.firstFrame = mFramesRecorded;
+            mFilling.boundsMin = atlas::math::Vector(
+                std::numeric_limits<float>::max());
+            mFilling.boundsMax = atlas::math::Vector(
+                std::numeric_limits<float>::lowest());
+        }
+
+        for (auto const& boid : boids)
+        {
+            mFilling.positions.push_back(boid.mPosition);
+            mFilling.forwards.push_back(boid.mForward);
+            mFilling.boundsMin = glm::min(mFilling.boundsMin, boid.mPosition);
+            mFilling.boundsMax = glm::max(mFilling.boundsMax, boid.mPosition);
+        }
+
+        mFilling.frameCount++;
+        mFramesRecorded++;
+
+        if (mFilling.frameCount == mFramesPerChunk)
+        {
+            flushChunk();
+        }
+    }
+
+    std::uint32_t TrajectoryRecorder::getFramesRecorded() const
+    {
+        return mFramesRecorded;
+    }
+
+    void TrajectoryRecorder::flushChunk()
+    {
+        if (mFilling.frameCount == 0)
+        {
+            return;
+        }
+
+        // Wait for the writer to finish the previous chunk, then hand this
+        // one over by swapping buffers so neither side reallocates.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this]() { return !mHasWork; });
+
+        std::swap(mFilling, mWriting);
+        mFilling.frameCount = 0;
+        mFilling.positions.clear();
+        mFilling.forwards.clear();
+
+        mHasWork = true;
+        lock.unlock();
+        mCondition.notify_all();
+    }
+
+    void TrajectoryRecorder::writerLoop()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]()
+            {
+                return mHasWork || mStopRequested;
+            });
+
+            if (!mHasWork)
+            {
+                return;
+            }
+
+            lock.unlock();
+            writeChunk(mWriting);
+            lock.lock();
+
+            mHasWork = false;
+            lock.unlock();
+            mCondition.notify_all();
+        }
+    }
+
+    void TrajectoryRecorder::writeChunk(PendingChunk const& chunk)
+    {
+        atlas::math::Vector extent = chunk.boundsMax - chunk.boundsMin;
+
+        mPrevious.assign(mBoidCount * QuantisedComponents, 0);
+        mCurrent.resize(mBoidCount * QuantisedComponents);
+        mPayload.clear();
+
+        for (std::uint32_t f = 0; f < chunk.frameCount; ++f)
+        {
+            std::size_t base = f * mBoidCount;
+            for (std::size_t i = 0; i < mBoidCount; ++i)
+            {
+                quantiseBoid(chunk.positions[base + i], chunk.forwards[base + i],
+                    chunk.boundsMin, extent, i, mCurrent);
+            }
+
+            mBlock.clear();
+            encodeFrame(mPrevious, mCurrent, mBlock);
+
+            std::uint32_t blockSize = static_cast<std::uint32_t>(mBlock.size());
+            auto sizeBytes = reinterpret_cast<std::uint8_t const*>(&blockSize);
+            mPayload.insert(mPayload.end(), sizeBytes,
+                sizeBytes + sizeof(blockSize));
+            mPayload.insert(mPayload.end(), mBlock.begin(), mBlock.end());
+
+            std::swap(mPrevious, mCurrent);
+        }
+
+        TrajectoryChunkHeader header;
+        header.firstFrame = chunk.firstFrame;
+        header.frameCount = chunk.frameCount;
+        for (int c = 0; c < 3; ++c)
+        {
+            header.boundsMin[c] = chunk.boundsMin[c];
+            header.boundsMax[c] = chunk.boundsMax[c];
+        }
+        header.payloadSize = static_cast<std::uint32_t>(mPayload.size());
+
+        mFile.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        mFile.write(reinterpret_cast<char const*>(mPayload.data()),
+            mPayload.size());
+    }
+}
@@ -0,0 +1,380 @@
+#include "TrajectoryReplay.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <future>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bns
+{
+    namespace
+    {
+        // Below this many boids a frame decodes faster than tasks launch.
+        constexpr std::size_t ParallelDecodeThreshold = 65536;
+    }
+
+    MappedFile::MappedFile() :
+        mData(nullptr),
+        mSize(0)
+#ifdef _WIN32
+        , mFileHandle(nullptr),
+        mMappingHandle(nullptr)
+#endif
+    { }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(std::string const& path)
+    {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+            nullptr);
+        if (mapping == nullptr)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        mData = static_cast<std::uint8_t const*>(
+            MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        mSize = static_cast<std::size_t>(size.QuadPart);
+        mFileHandle = file;
+        mMappingHandle = mapping;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* data = mmap(nullptr, static_cast<std::size_t>(info.st_size),
+            PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+
+        // Replay walks the file front to back.
+        madvise(data, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+        mData = static_cast<std::uint8_t const*>(data);
+        mSize = static_cast<std::size_t>(info.st_size);
+#endif
+        return mData != nullptr;
+    }
+
+    void MappedFile::close()
+    {
+        if (mData == nullptr)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+        CloseHandle(mMappingHandle);
+        CloseHandle(mFileHandle);
+        mMappingHandle = nullptr;
+        mFileHandle = nullptr;
+#else
+        munmap(const_cast<std::uint8_t*>(mData), mSize);
+#endif
+        mData = nullptr;
+        mSize = 0;
+    }
+
+    std::uint8_t const* MappedFile::getData() const
+    {
+        return mData;
+    }
+
+    std::size_t MappedFile::getSize() const
+    {
+        return mSize;
+    }
+
+    TrajectoryReplay::TrajectoryReplay() :
+        mFrameCount(0),
+        mChunk(0),
+        mFrameInChunk(0),
+        mCursor(0),
+        mCurrentFrame(0)
+    { }
+
+    bool TrajectoryReplay::open(std::string const& path)
+    {
+        close();
+
+        if (!mFile.open(path))
+        {
+            ERROR_LOG_V("Could not map trajectory file %s", path.c_str());
+            return false;
+        }
+
+        std::uint8_t const* data = mFile.getData();
+        std::size_t size = mFile.getSize();
+        if (size < sizeof(TrajectoryFileHeader))
+        {
+            close();
+            return false;
+        }
+
+        std::memcpy(&mHeader, data, sizeof(mHeader));
+        if (std::memcmp(mHeader.magic, TrajectoryMagic, sizeof(mHeader.magic))
+            != 0 || mHeader.version != TrajectoryVersion)
+        {
+            ERROR_LOG_V("%s is not a trajectory file", path.c_str());
+            close();
+            return false;
+        }
+
+        // Build the chunk index by hopping over payloads. A recording that
+        // was cut short simply ends at the last complete chunk.
+        std::size_t offset = sizeof(TrajectoryFileHeader);
+        while (offset + sizeof(TrajectoryChunkHeader) <= size)
+        {
+            ChunkEntry entry;
+            std::memcpy(&entry.header, data + offset, sizeof(entry.header));
+            entry.payloadOffset = offset + sizeof(TrajectoryChunkHeader);
+            if (entry.payloadOffset + entry.header.payloadSize > size)
+            {
+                break;
+            }
+
+            mChunks.push_back(entry);
+            mFrameCount += entry.header.frameCount;
+            offset = entry.payloadOffset + entry.header.payloadSize;
+        }
+
+        if (mChunks.empty())
+        {
+            close();
+            return false;
+        }
+
+        mState.resize(mHeader.boidCount * QuantisedComponents);
+        // Recordings are written in boid ID order.
+        mBoids.assign(mHeader.boidCount, Boid());
+        for (std::size_t i = 0; i < mBoids.size(); ++i)
+        {
+            mBoids[i].mRadius = mHeader.boidRadius;
+            mBoids[i].mId = static_cast<std::uint32_t>(i);
+        }
+
+        return seek(0);
+    }
+
+    void TrajectoryReplay::close()
+    {
+        mFile.close();
+        mChunks.clear();
+        mFrameCount = 0;
+        mCurrentFrame = 0;
+    }
+
+    bool TrajectoryReplay::isOpen() const
+    {
+        return !mChunks.empty();
+    }
+
+    std::uint32_t TrajectoryReplay::getFrameCount() const
+    {
+        return mFrameCount;
+    }
+
+    std::uint32_t TrajectoryReplay::getCurrentFrame() const
+    {
+        return mCurrentFrame;
+    }
+
+    bool TrajectoryReplay::seek(std::uint32_t frame)
+    {
+        if (frame >= mFrameCount)
+        {
+            return false;
+        }
+
+        std::size_t chunk = 0;
+        while (frame >= mChunks[chunk].header.firstFrame +
+            mChunks[chunk].header.frameCount)
+        {
+            chunk++;
+        }
+
+        // Frames are deltas, so replay forward from the start of the chunk.
+        beginChunk(chunk);
+        std::uint32_t target = frame - mChunks[chunk].header.firstFrame;
+        for (std::uint32_t f = 0; f <= target; ++f)
+        {
+            if (!decodeNextFrame())
+            {
+                return false;
+            }
+        }
+
+        mCurrentFrame = frame;
+        dequantise();
+        return true;
+    }
+
+    bool TrajectoryReplay::advance()
+    {
+        if (!isOpen() || mCurrentFrame + 1 >= mFrameCount)
+        {
+            return false;
+        }
+
+        if (mFrameInChunk == mChunks[mChunk].header.frameCount)
+        {
+            beginChunk(mChunk + 1);
+        }
+
+        if (!decodeNextFrame())
+        {
+            return false;
+        }
+
+        mCurrentFrame++;
+        dequantise();
+        return true;
+    }
+
+    std::vector<Boid> const& TrajectoryReplay::getBoids() const
+    {
+        return mBoids;
+    }
+
+    void TrajectoryReplay::beginChunk(std::size_t chunk)
+    {
+        mChunk = chunk;
+        mFrameInChunk = 0;
+        mCursor = mChunks[chunk].payloadOffset;
+        std::fill(mState.begin(), mState.end(), std::uint16_t(0));
+    }
+
+    bool TrajectoryReplay::decodeNextFrame()
+    {
+        ChunkEntry const& entry = mChunks[mChunk];
+        std::size_t end = entry.payloadOffset + entry.header.payloadSize;
+
+        std::uint32_t blockSize;
+        if (mCursor + sizeof(blockSize) > end)
+        {
+            return false;
+        }
+        std::memcpy(&blockSize, mFile.getData() + mCursor, sizeof(blockSize));
+        mCursor += sizeof(blockSize);
+
+        FramePlanes planes;
+        if (mCursor + blockSize > end ||
+            !getFramePlanes(mFile.getData() + mCursor, blockSize, planes))
+        {
+            return false;
+        }
+
+        std::size_t const count = mHeader.boidCount;
+        if (count < ParallelDecodeThreshold)
+        {
+            for (std::size_t c = 0; c < QuantisedComponents; ++c)
+            {
+                if (!decodePlane(planes[c], mState.data() + c * count, count))
+                {
+                    return false;
+                }
+            }
+        }
+        else
+        {
+            // Planes are independent, so large flocks decode one per task.
+            std::array<std::future<bool>, QuantisedComponents> tasks;
+            for (std::size_t c = 1; c < QuantisedComponents; ++c)
+            {
+                tasks[c] = std::async(std::launch::async, decodePlane,
+                    planes[c], mState.data() + c * count, count);
+            }
+
+            bool ok = decodePlane(planes[0], mState.data(), count);
+            for (std::size_t c = 1; c < QuantisedComponents; ++c)
+            {
+                ok = tasks[c].get() && ok;
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+
+        mCursor += blockSize;
+        mFrameInChunk++;
+        return true;
+    }
+
+    void TrajectoryReplay::dequantise()
+    {
+        TrajectoryChunkHeader const& header = mChunks[mChunk].header;
+        atlas::math::Vector boundsMin(header.boundsMin[0], header.boundsMin[1],
+            header.boundsMin[2]);
+        atlas::math::Vector boundsMax(header.boundsMax[0], header.boundsMax[1],
+            header.boundsMax[2]);
+        atlas::math::Vector extent = boundsMax - boundsMin;
+
+        if (mBoids.size() < ParallelDecodeThreshold)
+        {
+            dequantiseFrame(mState, 0, mBoids.size(), boundsMin, extent, mBoids);
+            return;
+        }
+
+        std::size_t const tasks = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t const span = (mBoids.size() + tasks - 1) / tasks;
+        std::vector<std::future<void>> pending;
+        for (std::size_t begin = span; begin < mBoids.size(); begin += span)
+        {
+            std::size_t end = std::min(begin + span, mBoids.size());
+            pending.push_back(std::async(std::launch::async, [&, begin, end]()
+            {
+                dequantiseFrame(mState, begin, end, boundsMin, extent, mBoids);
+            }));
+        }
+
+        dequantiseFrame(mState, 0, std::min(span, mBoids.size()), boundsMin,
+            extent, mBoids);
+        for (auto& task : pending)
+        {
+            task.get();
+        }
+    }
+}
@@ -0,0 +1,382 @@
+#include "Transport.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace bns
+{
+    namespace
+    {
+        struct FrameHeader
+        {
+            std::uint32_t type;
+            std::uint32_t size;
+        };
+
+        // Opens a socket for the address and fills in the matching sockaddr.
+        // TCP hosts are resolved here so connect and listen share the lookup.
+        int openSocket(Address const& address, sockaddr_storage& storage,
+            socklen_t& length)
+        {
+            std::memset(&storage, 0, sizeof(storage));
+
+            if (address.kind == Address::Kind::Unix)
+            {
+                sockaddr_un* local = reinterpret_cast<sockaddr_un*>(&storage);
+                if (address.path.size() >= sizeof(local->sun_path))
+                {
+                    ERROR_LOG_V("Socket path too long: %s",
+                        address.path.c_str());
+                    return -1;
+                }
+                local->sun_family = AF_UNIX;
+                std::memcpy(local->sun_path, address.path.c_str(),
+                    address.path.size() + 1);
+                length = sizeof(sockaddr_un);
+                return socket(AF_UNIX, SOCK_STREAM, 0);
+            }
+
+            addrinfo hints;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_PASSIVE;
+
+            addrinfo* result = nullptr;
+            std::string port = std::to_string(address.port);
+            char const* host = address.host.empty() ? nullptr :
+                address.host.c_str();
+            if (getaddrinfo(host, port.c_str(), &hints, &result) != 0 ||
+                result == nullptr)
+            {
+                ERROR_LOG_V("Could not resolve %s", address.host.c_str());
+                return -1;
+            }
+
+            std::memcpy(&storage, result->ai_addr, result->ai_addrlen);
+            length = static_cast<socklen_t>(result->ai_addrlen);
+            int family = result->ai_family;
+            freeaddrinfo(result);
+            return socket(family, SOCK_STREAM, 0);
+        }
+
+        void configureSocket(int socket, sockaddr_storage const& storage)
+        {
+            // Halo messages are small and latency bound; don't let Nagle
+            // hold them back.
+            if (storage.ss_family != AF_UNIX)
+            {
+                int one = 1;
+                setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            }
+        }
+    }
+
+    bool parseAddress(std::string const& text, Address& address)
+    {
+        if (text.compare(0, 5, "unix:") == 0 && text.size() > 5)
+        {
+            address.kind = Address::Kind::Unix;
+            address.path = text.substr(5);
+            return true;
+        }
+
+        if (text.compare(0, 4, "tcp:") == 0)
+        {
+            std::size_t colon = text.rfind(':');
+            if (colon <= 3 || colon + 1 >= text.size())
+            {
+                return false;
+            }
+            address.kind = Address::Kind::Tcp;
+            address.host = text.substr(4, colon - 4);
+            address.port = static_cast<std::uint16_t>(
+                std::atoi(text.c_str() + colon + 1));
+            return true;
+        }
+
+        return false;
+    }
+
+    std::string formatAddress(Address const& address)
+    {
+        if (address.kind == Address::Kind::Unix)
+        {
+            return "unix:" + address.path;
+        }
+        return "tcp:" + address.host + ":" + std::to_string(address.port);
+    }
+
+    MessageBuffer::MessageBuffer() :
+        mRead(0)
+    { }
+
+    void MessageBuffer::clear()
+    {
+        mData.clear();
+        mRead = 0;
+    }
+
+    std::vector<std::uint8_t>& MessageBuffer::getData()
+    {
+        return mData;
+    }
+
+    std::vector<std::uint8_t> const& MessageBuffer::getData() const
+    {
+        return mData;
+    }
+
+    Connection::Connection() :
+        mSocket(-1)
+    { }
+
+    Connection::Connection(int socket) :
+        mSocket(socket)
+    { }
+
+    Connection::~Connection()
+    {
+        close();
+    }
+
+    Connection::Connection(Connection&& other) :
+        mSocket(other.mSocket)
+    {
+        other.mSocket = -1;
+    }
+
+    Connection& Connection::operator=(Connection&& other)
+    {
+        if (this != &other)
+        {
+            close();
+            mSocket = other.mSocket;
+            other.mSocket = -1;
+        }
+        return *this;
+    }
+
+    bool Connection::connect(Address const& address, int timeoutMilliseconds)
+    {
+        close();
+
+        auto deadline = std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(timeoutMilliseconds);
+        for (;;)
+        {
+            sockaddr_storage storage;
+            socklen_t length = 0;
+            int socket = openSocket(address, storage, length);
+            if (socket < 0)
+            {
+                return false;
+            }
+
+            if (::connect(socket, reinterpret_cast<sockaddr*>(&storage),
+                length) == 0)
+            {
+                configureSocket(socket, storage);
+                mSocket = socket;
+                return true;
+            }
+            ::close(socket);
+
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                ERROR_LOG_V("Could not connect to %s",
+                    formatAddress(address).c_str());
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    void Connection::close()
+    {
+        if (mSocket >= 0)
+        {
+            ::close(mSocket);
+            mSocket = -1;
+        }
+    }
+
+    bool Connection::isOpen() const
+    {
+        return mSocket >= 0;
+    }
+
+    bool Connection::send(std::uint32_t type, MessageBuffer const& message)
+    {
+        FrameHeader header;
+        header.type = type;
+        header.size = static_cast<std::uint32_t>(message.getData().size());
+
+        return sendAll(&header, sizeof(header)) &&
+            sendAll(message.getData().data(), message.getData().size());
+    }
+
+    bool Connection::receive(std::uint32_t& type, MessageBuffer& message)
+    {
+        FrameHeader header;
+        if (!receiveAll(&header, sizeof(header)))
+        {
+            return false;
+        }
+
+        message.clear();
+        message.getData().resize(header.size);
+        type = header.type;
+        return receiveAll(message.getData().data(), header.size);
+    }
+
+    bool Connection::sendBytes(void const* data, std::size_t size)
+    {
+        return sendAll(data, size);
+    }
+
+    std::size_t Connection::receiveSome(void* data, std::size_t size)
+    {
+        ssize_t received = ::recv(mSocket, data, size, 0);
+        return (received > 0) ? static_cast<std::size_t>(received) : 0;
+    }
+
+    void Connection::setReceiveTimeout(int timeoutMilliseconds)
+    {
+        timeval timeout;
+        timeout.tv_sec = timeoutMilliseconds / 1000;
+        timeout.tv_usec = (timeoutMilliseconds % 1000) * 1000;
+        setsockopt(mSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+            sizeof(timeout));
+    }
+
+    bool Connection::sendAll(void const* data, std::size_t size)
+    {
+        std::uint8_t const* bytes = static_cast<std::uint8_t const*>(data);
+        while (size > 0)
+        {
+            ssize_t sent = ::send(mSocket, bytes, size, MSG_NOSIGNAL);
+            if (sent <= 0)
+            {
+                return false;
+            }
+            bytes += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+
+    bool Connection::receiveAll(void* data, std::size_t size)
+    {
+        std::uint8_t* bytes = static_cast<std::uint8_t*>(data);
+        while (size > 0)
+        {
+            ssize_t received = ::recv(mSocket, bytes, size, 0);
+            if (received <= 0)
+            {
+                return false;
+            }
+            bytes += received;
+            size -= static_cast<std::size_t>(received);
+        }
+        return true;
+    }
+
+    Listener::Listener() :
+        mSocket(-1)
+    { }
+
+    Listener::~Listener()
+    {
+        close();
+    }
+
+    bool Listener::listen(Address const& address)
+    {
+        close();
+
+        sockaddr_storage storage;
+        socklen_t length = 0;
+        int socket = openSocket(address, storage, length);
+        if (socket < 0)
+        {
+            return false;
+        }
+
+        if (address.kind == Address::Kind::Unix)
+        {
+            // A stale socket file from a crashed run would make bind fail.
+            unlink(address.path.c_str());
+            mUnixPath = address.path;
+        }
+        else
+        {
+            int one = 1;
+            setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+
+        if (bind(socket, reinterpret_cast<sockaddr*>(&storage), length) != 0 ||
+            ::listen(socket, 16) != 0)
+        {
+            ERROR_LOG_V("Could not listen on %s",
+                formatAddress(address).c_str());
+            ::close(socket);
+            return false;
+        }
+
+        mSocket = socket;
+        return true;
+    }
+
+    void Listener::close()
+    {
+        if (mSocket >= 0)
+        {
+            ::close(mSocket);
+            mSocket = -1;
+        }
+        if (!mUnixPath.empty())
+        {
+            unlink(mUnixPath.c_str());
+            mUnixPath.clear();
+        }
+    }
+
+    Connection Listener::accept()
+    {
+        sockaddr_storage storage;
+        socklen_t length = sizeof(storage);
+        int socket = ::accept(mSocket, reinterpret_cast<sockaddr*>(&storage),
+            &length);
+        if (socket >= 0)
+        {
+            configureSocket(socket, storage);
+        }
+        return Connection(socket);
+    }
+
+    Connection Listener::accept(int timeoutMilliseconds)
+    {
+        pollfd waiting;
+        waiting.fd = mSocket;
+        waiting.events = POLLIN;
+        waiting.revents = 0;
+        if (poll(&waiting, 1, timeoutMilliseconds) <= 0)
+        {
+            return Connection();
+        }
+        return accept();
+    }
+}
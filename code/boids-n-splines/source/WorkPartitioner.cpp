@@ -0,0 +1,184 @@
+#include "WorkPartitioner.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace bns
+{
+    namespace
+    {
+        // Cuts are found with a cost histogram along the axis, refined once
+        // inside the bin where the target falls: two linear passes instead
+        // of a sort, with 1/65536 of the region's width as resolution.
+        constexpr std::size_t CutBins = 256;
+        constexpr int CutRefinements = 2;
+    }
+
+    WorkPartitioner::WorkPartitioner()
+    { }
+
+    void WorkPartitioner::partition(std::vector<Boid> const& boids,
+        std::vector<float> const& costs, std::size_t partCount)
+    {
+        partCount = std::max<std::size_t>(partCount, 1);
+
+        mIndices.resize(boids.size());
+        std::iota(mIndices.begin(), mIndices.end(), 0);
+        mPartBegin.assign(partCount + 1, boids.size());
+        mPartCost.assign(partCount, 0.0f);
+
+        split(boids, costs, 0, boids.size(), 0, partCount);
+    }
+
+    std::size_t WorkPartitioner::getPartCount() const
+    {
+        return mPartCost.size();
+    }
+
+    std::vector<std::uint32_t> const& WorkPartitioner::getIndices() const
+    {
+        return mIndices;
+    }
+
+    std::size_t WorkPartitioner::getPartBegin(std::size_t part) const
+    {
+        return mPartBegin[part];
+    }
+
+    float WorkPartitioner::getPartCost(std::size_t part) const
+    {
+        return mPartCost[part];
+    }
+
+    float WorkPartitioner::getPredictedImbalance() const
+    {
+        if (mPartCost.empty())
+        {
+            return 1.0f;
+        }
+
+        float total = 0.0f;
+        float largest = 0.0f;
+        for (float cost : mPartCost)
+        {
+            total += cost;
+            largest = std::max(largest, cost);
+        }
+        return (total > 0.0f) ? largest * mPartCost.size() / total : 1.0f;
+    }
+
+    void WorkPartitioner::split(std::vector<Boid> const& boids,
+        std::vector<float> const& costs, std::size_t begin, std::size_t end,
+        std::size_t firstPart, std::size_t partCount)
+    {
+        float total = 0.0f;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            total += costs[mIndices[i]];
+        }
+
+        if (partCount == 1 || end - begin <= 1)
+        {
+            // Any parts left over (more parts than boids) stay empty.
+            mPartBegin[firstPart] = begin;
+            for (std::size_t part = firstPart + 1;
+                part < firstPart + partCount; ++part)
+            {
+                mPartBegin[part] = end;
+            }
+            mPartCost[firstPart] = total;
+            return;
+        }
+
+        atlas::math::Vector lower = boids[mIndices[begin]].mPosition;
+        atlas::math::Vector upper = lower;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            lower = glm::min(lower, boids[mIndices[i]].mPosition);
+            upper = glm::max(upper, boids[mIndices[i]].mPosition);
+        }
+        atlas::math::Vector extent = upper - lower;
+        int axis = 0;
+        if (extent.y > extent[axis])
+        {
+            axis = 1;
+        }
+        if (extent.z > extent[axis])
+        {
+            axis = 2;
+        }
+
+        std::size_t leftParts = partCount / 2;
+        float target = total * static_cast<float>(leftParts) / partCount;
+        std::size_t mid = begin;
+        if (extent[axis] > 0.0f)
+        {
+            float cut = findCut(boids, costs, begin, end, axis, lower[axis],
+                upper[axis], target);
+            auto middle = std::partition(mIndices.begin() + begin,
+                mIndices.begin() + end, [&](std::uint32_t index)
+            {
+                return boids[index].mPosition[axis] < cut;
+            });
+            mid = static_cast<std::size_t>(middle - mIndices.begin());
+        }
+        else
+        {
+            // Every boid sits on the same spot; split them in index order.
+            float running = 0.0f;
+            while (mid < end && running < target)
+            {
+                running += costs[mIndices[mid]];
+                mid++;
+            }
+        }
+
+        split(boids, costs, begin, mid, firstPart, leftParts);
+        split(boids, costs, mid, end, firstPart + leftParts,
+            partCount - leftParts);
+    }
+
+    float WorkPartitioner::findCut(std::vector<Boid> const& boids,
+        std::vector<float> const& costs, std::size_t begin, std::size_t end,
+        int axis, float low, float high, float target)
+    {
+        float below = 0.0f;
+        float inside = 0.0f;
+        for (int pass = 0; pass < CutRefinements && high > low; ++pass)
+        {
+            float width = (high - low) / CutBins;
+            mBins.assign(CutBins, 0.0f);
+            below = 0.0f;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                float coordinate = boids[mIndices[i]].mPosition[axis];
+                float cost = costs[mIndices[i]];
+                if (coordinate < low)
+                {
+                    below += cost;
+                }
+                else if (coordinate <= high)
+                {
+                    std::size_t bin = std::min(static_cast<std::size_t>(
+                        (coordinate - low) / width), CutBins - 1);
+                    mBins[bin] += cost;
+                }
+            }
+
+            // Narrow down to the bin in which the running cost reaches the
+            // target.
+            std::size_t bin = 0;
+            while (bin + 1 < CutBins && below + mBins[bin] < target)
+            {
+                below += mBins[bin];
+                bin++;
+            }
+            inside = mBins[bin];
+            low = low + width * bin;
+            high = low + width;
+        }
+
+        // Cut at whichever edge of the final bin comes closer to the target.
+        return (target - below <= below + inside - target) ? low : high;
+    }
+}
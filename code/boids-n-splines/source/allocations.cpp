@@ -0,0 +1,132 @@
+#include "AllocationCounter.hpp"
+#include "BoidInstances.hpp"
+#include "FlockSimulation.hpp"
+#include "FrameArena.hpp"
+#include "SimulationThread.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace bns;
+
+    constexpr int MaxTuningSteps = 10000;
+
+    // Runs frames the way the viewer does (step, then build this frame's
+    // instances in the frame arena) and counts heap allocations in each
+    // one after the warm-up. Returns the number of frames that allocated.
+    int checkFrames(char const* name, int warmUpFrames, int frames,
+        std::function<std::vector<Boid> const&()> const& step)
+    {
+        FrameArena arena;
+        std::vector<CullCell> cells;
+        std::vector<std::uint32_t> cellStarts;
+
+        int failures = 0;
+        for (int frame = 0; frame < warmUpFrames + frames; ++frame)
+        {
+            std::uint64_t before = getHeapAllocationCount();
+
+            arena.reset();
+            std::vector<Boid> const& boids = step();
+            std::pmr::vector<BoidInstance> instances(&arena);
+            buildBoidInstances(boids, 0, instances, cells, cellStarts);
+
+            std::uint64_t allocations = getHeapAllocationCount() - before;
+            if (frame >= warmUpFrames && allocations > 0)
+            {
+                ERROR_LOG_V("%s: frame %d made %llu heap allocations", name,
+                    frame, static_cast<unsigned long long>(allocations));
+                failures++;
+            }
+        }
+
+        if (failures == 0)
+        {
+            INFO_LOG_V("%s: no heap allocations in %d frames after %d to "
+                "warm up", name, frames, warmUpFrames);
+        }
+        return failures;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    FlockParameters params;
+    params.numBoids = (argc > 1) ? std::atoi(argv[1]) : 2000;
+    int warmUpFrames = (argc > 2) ? std::atoi(argv[2]) : 120;
+    int frames = (argc > 3) ? std::atoi(argv[3]) : 1200;
+    if (params.numBoids < 1 || warmUpFrames < 0 || frames < 1)
+    {
+        ERROR_LOG("usage: bns-allocations [boids] [warm-up frames] [frames]");
+        return 1;
+    }
+    // Keep the starting density of the original 100 boid flock.
+    params.flockRadius *= std::sqrt(params.numBoids / 100.0f);
+
+    // Inline: the scene steps the simulation itself.
+    auto checkInline = [&](char const* name, FlockParameters const& flock)
+    {
+        FlockSimulation simulation(flock);
+        if (flock.autoTune)
+        {
+            // Trying out thread counts builds a new pool each time, so only
+            // the locked-in settings have to stay off the heap.
+            for (int step = 0; step < MaxTuningSteps &&
+                !simulation.getTunerStatus().locked; ++step)
+            {
+                simulation.step();
+            }
+        }
+        return checkFrames(name, warmUpFrames, frames,
+            [&]() -> std::vector<Boid> const&
+        {
+            simulation.step();
+            return simulation.getBoids();
+        });
+    };
+
+    int failures = checkInline("inline", params);
+
+    // The force pass on a thread pool, with every hardware thread.
+    FlockParameters threaded = params;
+    threaded.threadCount = 0;
+    failures += checkInline("inline, all threads", threaded);
+
+    FlockParameters tuned = params;
+    tuned.autoTune = true;
+    failures += checkInline("inline, auto-tuned", tuned);
+
+    {
+        // Pipelined: steps go through the command queue to the simulation
+        // thread, and frame N draws step N while step N + 1 runs. Waiting
+        // for each snapshot keeps the warm-up counting real steps even when
+        // the simulation thread is slow to get scheduled.
+        FlockSimulation simulation(params);
+        SimulationThread thread(simulation);
+        thread.start();
+        std::uint64_t drawn = 0;
+        failures += checkFrames("pipelined", warmUpFrames, frames,
+            [&]() -> std::vector<Boid> const&
+        {
+            thread.post(SimCommand::step(0.0f));
+            FlockSnapshot const* snapshot = &thread.acquireSnapshot();
+            while (snapshot->frame < drawn)
+            {
+                std::this_thread::yield();
+                snapshot = &thread.acquireSnapshot();
+            }
+            drawn++;
+            return snapshot->boids;
+        });
+        thread.stop();
+    }
+
+    return (failures == 0) ? 0 : 1;
+}
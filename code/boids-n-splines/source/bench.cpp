@@ -0,0 +1,284 @@
+#include "BoidInstances.hpp"
+#include "FlockSimulation.hpp"
+#include "FrameArena.hpp"
+#include "SplineCurve.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace bns;
+
+    constexpr std::uint32_t Seed = 473;
+    constexpr int BoidCounts[] = { 100, 1000, 10000, 100000, 1000000 };
+    constexpr int SplineResolutions[] = { 100, 1000, 10000 };
+    constexpr int LookUpsPerSample = 100;
+    constexpr int StepsPerSample = 5;
+    // A case stops sampling once it has spent this long, as long as it has
+    // at least MinSamples; the largest flocks take seconds per step.
+    constexpr double CaseBudgetSeconds = 10.0;
+    constexpr int MinSamples = 3;
+
+    struct Result
+    {
+        std::string name;
+        // Work items per sample (boid steps, points, lookups).
+        long long items;
+        int samples;
+        double median;
+        double min;
+        double max;
+        // Median absolute deviation from the median.
+        double mad;
+    };
+
+    // Keeps the optimiser from discarding work whose result is unused.
+    volatile float gSink;
+
+    double getMedian(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        std::size_t middle = values.size() / 2;
+        return (values.size() % 2 == 1) ? values[middle] :
+            0.5 * (values[middle - 1] + values[middle]);
+    }
+
+    // Times sample() after one untimed warm-up call, reporting milliseconds
+    // per call. prepare(), if given, runs untimed before every call.
+    Result measure(std::string const& name, long long items, int samples,
+        std::function<void()> const& sample,
+        std::function<void()> const& prepare = nullptr)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        if (prepare)
+        {
+            prepare();
+        }
+        sample();
+        std::vector<double> times;
+        double spent = 0.0;
+        while (static_cast<int>(times.size()) < samples &&
+            (static_cast<int>(times.size()) < MinSamples ||
+                spent < CaseBudgetSeconds))
+        {
+            if (prepare)
+            {
+                prepare();
+            }
+            auto start = Clock::now();
+            sample();
+            double seconds = std::chrono::duration<double>(
+                Clock::now() - start).count();
+            times.push_back(seconds * 1000.0);
+            spent += seconds;
+        }
+
+        Result result;
+        result.name = name;
+        result.items = items;
+        result.samples = static_cast<int>(times.size());
+        result.median = getMedian(times);
+        result.min = *std::min_element(times.begin(), times.end());
+        result.max = *std::max_element(times.begin(), times.end());
+        std::vector<double> deviations;
+        for (double time : times)
+        {
+            deviations.push_back(std::fabs(time - result.median));
+        }
+        result.mad = getMedian(deviations);
+
+        INFO_LOG_V("%-28s %10.4f ms median, %10.4f .. %10.4f, +/- %5.1f%% "
+            "(%d samples)", name.c_str(), result.median, result.min,
+            result.max, 100.0 * result.mad / std::max(result.median, 1e-9),
+            result.samples);
+        return result;
+    }
+
+    FlockParameters makeFlock(int boids)
+    {
+        FlockParameters params;
+        params.numBoids = boids;
+        params.seed = Seed;
+        // Boids are scattered over a disc; widen it to keep the density of
+        // the default flock as it grows.
+        params.flockRadius *= std::sqrt(boids / 100.0f);
+        return params;
+    }
+
+    std::vector<atlas::math::Point> makeControlPoints()
+    {
+        std::mt19937 random(Seed);
+        std::uniform_real_distribution<float> coordinate(-30.0f, 30.0f);
+        std::vector<atlas::math::Point> points;
+        for (int i = 0; i < 4; ++i)
+        {
+            points.emplace_back(coordinate(random), coordinate(random),
+                coordinate(random));
+        }
+        return points;
+    }
+
+    bool writeResults(std::string const& path,
+        std::vector<Result> const& results)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (file == nullptr)
+        {
+            ERROR_LOG_V("Could not open %s", path.c_str());
+            return false;
+        }
+
+        std::fprintf(file, "{\n  \"version\": 1,\n  \"seed\": %u,\n"
+            "  \"unit\": \"ms\",\n  \"cases\": [\n", Seed);
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            Result const& r = results[i];
+            std::fprintf(file, "    { \"name\": \"%s\", \"items\": %lld, "
+                "\"samples\": %d, \"median\": %.6f, \"min\": %.6f, "
+                "\"max\": %.6f, \"mad\": %.6f }%s\n", r.name.c_str(), r.items,
+                r.samples, r.median, r.min, r.max, r.mad,
+                (i + 1 < results.size()) ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        return std::fclose(file) == 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string output = (argc > 1) ? argv[1] : "bench.json";
+    int maxBoids = (argc > 2) ? std::atoi(argv[2]) : 1000000;
+    int samples = (argc > 3) ? std::atoi(argv[3]) : 15;
+    if (maxBoids < 1 || samples < MinSamples)
+    {
+        ERROR_LOG("usage: bns-bench [results.json] [max boids] [samples]");
+        return 1;
+    }
+
+    std::vector<Result> results;
+    FrameArena arena;
+    for (int boids : BoidCounts)
+    {
+        if (boids > maxBoids)
+        {
+            break;
+        }
+
+        // A few steps: neighbour search, the boid rules and integration.
+        // Every sample starts from a freshly scattered flock, since one that
+        // clumps up over the run would otherwise make later samples dearer.
+        // Its first step is untimed; it builds the neighbour lists, which
+        // later steps only rebuild once boids move past the skin, as in a
+        // real run.
+        std::unique_ptr<FlockSimulation> simulation;
+        results.push_back(measure("flock.steps/" + std::to_string(boids),
+            static_cast<long long>(boids) * StepsPerSample, samples, [&]
+        {
+            for (int i = 0; i < StepsPerSample; ++i)
+            {
+                simulation->step();
+            }
+        }, [&]
+        {
+            // Free the old flock first; the largest take a lot of memory.
+            simulation = nullptr;
+            simulation = std::make_unique<FlockSimulation>(makeFlock(boids));
+            simulation->step();
+        }));
+
+        // Instance data for the draw, as the viewer builds it every frame.
+        std::vector<CullCell> cells;
+        std::vector<std::uint32_t> cellStarts;
+        results.push_back(measure("instances.build/" + std::to_string(boids),
+            boids, samples, [&]
+        {
+            arena.reset();
+            std::pmr::vector<BoidInstance> instances(&arena);
+            buildBoidInstances(simulation->getBoids(), 0, instances, cells,
+                cellStarts);
+            gSink = instances.back().position.x;
+        }));
+        results.push_back(measure("instances.buildHalf/" +
+            std::to_string(boids), boids, samples, [&]
+        {
+            arena.reset();
+            std::pmr::vector<HalfBoidInstance> instances(&arena);
+            buildBoidInstances(simulation->getBoids(), 0, instances, cells,
+                cellStarts);
+            gSink = instances.back().position[0];
+        }));
+    }
+
+    std::vector<atlas::math::Point> controlPoints = makeControlPoints();
+    for (int resolution : SplineResolutions)
+    {
+        std::string suffix = "/" + std::to_string(resolution);
+        SplineCurve curve(controlPoints, resolution);
+
+        results.push_back(measure("spline.evaluate" + suffix, resolution,
+            samples, [&]
+        {
+            float sum = 0.0f;
+            float scale = 1.0f / resolution;
+            for (int i = 0; i < resolution; ++i)
+            {
+                sum += curve.evaluateSpline(scale * i).x;
+            }
+            gSink = sum;
+        }));
+
+        results.push_back(measure("spline.arcLengthTable" + suffix,
+            resolution, samples, [&]
+        {
+            curve.generateArcLengthTable();
+            gSink = curve.getLength();
+        }));
+
+        results.push_back(measure("spline.tableLookUp" + suffix,
+            LookUpsPerSample, samples, [&]
+        {
+            int sum = 0;
+            float step = curve.getLength() / LookUpsPerSample;
+            for (int i = 0; i < LookUpsPerSample; ++i)
+            {
+                sum += curve.tableLookUp(step * i);
+            }
+            gSink = static_cast<float>(sum);
+        }));
+    }
+
+    // Adaptive tessellation for a 720p view from near the rail (where it
+    // needs the most vertices) and from far away.
+    SplineCurve rail(controlPoints, SplineResolutions[0]);
+    atlas::math::Matrix4 projection = glm::perspective(glm::radians(50.0f),
+        1280.0f / 720.0f, 1.0f, 1000000.0f);
+    for (float distance : { 20.0f, 1000.0f })
+    {
+        atlas::math::Matrix4 clip = projection * glm::lookAt(
+            atlas::math::Point(distance, 0.5f * distance, distance),
+            atlas::math::Point(0.0f), atlas::math::Vector(0.0f, 1.0f, 0.0f));
+        std::vector<atlas::math::Point> points;
+        rail.tessellate(clip, 1280.0f, 720.0f, 0.5f, 8, points);
+        results.push_back(measure("spline.tessellate/" +
+            std::to_string(static_cast<int>(distance)),
+            static_cast<long long>(points.size()), samples, [&]
+        {
+            rail.tessellate(clip, 1280.0f, 720.0f, 0.5f, 8, points);
+            gSink = points.back().x;
+        }));
+    }
+
+    return writeResults(output, results) ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include "FlockExportReader.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// Example consumer of the shared-memory flock export: follows the flock at
+// roughly 60 Hz and once a second prints its centroid and mean speed, along
+// with how many frames this reader missed or saw torn.
+int main(int argc, char** argv)
+{
+    using namespace bns;
+
+    char const* name = (argc > 1) ? argv[1] : FlockExportDefaultName;
+
+    FlockExportReader reader;
+    std::uint64_t lastFrame = 0;
+    std::uint64_t lastPublished = 0;
+    unsigned skipped = 0;
+    unsigned torn = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+
+    for (;;)
+    {
+        if (!reader.isOpen() || reader.isWriterClosed())
+        {
+            if (!reader.open(name))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                continue;
+            }
+            std::printf("Reading %s\n", name);
+            lastPublished = reader.getPublishedCount();
+        }
+
+        FlockFrameView view;
+        if (reader.acquireLatest(view) && view.frame != lastFrame)
+        {
+            // Work straight off the shared memory; nothing is copied.
+            double centroid[3] = { 0.0, 0.0, 0.0 };
+            double speed = 0.0;
+            for (std::uint32_t i = 0; i < view.boidCount; ++i)
+            {
+                FlockExportBoid const& boid = view.boids[i];
+                for (int c = 0; c < 3; ++c)
+                {
+                    centroid[c] += boid.position[c];
+                }
+                speed += std::sqrt(boid.velocity[0] * boid.velocity[0] +
+                    boid.velocity[1] * boid.velocity[1] +
+                    boid.velocity[2] * boid.velocity[2]);
+            }
+
+            if (!reader.isValid(view))
+            {
+                torn++;
+                continue;
+            }
+
+            std::uint64_t published = reader.getPublishedCount();
+            if (published > lastPublished + 1)
+            {
+                skipped += static_cast<unsigned>(published - lastPublished - 1);
+            }
+            lastPublished = published;
+            lastFrame = view.frame;
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport < std::chrono::seconds(1))
+            {
+                continue;
+            }
+            lastReport = now;
+
+            double n = (view.boidCount > 0) ? view.boidCount : 1.0;
+            std::printf("frame %llu: %u boids, centroid (%.3f, %.3f, %.3f), "
+                "mean speed %.5f, skipped %u, torn %u\n",
+                static_cast<unsigned long long>(view.frame), view.boidCount,
+                centroid[0] / n, centroid[1] / n, centroid[2] / n, speed / n,
+                skipped, torn);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+}
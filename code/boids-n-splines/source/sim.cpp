@@ -0,0 +1,143 @@
+#include "DomainCoordinator.hpp"
+#include "DomainWorker.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void printUsage()
+    {
+        ERROR_LOG("usage: bns-sim worker <address>\n"
+            "       bns-sim launch <workers> <boids> <steps> [unix|tcp]\n"
+            "       bns-sim connect <boids> <steps> <address>...\n"
+            "addresses are unix:<path> or tcp:<host>:<port>");
+    }
+
+    // Reads a whole decimal argument of at least minimum.
+    bool parseCount(char const* text, int minimum, int& value)
+    {
+        char* end = nullptr;
+        long parsed = std::strtol(text, &end, 10);
+        if (end == text || *end != '\0' || parsed < minimum ||
+            parsed > INT_MAX)
+        {
+            ERROR_LOG_V("expected a whole number of at least %d, got %s",
+                minimum, text);
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+
+    // Steps a distributed run and reports load and timing as it goes.
+    int drive(std::vector<std::string> const& workers, int boids, int steps)
+    {
+        using namespace bns;
+
+        FlockParameters params;
+        params.numBoids = boids;
+        // Keep the starting density of the original 100 boid flock.
+        params.flockRadius *= std::sqrt(boids / 100.0f);
+
+        DomainCoordinator coordinator;
+        if (!coordinator.start(workers, params))
+        {
+            coordinator.stop();
+            return 1;
+        }
+
+        double totalWall = 0.0;
+        for (int s = 0; s < steps; ++s)
+        {
+            DistributedStepStats stats;
+            if (!coordinator.step(stats))
+            {
+                ERROR_LOG_V("Step %d failed", s);
+                coordinator.stop();
+                return 1;
+            }
+            totalWall += stats.wallMilliseconds;
+
+            if (stats.totalBoids != static_cast<std::uint32_t>(boids))
+            {
+                ERROR_LOG_V("Step %d: %u boids owned, expected %d", s,
+                    stats.totalBoids, boids);
+            }
+            if (s % 50 == 0 || s + 1 == steps)
+            {
+                INFO_LOG_V("step %d: owned %u..%u, halo %u, migrated %u, "
+                    "sim %.2f ms, wall %.2f ms", s, stats.minOwned,
+                    stats.maxOwned, stats.haloBoids, stats.migratedBoids,
+                    stats.maxStepMilliseconds, stats.wallMilliseconds);
+            }
+        }
+
+        INFO_LOG_V("%zu workers, %d boids: %.3f ms/step",
+            workers.size(), boids, totalWall / (steps > 0 ? steps : 1));
+        coordinator.stop();
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace bns;
+
+    if (argc >= 3 && std::strcmp(argv[1], "worker") == 0)
+    {
+        Address address;
+        if (!parseAddress(argv[2], address))
+        {
+            printUsage();
+            return 1;
+        }
+        DomainWorker worker;
+        return worker.run(address) ? 0 : 1;
+    }
+
+    if (argc >= 5 && std::strcmp(argv[1], "launch") == 0)
+    {
+        int count, boids, steps;
+        if (!parseCount(argv[2], 1, count) || !parseCount(argv[3], 1, boids) ||
+            !parseCount(argv[4], 0, steps))
+        {
+            printUsage();
+            return 1;
+        }
+        bool useTcp = (argc > 5 && std::strcmp(argv[5], "tcp") == 0);
+
+        std::vector<std::string> addresses;
+        std::vector<int> processes;
+        if (!launchLocalWorkers(argv[0], static_cast<std::size_t>(count),
+            useTcp, 47300, addresses, processes))
+        {
+            return 1;
+        }
+
+        int result = drive(addresses, boids, steps);
+        waitForWorkers(processes);
+        return result;
+    }
+
+    if (argc >= 5 && std::strcmp(argv[1], "connect") == 0)
+    {
+        int boids, steps;
+        if (!parseCount(argv[2], 1, boids) || !parseCount(argv[3], 0, steps))
+        {
+            printUsage();
+            return 1;
+        }
+        std::vector<std::string> addresses(argv + 4, argv + argc);
+        return drive(addresses, boids, steps);
+    }
+
+    printUsage();
+    return 1;
+}
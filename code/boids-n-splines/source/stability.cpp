@@ -0,0 +1,217 @@
+#include "FlockSimulation.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    using namespace bns;
+
+    // Step lengths tried, in ticks of the original 60 Hz step.
+    constexpr float StepTicks[] = { 1.0f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f,
+        12.0f, 15.0f, 20.0f, 30.0f, 60.0f };
+    // The reference every run is held against.
+    constexpr float ReferenceTicks = 0.25f;
+
+    struct Run
+    {
+        // Mean boid speed at the end of every second of flock time.
+        std::vector<float> meanSpeeds;
+        double milliseconds;
+    };
+
+    Run simulate(FlockParameters params, IntegratorType integrator,
+        float ticks, float seconds)
+    {
+        params.integrator = integrator;
+        params.timeStep = ticks / 60.0f;
+        FlockSimulation simulation(params);
+
+        Run run{ {}, 0.0 };
+        int stepsPerSample = std::max(static_cast<int>(
+            std::lround(60.0f / ticks)), 1);
+        int steps = static_cast<int>(std::lround(seconds * 60.0f / ticks));
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 1; s <= steps; ++s)
+        {
+            simulation.step();
+            if (s % stepsPerSample != 0)
+            {
+                continue;
+            }
+
+            double sum = 0.0;
+            for (auto const& boid : simulation.getBoids())
+            {
+                sum += glm::length(boid.mVelocity);
+            }
+            run.meanSpeeds.push_back(static_cast<float>(
+                sum / simulation.getBoids().size()));
+        }
+        run.milliseconds = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        return run;
+    }
+
+    // Largest relative deviation of the mean speed from the reference. The
+    // flock is chaotic, so individual boids soon part ways with their
+    // reference selves; the speed of the flock as a whole does not, until
+    // the integrator starts adding or draining energy.
+    float measureError(Run const& run, Run const& reference)
+    {
+        float error = 0.0f;
+        std::size_t count = std::min(run.meanSpeeds.size(),
+            reference.meanSpeeds.size());
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float speed = run.meanSpeeds[i];
+            if (!std::isfinite(speed))
+            {
+                return INFINITY;
+            }
+            error = std::max(error, std::fabs(speed -
+                reference.meanSpeeds[i]) / reference.meanSpeeds[i]);
+        }
+        return error;
+    }
+
+    // Boids flying at ghosts (another domain's boids, standing still) must
+    // stop short of them with swept collisions on. Each boid has a ghost of
+    // its own ahead of it, and covers more than the gap in one step, so a
+    // sweep that starts from the wrong place lets it through. Returns how
+    // many steps ended with a boid inside or past its ghost.
+    int checkGhostCollisions(IntegratorType integrator)
+    {
+        constexpr int Pairs = 8;
+        constexpr int Steps = 20;
+        constexpr float Ticks = 4.0f;
+
+        FlockParameters params;
+        params.numBoids = Pairs;
+        params.integrator = integrator;
+        params.timeStep = Ticks / 60.0f;
+        params.continuousCollision = true;
+        params.reorderInterval = 0;
+        FlockSimulation simulation(params);
+
+        std::vector<Boid> boids;
+        std::vector<Boid> ghosts;
+        for (int i = 0; i < Pairs; ++i)
+        {
+            float lane = 6.0f * i;
+            boids.emplace_back(atlas::math::Vector(0.0f, lane, 0.0f),
+                atlas::math::Vector(0.6f + 0.1f * i, 0.0f, 0.0f),
+                params.boidRadius, 0, i);
+            ghosts.emplace_back(atlas::math::Vector(2.0f + 0.2f * i, lane,
+                0.0f), atlas::math::Vector(0.0f), params.boidRadius, 0,
+                Pairs + i);
+        }
+        simulation.setBoids(boids);
+        simulation.setGhosts(ghosts);
+
+        int failures = 0;
+        for (int s = 0; s < Steps; ++s)
+        {
+            std::vector<Boid> before = simulation.getBoids();
+            simulation.step();
+            std::vector<Boid> const& after = simulation.getBoids();
+            for (int i = 0; i < Pairs; ++i)
+            {
+                Boid const& ghost = ghosts[i];
+                float contact = after[i].mRadius + ghost.mRadius;
+                bool wasAhead = before[i].mPosition.x < ghost.mPosition.x;
+                bool isAhead = after[i].mPosition.x < ghost.mPosition.x;
+                float start = glm::length(before[i].mPosition -
+                    ghost.mPosition);
+                float end = glm::length(after[i].mPosition - ghost.mPosition);
+                if (start >= contact &&
+                    (end < contact * 0.95f || wasAhead != isAhead))
+                {
+                    failures++;
+                }
+            }
+        }
+        return failures;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // A packed flock, so separation and cohesion are strong from the start.
+    FlockParameters params;
+    params.numBoids = (argc > 1) ? std::atoi(argv[1]) : 200;
+    params.flockRadius = 2.0f;
+    float seconds = (argc > 2) ? static_cast<float>(std::atof(argv[2])) : 10.0f;
+    float tolerance = (argc > 3) ?
+        static_cast<float>(std::atof(argv[3])) : 0.25f;
+    if (params.numBoids < 1 || seconds < 1.0f || tolerance <= 0.0f)
+    {
+        ERROR_LOG("usage: bns-stability [boids] [seconds] [tolerance]");
+        return 1;
+    }
+
+    IntegratorType const integrators[] = { IntegratorType::SemiImplicitEuler,
+        IntegratorType::VelocityVerlet, IntegratorType::RungeKutta4 };
+
+    INFO_LOG_V("%d boids over %g s; stable while the mean speed stays within "
+        "%g%% of RK4 at %g ticks", params.numBoids, seconds,
+        tolerance * 100.0f, ReferenceTicks);
+    Run reference = simulate(params, IntegratorType::RungeKutta4,
+        ReferenceTicks, seconds);
+
+    for (IntegratorType integrator : integrators)
+    {
+        // The largest step before the first one to drift too far.
+        float stable = 0.0f;
+        double stableMilliseconds = 0.0;
+        for (float ticks : StepTicks)
+        {
+            Run run = simulate(params, integrator, ticks, seconds);
+            float error = measureError(run, reference);
+            INFO_LOG_V("%-20s dt %5.3f s: error %7.3f, %8.2f ms per "
+                "simulated second", getIntegratorName(integrator),
+                ticks / 60.0f, error, run.milliseconds / seconds);
+            if (error > tolerance)
+            {
+                break;
+            }
+            stable = ticks;
+            stableMilliseconds = run.milliseconds / seconds;
+        }
+
+        if (stable > 0.0f)
+        {
+            INFO_LOG_V("%-20s largest stable dt %.3f s (%g Hz), %.2f ms per "
+                "simulated second", getIntegratorName(integrator),
+                stable / 60.0f, 60.0f / stable, stableMilliseconds);
+        }
+        else
+        {
+            INFO_LOG_V("%-20s unstable even at dt %.3f s",
+                getIntegratorName(integrator), StepTicks[0] / 60.0f);
+        }
+    }
+
+    int failures = 0;
+    for (IntegratorType integrator : integrators)
+    {
+        int hits = checkGhostCollisions(integrator);
+        if (hits > 0)
+        {
+            ERROR_LOG_V("%-20s %d boids went through a ghost with swept "
+                "collisions on", getIntegratorName(integrator), hits);
+            failures++;
+        }
+    }
+    if (failures == 0)
+    {
+        INFO_LOG("Swept collisions stop boids at ghosts with every "
+            "integrator");
+    }
+    return (failures == 0) ? 0 : 1;
+}
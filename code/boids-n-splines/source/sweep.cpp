@@ -0,0 +1,35 @@
+#include "ParameterSweep.hpp"
+
+#include <atlas/core/Log.hpp>
+
+#include <cstdlib>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+    using namespace bns;
+
+    if (argc < 3)
+    {
+        ERROR_LOG("usage: bns-sweep <specification> <results.csv> [threads]");
+        return 1;
+    }
+
+    unsigned threads = std::thread::hardware_concurrency();
+    if (argc > 3)
+    {
+        threads = static_cast<unsigned>(std::atoi(argv[3]));
+    }
+
+    ParameterSweep sweep;
+    if (!sweep.loadSpecification(argv[1]))
+    {
+        return 1;
+    }
+
+    INFO_LOG_V("Running %u configurations on %u threads",
+        static_cast<unsigned>(sweep.getRunCount()), threads);
+    sweep.run(threads);
+
+    return sweep.writeResults(argv[2]) ? 0 : 1;
+}